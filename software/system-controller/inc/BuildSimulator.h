@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Cube.h"
+#include "CubeTask.h"
+#include "MotionModel.h"
+#include "VerificationPolicy.h"
+#include "ClearancePlanner.h"
+#include <QList>
+#include <QVector>
+#include <vector>
+
+/*!
+* Estimated duration of the placement of a cube in milliseconds.
+*/
+struct CubeBuildTime
+{
+	Cube* destinationCube = Q_NULLPTR; /*! Cube in the build model destination position */
+	int layer = 0; /*! Layer of the cube in the structure, starting from zero */
+	CubeTaskTiming task; /*! Duration of each phase of the cube task */
+	double verify = 0; /*! Vision phase after the cube is placed, including the move to the capture position */
+
+	/*!
+	* Get the duration of the placement of the cube.
+	*
+	* \return Duration of the cube task and the vision phase after it in milliseconds.
+	*/
+	double getDuration() const
+	{
+		return task.getDuration() + verify;
+	}
+};
+
+/*!
+* Estimated duration of a construction.
+*/
+struct BuildEstimate
+{
+	double vision = 0; /*! Vision phase before the first cube task, including the move to the vision position */
+	double total = 0; /*! Duration of the construction in milliseconds */
+	std::vector<CubeBuildTime> cubes; /*! Duration of the placement of each cube in the order of the cube tasks */
+};
+
+/*!
+* Simulates a construction before it is executed to predict its duration and where the time is spent. The simulator
+* replays the steps of each cube task and the computer vision phases between them against the kinematic model of the
+* robot, in the same order as the construction process:
+*
+* - The robot travels to the vision position and the full scene is processed before the first cube task.
+* - After each cube is placed, the verification policy decides if the robot raises the end-effector to verify the
+*   placement. The construction is assumed to be nominal so only the sampled placements are verified.
+* - The robot returns to the vision position and the full scene is processed after the last cube is placed.
+*
+* If a clearance planner is given, the obstacles of the planner are updated before each cube task as they are during
+* the construction, with the source cube of each task removed and the placed cubes added at their destinations.
+*
+* The cube tasks must have their source cubes assigned. The duration of image capture and processing is not modelled
+* by the kinematic model and is set from measurements of the computer vision system. A simulation takes well under a
+* millisecond per cube task, so it can be used to compare many candidate plans.
+*/
+class BuildSimulator
+{
+public:
+	/*!
+	* Class constructor.
+	*/
+	BuildSimulator();
+
+	/*!
+	* Set the kinematic model of the robot.
+	*
+	* \param [in] motionModel Kinematic model of the robot.
+	*/
+	void setMotionModel(const MotionModel& motionModel);
+
+	/*!
+	* Set the position of the robot at which the full scene is processed.
+	*
+	* \param [in] position Vision position of the robot.
+	*/
+	void setVisionPosition(const RobotPosition& position);
+
+	/*!
+	* Set the maximum number of placements on the bottom layer between placement verifications.
+	*
+	* \param [in] interval Sampling interval in placements.
+	*/
+	void setVerificationInterval(int interval);
+
+	/*!
+	* Set the durations of image capture and processing.
+	*
+	* \param [in] sceneTime Duration in milliseconds to capture and process the full scene.
+	* \param [in] verifyTime Duration in milliseconds to capture an image and verify a placement.
+	*/
+	void setVisionTimes(double sceneTime, double verifyTime);
+
+	/*!
+	* Simulate the construction of a sequence of cube tasks.
+	*
+	* \param [in] tasks Cube tasks in the order they are performed. Tasks without a source cube are skipped.
+	* \param [in] start Position of the robot when the construction is started.
+	* \param [in] clearancePlanner Clearance planner of the cube tasks. The obstacles of the planner are replaced by
+	* the simulation. Null if the obstacles are not updated.
+	* \param [in] cubes Cubes in the workspace when the construction is started in the OpenGL coordinate system.
+	* \return Estimated duration of the construction.
+	*/
+	BuildEstimate simulate(const QList<CubeTask*>& tasks, const RobotPosition& start,
+		ClearancePlanner* clearancePlanner = Q_NULLPTR, const QVector<Cube*>& cubes = QVector<Cube*>()) const;
+
+private:
+	MotionModel motionModel; /*! Kinematic model of the robot */
+	RobotPosition visionPosition; /*! Position of the robot at which the full scene is processed */
+	int verificationInterval = 5; /*! Maximum number of placements on the bottom layer between placement verifications */
+	double sceneTime = 1000; /*! Duration in milliseconds to capture and process the full scene */
+	double verifyTime = 250; /*! Duration in milliseconds to capture an image and verify a placement */
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Cube.h"
+#include "MotionModel.h"
+#include <QList>
+#include <QVector>
+#include <vector>
+
+/*!
+* Plans the moves of the robot between two positions so that the end-effector, and the cube it carries, clear the
+* cubes in the workspace. The planner keeps an occupancy map of the height of the cubes of the structure and the
+* source magazine over the robot workspace.
+*
+* The robot leaves the start position and arrives at the end position vertically, since the cubes next to a picked
+* or placed cube are level with it. Between these vertical moves the robot traverses at the minimum height that clears
+* the occupancy map along the traverse. The lift and traverse moves, the traverse and descent moves, or all three, are
+* merged into a single move when the trajectory of the merged move clears the occupancy map. The motors of a move run
+* independently, so trajectories are sampled with the kinematic model of the robot rather than assumed to be straight.
+*
+* The occupancy map is dilated by the footprint of the carried cube so that the clearance at a position is a single
+* lookup.
+*/
+class ClearancePlanner
+{
+public:
+	/*!
+	* Class constructor.
+	*/
+	ClearancePlanner();
+
+	/*!
+	* Set the kinematic model used to sample the trajectories of the robot.
+	*
+	* \param [in] motionModel Kinematic model of the robot.
+	*/
+	void setMotionModel(const MotionModel& motionModel);
+
+	/*!
+	* Build the occupancy map from the cubes in the workspace.
+	*
+	* \param [in] cubes Cubes in the workspace in the OpenGL coordinate system without the structure offset.
+	*/
+	void setObstacles(const QVector<Cube*>& cubes);
+
+	/*!
+	* Get the minimum height of the end-effector at a position that clears the cubes in the workspace.
+	*
+	* \param [in] x X-axis position in steps.
+	* \param [in] y Y-axis position in steps.
+	* \param [in] carrying True if the end-effector carries a cube.
+	* \return Minimum z-axis position in steps.
+	*/
+	int getClearanceHeight(int x, int y, bool carrying) const;
+
+	/*!
+	* Get the minimum height at which the end-effector can traverse between two positions without moving vertically.
+	*
+	* \param [in] start Start position.
+	* \param [in] end End position.
+	* \param [in] carrying True if the end-effector carries a cube.
+	* \return Minimum z-axis position in steps.
+	*/
+	int getTraverseHeight(const RobotPosition& start, const RobotPosition& end, bool carrying) const;
+
+	/*!
+	* Check if the trajectory of a move clears the cubes in the workspace.
+	*
+	* \param [in] start Start position of the move.
+	* \param [in] end End position of the move.
+	* \param [in] carrying True if the end-effector carries a cube.
+	* \return True if the end-effector is above the clearance height at every sample of the trajectory.
+	*/
+	bool isMoveClear(const RobotPosition& start, const RobotPosition& end, bool carrying) const;
+
+	/*!
+	* Plan the quickest sequence of moves from a start position to an end position that clears the cubes in the workspace.
+	*
+	* \param [in] start Start position.
+	* \param [in] end End position.
+	* \param [in] carrying True if the end-effector carries a cube.
+	* \return Target positions of the moves. The last position is the end position.
+	*/
+	QList<RobotPosition> planTransfer(const RobotPosition& start, const RobotPosition& end, bool carrying) const;
+
+private:
+	MotionModel motionModel; /*! Kinematic model of the robot */
+	std::vector<int> heights; /*! Height of the dilated occupancy map in vertical steps in row major order */
+	int cellLength = 8; /*! Length of an occupancy map cell in steps */
+	int mapMinX = -128; /*! Minimum x-axis position of the occupancy map in steps */
+	int mapMinY = -128; /*! Minimum y-axis position of the occupancy map in steps */
+	int mapCols = 160; /*! Number of occupancy map columns */
+	int mapRows = 176; /*! Number of occupancy map rows */
+	int cubeLengthHSteps = 64; /*! Length of the cube edge in horizontal steps */
+	int cubeLengthVSteps = 318; /*! Length of the cube edge in vertical steps */
+	int clearanceMargin = 100; /*! Margin in vertical steps between the end-effector or carried cube and the cubes below */
+	int dilationRadius = 100; /*! Distance in steps by which the cubes are dilated to cover the carried cube footprint and the sampling */
+	double sampleInterval = 20; /*! Time between trajectory samples in milliseconds */
+
+	/*!
+	* Get the height of the dilated occupancy map at a position.
+	*
+	* \param [in] x X-axis position in steps.
+	* \param [in] y Y-axis position in steps.
+	* \return Height in vertical steps. Zero outside the occupancy map.
+	*/
+	int getMapHeight(int x, int y) const;
+
+	/*!
+	* Estimate the duration of a sequence of moves.
+	*
+	* \param [in] start Start position.
+	* \param [in] path Target positions of the moves.
+	* \return Estimated duration in milliseconds.
+	*/
+	double getPathDuration(const RobotPosition& start, const QList<RobotPosition>& path) const;
+};
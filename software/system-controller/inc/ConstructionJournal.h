@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CubeTask.h"
+#include "Logger.h"
+#include <QObject>
+#include <QList>
+#include <QJsonObject>
+#include <QString>
+
+/*!
+* State of a construction in progress at the time a checkpoint is written. Cubes are stored in the JSON format of
+* \class Cube.
+*/
+struct ConstructionCheckpoint
+{
+	QJsonObject buildModel; /*! Model of the structure in the JSON format of \class CubeWorldModel */
+	StructurePlacement placement; /*! Placement of the build model in the robot workspace */
+	QList<int> taskCubeIds; /*! Build model identifiers of the destination cubes of the incomplete cube tasks in order */
+	QList<QJsonObject> sourceCubes; /*! Source cubes available to the incomplete cube tasks */
+	QList<QJsonObject> structCubes; /*! Cubes placed in the structure */
+	QList<int> structCubeIds; /*! Build model identifiers of the destinations of the structure cubes. Negative if unknown */
+	QJsonObject taskSourceCube; /*! Source cube of the first incomplete cube task if it is not a source cube. Empty otherwise */
+	bool taskStarted = false; /*! Indicates if the first incomplete cube task was started */
+	bool taskReleased = false; /*! Indicates if the cube of the first incomplete cube task was released at its destination */
+	int missingCubes = 0; /*! Number of cubes to be found by the computer vision system */
+	int externalCubes = 0; /*! Number of independent cubes expected in the workspace */
+};
+
+/*!
+* Progress of the first incomplete cube task recorded in the construction journal after a checkpoint.
+*/
+enum class TaskProgress
+{
+	STARTED, /*! The task was started and its source cube left the source cubes */
+	RELEASED, /*! The cube of the task was released at its destination */
+	PLACED /*! The task is complete and its cube was placed in the structure */
+};
+
+/*!
+* Journals the state of a construction in progress to disk so that the construction can be resumed after the system
+* controller is restarted. The journal is a JSON checkpoint of the full construction state followed by one JSON record
+* per line for each step of progress of the cube tasks, so the build model is only written when the construction is
+* started or replanned rather than after every robot command.
+*
+* A checkpoint replaces the journal file. It is written to a temporary file which replaces the journal file once it is
+* complete, so the journal holds either the previous or the new checkpoint if the controller stops while a checkpoint
+* is written. A record is appended to the journal file and flushed. A record which was only partially written when the
+* controller stopped is ignored when the journal is read.
+*/
+class ConstructionJournal : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	ConstructionJournal(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the path of the journal file.
+	*
+	* \param [in] fileName Path of the journal file.
+	*/
+	void setFileName(const QString& fileName);
+
+	/*!
+	* Check if the journal holds a checkpoint of an incomplete construction.
+	*
+	* \return True if the journal file exists. False otherwise.
+	*/
+	bool exists() const;
+
+	/*!
+	* Write a checkpoint to the journal, replacing the previous checkpoint.
+	*
+	* \param [in] checkpoint State of the construction.
+	* \return True if the checkpoint was written. False otherwise.
+	*/
+	bool write(const ConstructionCheckpoint& checkpoint);
+
+	/*!
+	* Append a record of the progress of the first incomplete cube task to the journal.
+	*
+	* \param [in] progress Progress of the cube task.
+	* \param [in] cube Source cube of the task if it was started or the placed cube if it is complete in the JSON format
+	* of \class Cube. Empty if the cube was released.
+	* \return True if the record was appended. False otherwise.
+	*/
+	bool append(TaskProgress progress, const QJsonObject& cube = QJsonObject());
+
+	/*!
+	* Read the checkpoint from the journal and apply the recorded progress of the cube tasks to it.
+	*
+	* \param [out] checkpoint State of the construction.
+	* \return True if a valid checkpoint was read. False otherwise.
+	*/
+	bool read(ConstructionCheckpoint& checkpoint);
+
+	/*!
+	* Remove the journal file once the construction is complete.
+	*/
+	void clear();
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class ConstructionJournal instance.
+	*/
+	void log(Message message) const;
+
+private:
+	QString fileName = "construction.journal"; /*! Path of the journal file */
+	bool writeFailed = false; /*! Indicates if the previous checkpoint failed to be written so the failure is logged once */
+	const int JOURNAL_VERSION = 1; /*! Version of the journal file format */
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Cube.h"
+#include "CubeWorldModel.h"
+#include "Logger.h"
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <functional>
+#include <vector>
+
+/*!
+* Cost of placing a cube directly after the previously placed cube. The previous cube is null for the first cube.
+*/
+typedef std::function<double(const Cube* cube, const Cube* previousCube)> PlacementCost;
+
+/*!
+* Plans the order in which the cubes of a model are placed. The planner builds a directed acyclic graph of the
+* constraints between the cubes of the model:
+*
+* - A cube must be placed after every cube in the layer below that supports it.
+* - A cube must be placed after each neighbouring cube in the same layer that precedes it in the build direction, so
+*   that the end-effector never has to reach past a placed cube in the same layer.
+*
+* A build order is a topological order of the graph. Among the cubes whose constraints are satisfied, the cube with
+* the lowest placement cost is placed next. The default cost places cubes layer by layer, then in order of decreasing
+* z, then increasing x, which matches the order the structure was previously built in.
+*
+* The graph is built with a spatial grid so that planning scales to models with thousands of cubes.
+*/
+class ConstructionPlanner : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	ConstructionPlanner(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the cost used to choose the next cube among the cubes whose constraints are satisfied.
+	*
+	* \param [in] cost Placement cost. The default cost is used if the cost is empty.
+	*/
+	void setCostFunction(const PlacementCost& cost);
+
+	/*!
+	* Build the constraint graph of a model and plan its build order.
+	*
+	* \param [in] model Model of the structure to build.
+	* \return True if a build order was found. False if a cube is not in a valid layer or the constraints are cyclic.
+	*/
+	bool plan(const CubeWorldModel* model);
+
+	/*!
+	* Plan the build order again with the current cost function without rebuilding the constraint graph.
+	*
+	* \return True if a build order was found. False if the constraints are cyclic.
+	*/
+	bool replan();
+
+	/*!
+	* Getter for the planned build order.
+	*
+	* \return Cubes in the order they are placed.
+	*/
+	QList<Cube*> getBuildOrder() const;
+
+	/*!
+	* Getter for the cubes that must be placed before a cube.
+	*
+	* \param [in] cube Cube of the planned model.
+	* \return Cubes that directly support or precede the cube.
+	*/
+	QList<Cube*> getPrerequisites(const Cube* cube) const;
+
+	/*!
+	* Check if an order of the cubes of the planned model satisfies every constraint.
+	*
+	* \param [in] order Cubes in the order they are placed.
+	* \return True if every cube is placed once and after its prerequisites. False otherwise.
+	*/
+	bool isValidOrder(const QList<Cube*>& order) const;
+
+	/*!
+	* Default placement cost. Cubes are placed layer by layer, then in order of decreasing z, then increasing x.
+	*
+	* \param [in] cube Candidate cube.
+	* \param [in] previousCube Previously placed cube. Not used.
+	* \return Placement cost.
+	*/
+	static double defaultCost(const Cube* cube, const Cube* previousCube);
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class ConstructionPlanner instance.
+	*/
+	void log(Message message) const;
+
+private:
+	/*!
+	* Node of the constraint graph.
+	*/
+	struct CubeNode
+	{
+		Cube* cube; /*! Cube of the model */
+		int layer; /*! Layer of the cube */
+		std::vector<int> successors; /*! Nodes that must be placed after the cube */
+		std::vector<int> predecessors; /*! Nodes that must be placed before the cube */
+	};
+
+	std::vector<CubeNode> nodes; /*! Constraint graph nodes */
+	QMap<const Cube*, int> nodeIndices; /*! Node index of each cube */
+	QList<Cube*> buildOrder; /*! Planned build order */
+	PlacementCost cost; /*! Cost used to choose the next cube */
+
+	/*!
+	* Build the constraint graph of the cubes of a model.
+	*
+	* \param [in] model Model of the structure to build.
+	* \return True if the graph was built. False if a cube is not in a valid layer.
+	*/
+	bool buildGraph(const CubeWorldModel* model);
+
+	/*!
+	* Check if a cube precedes a neighbouring cube in the same layer in the build direction.
+	*
+	* \param [in] a First cube.
+	* \param [in] b Second cube.
+	* \return True if the first cube is placed before the second cube.
+	*/
+	static bool precedes(const Cube* a, const Cube* b);
+};
@@ -7,16 +7,44 @@
 #include "CubeTask.h"
 #include "opencv2/opencv.hpp"
 #include "Vision.h"
+#include "MultiCameraVision.h"
+#include "SessionRecorder.h"
+#include "FrameGrabber.h"
+#include "WorkspaceMonitor.h"
+#include "ConstructionPlanner.h"
+#include "TaskSequencer.h"
+#include "SourceAssigner.h"
+#include "ClearancePlanner.h"
+#include "RotationPlanner.h"
+#include "VerificationPolicy.h"
+#include "BuildSimulator.h"
+#include "ConstructionJournal.h"
+#include "RecoveryPlanner.h"
+#include "LayoutPlanner.h"
 #include <QWidget>
 #include <qstackedlayout.h>
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QLabel>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
 #include <QTimer>
 #include <QList>
+#include <QMap>
+#include <QVector>
 #include <QRadioButton>
 #include <QButtonGroup>
+#include <future>
+
+/*!
+* Outcome of planning the structure placement and source magazine layout off the GUI thread.
+*/
+struct LayoutPlanning
+{
+    bool planned = false; /*! Indicates if the model fits in the robot workspace with the magazine */
+    LayoutPlan plan; /*! Placement and magazine layout with the shortest estimated construction */
+    double currentDuration = -1; /*! Estimated duration of the construction with the current layout in milliseconds. Negative if it cannot be estimated */
+};
 
 class ConstructionView : public QWidget
 {
@@ -49,6 +77,12 @@ public:
     */
     void setCamera(cv::VideoCapture* camera);
 
+    /*!
+    * Add an additional camera to the computer vision system. The scenes captured by all cameras are processed and the
+    * detected cubes are fused. The camera feed only displays the system camera.
+    */
+    void addCamera(cv::VideoCapture* camera);
+
 signals:
     /*!
     * Generated when a message is logged by an \class ConstructionView instance.
@@ -70,7 +104,20 @@ private:
     QPushButton* showModelView; /*! Show detailed model view */
     QPushButton* loadModel; /*! Load model to be constructed into the cube world model from JSON file */
     QPushButton* execute; /*! Initiate construction of cube world model */
+    QPushButton* estimateBuild; /*! Plan the construction of cube world model and log its estimated duration */
+    QPushButton* planLayout; /*! Plan the placement of the structure and the layout of the source magazine for the cube world model */
+    QPushButton* resumeConstruction; /*! Resume the construction recorded in the construction journal */
+    QPushButton* recordSession; /*! Toggle recording of the scenes processed by the computer vision system to a session file */
     QList<CubeTask*> cubeTasks; /*! List of cube tasks to be completed for the current construction task */
+    QMap<Cube*, Cube*> placedDestinations; /*! Build model destination cube of each cube placed in the structure */
+    StructurePlacement structurePlacement; /*! Placement of the build model in the robot workspace */
+    QVector<Cube*> monitoredCubes; /*! Cubes monitored for disturbances. Null entries are not monitored */
+    CubePose placementPose; /*! Expected pose of the most recently placed cube */
+    int poseRetries = 0; /*! Number of times the scene was processed again for a detected cube pose with a large residual */
+    bool workspaceDisturbed = false; /*! Indicates if a cube was disturbed since the workspace was last processed */
+    bool sourceAssignmentStale = false; /*! Indicates if the source cubes must be assigned again before the next cube task */
+    bool journaledTaskStarted = false; /*! Indicates if the start of the first cube task is recorded in the construction journal */
+    bool journaledTaskReleased = false; /*! Indicates if the release of the cube of the first cube task is recorded in the construction journal */
 
     OpenGLView* shapeView; /*! OpenGL render of 3D shape to be constructed */
     CubeWorldModel* cubeBuildModel; /*! Model of cubes for the shape to be built in world frame */
@@ -107,6 +154,8 @@ private:
     QSpinBox* zPosition;
     QSpinBox* rPosition;
     QLabel* pressureLabel; /*! Display for internal robot vacuum pressure reading */
+    QLabel* verificationIntervalLabel; /*! Label for the placement verification sampling interval control */
+    QSpinBox* verificationInterval; /*! Maximum number of placements on the bottom layer between placement verifications */
 
     // Vision layout widgets
     QWidget* visionWidget; /*! Widget for vision layout */
@@ -129,6 +178,15 @@ private:
     QSpinBox* worldPointYPos; /*! Y coordinate of world point to project to image frame */
     QSpinBox* worldPointZPos; /*! Z coordinate of world point to project to image frame */
     QPushButton* projectWorldPoint; /*! Project specified world point to the image frame */
+    QCheckBox* visionAdaptiveThreshold; /*! Compute the threshold stage intensity automatically for each region of the image */
+    QLabel* visionThresholdLabel; /*! Label for the threshold stage intensity control */
+    QSpinBox* visionThresholdValue; /*! Intensity threshold of the threshold stage */
+    QLabel* visionBlurLabel; /*! Label for the blur stage kernel size control */
+    QSpinBox* visionBlurSize; /*! Kernel size of the blur stage. Blurring is disabled if zero */
+    QLabel* visionAreaLabel; /*! Label for the contour area threshold control */
+    QDoubleSpinBox* visionAreaThreshold; /*! Minimum contour area in pixels of a fiducial or cube candidate */
+    QLabel* visionCellLabel; /*! Label for the fiducial cell threshold control */
+    QDoubleSpinBox* visionCellThreshold; /*! Minimum proportion of a fiducial cell of one intensity required to classify the cell */
     QLabel* visionImage; /*! Display computer vision images */
 
     // Model layout widgets
@@ -141,9 +199,35 @@ private:
     QRadioButton* showWorldModel; /*! Select the model of cubes in world during construction as input the the 3D display */
     OpenGLView* modelView; /*! OpenGL render of 3D shape or construction process */
     Vision vision;
+    MultiCameraVision* multiCameraVision; /*! Computer vision system fusing the scenes captured by all cameras */
+    SessionRecorder* sessionRecorder; /*! Recorder for the scenes processed by the computer vision system */
+    ConstructionPlanner* constructionPlanner; /*! Planner for the order in which the cubes of the model are placed */
+    TaskSequencer* taskSequencer; /*! Sequencer of the cube tasks which minimises the travel of the robot */
+    SourceAssigner* sourceAssigner; /*! Assigner of the source cubes to the pending cube tasks */
+    ClearancePlanner clearancePlanner; /*! Planner of the robot moves which clear the structure and source cubes */
+    RotationPlanner rotationPlanner; /*! Planner of the end-effector rotations of the cube tasks */
+    WorkspaceMonitor* workspaceMonitor; /*! Monitor for cubes disturbed while the robot performs a cube task */
+    VerificationPolicy verificationPolicy; /*! Policy deciding if a placed cube is verified before the next cube task */
+    BuildSimulator buildSimulator; /*! Simulator estimating the duration of a planned construction */
+    ConstructionJournal* constructionJournal; /*! Journal of the construction state used to resume an interrupted construction */
+    RecoveryPlanner* recoveryPlanner; /*! Planner of the corrective cube tasks after a construction failure */
+    LayoutPlanner* layoutPlanner; /*! Planner of the structure placement and source magazine layout */
+    std::future<LayoutPlanning> layoutPlanning; /*! Layout planning running off the GUI thread. Valid until the planned layout is applied */
 
     // Constant robot parameters
     const cv::Point3i ROBOT_VISION_POS = cv::Point3i(507, 0, 2000); /*! Position of robot to ensure there are no occlusions for the computer vision system */
+    const double END_EFFECTOR_RADIUS = 48; /*! Half width of the end-effector occluder in horizontal steps */
+    const double MAX_POSE_RESIDUAL = 8; /*! Maximum cube pose fit residual in horizontal steps for a detected cube to be picked */
+    const double MAX_REPROJECTION_ERROR = 3; /*! Maximum fiducial reprojection error in pixels for a scene to be used for construction decisions */
+    const double MIN_SHAPE_SCORE = 0.8; /*! Minimum independent cube contour shape score for a scene to be used for construction decisions */
+    const int MAX_RECAPTURES = 3; /*! Maximum number of images captured again for a scene of insufficient quality */
+    const int MAX_POSE_RETRIES = 3; /*! Maximum number of times the scene is processed again for a detected cube pose with a large residual */
+    const double MONITORED_FACE_RADIUS = 20; /*! Half width of the monitored region at the centre of a cube top face in horizontal steps */
+    const double PLACEMENT_POSITION_TOLERANCE = 12; /*! Maximum position error of a placed cube in horizontal steps */
+    const double PLACEMENT_ROTATION_TOLERANCE = 0.09; /*! Maximum rotation error of a placed cube in radians */
+    const double SOURCE_MATCH_DISTANCE = 64; /*! Maximum distance in horizontal steps between a source cube and its observed top face */
+    const double FIDUCIAL_RADIUS = 64; /*! Half width of a fiducial square in horizontal steps */
+    const int CAPTURE_PATH_SAMPLES = 4; /*! Number of segments of the path to the vision position at which a capture is considered */
 
     /*!
     * Captures new image from camera and updates the camera feed.
@@ -195,6 +279,80 @@ private:
     */
     void executeConstruction();
 
+    /*!
+    * Start the construction of the planned cube tasks with a computer vision assessment of the workspace.
+    */
+    void startConstruction();
+
+    /*!
+    * Abandon the construction in progress. The cube tasks are deleted, the pressure sensor readings are stopped, the
+    * robot command state returns to idle and the construction journal is discarded.
+    */
+    void resetConstruction();
+
+    /*!
+    * Write a checkpoint of the state of the construction in progress to the construction journal.
+    */
+    void journalConstruction();
+
+    /*!
+    * Append the progress of the first cube task since it was last journaled to the construction journal. Called once
+    * the robot command which made the progress has completed.
+    *
+    * \param [in] task First incomplete cube task.
+    */
+    void journalTaskProgress(CubeTask* task);
+
+    /*!
+    * Restore the construction state from the construction journal and resume the construction. The computer vision
+    * assessment at the start of the construction reconciles the restored state with the workspace.
+    */
+    void resumeConstructionClicked();
+
+    /*!
+    * Replace the cube tasks with the corrective cube tasks which recover the construction from the processed scene after
+    * a construction failure is detected. The structure cubes with an exposed top face are verified on the system camera
+    * image, and the detected independent cubes are accepted as placed or become source cubes.
+    *
+    * \param [in] images Images of the processed scene.
+    * \param [in] detectedCubes Poses of the independent cubes detected in the scene.
+    * \return True if the construction was recovered. False otherwise.
+    */
+    bool recoverConstruction(const std::vector<cv::Mat>& images, const std::vector<CubePose>& detectedCubes);
+
+    /*!
+    * Generate, sequence and assign the cube tasks to construct the cube world model.
+    *
+    * \return True if the cube tasks were planned. False otherwise.
+    */
+    bool planConstruction();
+
+    /*!
+    * Plan the construction of the cube world model without executing it and log the estimated duration of each cube
+    * task phase.
+    */
+    void estimateBuildClicked();
+
+    /*!
+    * Plan the placement of the structure and the layout of the source magazine which minimise the estimated duration
+    * of the construction of the cube world model. The planned layout replaces the source cubes and is logged so that
+    * the source magazine can be arranged to match it.
+    */
+    void planLayoutClicked();
+
+    /*!
+    * Apply the layout planned off the GUI thread. The planned layout replaces the source cubes if it reduces the
+    * estimated duration of the construction with the current layout.
+    */
+    void layoutPlanned();
+
+    /*!
+    * Enable or disable the controls which change the build model or the source cubes while the layout is planned.
+    *
+    * \param [in] enabled Indicates if the controls are enabled.
+    */
+    void setLayoutControlsEnabled(bool enabled);
+
     /*!
     * Send next command to robot when previous command is complete.
     */
@@ -225,6 +383,84 @@ private:
     */
     void processSceneClicked();
 
+    /*!
+    * Slot to start or stop recording the scenes processed by the computer vision system to a session file.
+    */
+    void recordSessionToggled(bool checked);
+
+    /*!
+    * Process the scenes captured by the cameras with the computer vision system and record the scene inputs of the system
+    * camera if a session is being recorded.
+    */
+    void processVisionScene(const std::vector<cv::Mat>& images, bool calibrate, std::vector<cv::Point3i>* sourceCentroids = Q_NULLPTR,
+        std::vector<cv::Point3i>* structCentroids = Q_NULLPTR);
+
+    /*!
+    * Verify the placement of the most recently placed cube on a small region of the system camera image. The full scene
+    * is processed if the placement could not be verified.
+    */
+    void handleConstructVerifyState();
+
+    /*!
+    * Continue monitoring the workspace with the current reference image after a placement which is not verified. The
+    * placed cube and the structure cubes it covers are no longer monitored since they changed in the image.
+    *
+    * \param [in] placedCube Placed cube.
+    */
+    void continueMonitoring(const Cube* placedCube);
+
+    /*!
+    * Monitor the source and structure cubes for disturbances while the robot performs the next cube task.
+    *
+    * \param [in] image Reference image of the workspace captured by the system camera.
+    */
+    void monitorWorkspace(const cv::Mat& image);
+
+    /*!
+    * Check the quality of the most recently processed scene before it is used for construction decisions.
+    *
+    * \param [out] reason Description of the first quality measure that failed.
+    * \return True if the calibration and the independent cube detections are reliable. False otherwise.
+    */
+    bool isSceneAcceptable(QString& reason) const;
+
+    /*!
+    * Slot called when the workspace monitor detects that a monitored cube was disturbed. The construction process reacts
+    * before the next step of the current cube task.
+    */
+    void workspaceDisturbanceDetected(int region);
+
+    /*!
+    * Slot to apply the computer vision parameters selected in the vision view and process the most recent scene again.
+    */
+    void visionParametersChanged();
+
+    /*!
+    * Get the robot position at which the scene is captured in the computer vision phase. The robot does not need to
+    * travel to the dedicated vision position if it does not occlude the workspace floor, the fiducials or the known
+    * cubes, so that a displaced or unexpected cube cannot be hidden by the robot. The current
+    * position, the current position raised to the vision height and points on the way to the vision position are
+    * considered in turn.
+    *
+    * \return Robot position in steps at which the scene is captured.
+    */
+    cv::Point3i getCapturePosition() const;
+
+    /*!
+    * Check if the robot at a position occludes a region of interest in the system camera image.
+    *
+    * \param [in] robotPosition Robot position in steps.
+    * \param [in] regions Convex regions of interest in the image.
+    * \return True if a region of interest is occluded. False otherwise.
+    */
+    bool isCaptureOccluded(const cv::Point3i& robotPosition, const std::vector<std::vector<cv::Point>>& regions) const;
+
+    /*!
+    * Set the image regions occluded by the robot at its current position for the classification of the cubes of the
+    * next scene. No regions are set at the vision position.
+    */
+    void setVisionOccludedRegions();
+
     void sleepRobotClicked();
     void wakeRobotClicked();
     void calibrateRobotClicked();
@@ -3,7 +3,58 @@
 #include "Robot.h"
 #include "Cube.h"
 #include "Logger.h"
+#include "MotionModel.h"
+#include "ClearancePlanner.h"
 #include <QObject>
+#include <QList>
+
+/*!
+* Estimated duration of each phase of a cube task in milliseconds.
+*/
+struct CubeTaskTiming
+{
+	double pick = 0; /*! Moves to grip the source cube */
+	double grip = 0; /*! Gripper actuation and settling delay */
+	double place = 0; /*! Moves to place the cube at its destination */
+	double release = 0; /*! Gripper release and settling delay */
+	double raise = 0; /*! Move from the released cube and gripper reset */
+
+	/*!
+	* Get the duration of the cube task.
+	*
+	* \return Sum of the phase durations in milliseconds.
+	*/
+	double getDuration() const
+	{
+		return pick + grip + place + release + raise;
+	}
+};
+
+/*!
+* Placement of the structure in the robot workspace. The build model is turned about its origin by a number of quarter
+* turns and its origin is then moved to a position in the robot coordinate system. Since a cube is symmetric under
+* quarter turns, the orientation changes the destination positions but not the rotations of the end-effector.
+*/
+struct StructurePlacement
+{
+	int x = 507; /*! X-axis position of the build model origin in steps */
+	int y = 650; /*! Y-axis position of the build model origin in steps */
+	int orientation = 0; /*! Number of counterclockwise quarter turns of the build model about its origin */
+
+	/*!
+	* Convert the horizontal position of a cube in the OpenGL coordinate system to the robot coordinate system.
+	*
+	* \param [in] position Position of the cube in the OpenGL coordinate system.
+	* \return X-axis and y-axis position in steps.
+	*/
+	glm::vec2 getPosition(const glm::vec3& position) const
+	{
+		glm::vec2 turned(position.x, position.z);
+		for (int i = 0; i < ((orientation % 4) + 4) % 4; ++i)
+			turned = glm::vec2(-turned.y, turned.x);
+		return glm::vec2(turned.x + x, turned.y + y);
+	}
+};
 
 /*!
 * A cube task is the collection of constituent robot steps that need to be performed to move a cube from 
@@ -47,6 +98,86 @@ public:
 	*/
 	Cube* getDestinationCube();
 
+	/*!
+	* Set the placement of the structure in the robot workspace. The default placement centres the build model origin
+	* in the workspace.
+	*
+	* \param [in] placement Placement of the build model.
+	*/
+	void setPlacement(const StructurePlacement& placement);
+
+	/*!
+	* Get the position of the top face centroid of the cube at its destination in the robot coordinate system.
+	*
+	* \return Destination top face centroid with the x and y coordinates in steps and the height in horizontal steps.
+	*/
+	glm::vec3 getDestinationTopFace();
+
+	/*!
+	* Get the position of the robot at the top face centroid of the cube at its destination.
+	*
+	* \return Destination position of the robot in steps.
+	*/
+	RobotPosition getDestinationPosition() const;
+
+	/*!
+	* Estimate the duration of the cube task if it were performed with a source cube. The estimate follows the same
+	* steps as \class CubeTask::performNextStep.
+	*
+	* \param [in] motionModel Kinematic model of the robot.
+	* \param [in] start Position of the robot when the task is started.
+	* \param [in] sourceCube Cube in the source position. The source cube of the task is used if not provided.
+	* \param [out] end Position of the robot when the task is complete.
+	* \return Estimated duration of the cube task in milliseconds.
+	*/
+	double estimateDuration(const MotionModel& motionModel, const RobotPosition& start, const Cube* sourceCube = Q_NULLPTR,
+		RobotPosition* end = Q_NULLPTR) const;
+
+	/*!
+	* Estimate the duration of each phase of the cube task if it were performed with a source cube.
+	*
+	* \param [in] motionModel Kinematic model of the robot.
+	* \param [in] start Position of the robot when the task is started.
+	* \param [in] sourceCube Cube in the source position. The source cube of the task is used if not provided.
+	* \param [out] end Position of the robot when the task is complete.
+	* \return Estimated duration of each phase.
+	*/
+	CubeTaskTiming estimateTiming(const MotionModel& motionModel, const RobotPosition& start, const Cube* sourceCube = Q_NULLPTR,
+		RobotPosition* end = Q_NULLPTR) const;
+
+	/*!
+	* Set the preferred rotations of the end-effector when the cube is picked up and placed. Since a cube is symmetric
+	* under quarter turns, the end-effector uses the rotation equivalent to the cube rotation that is closest to the
+	* preferred rotation within the rotation limits of the robot. The preferred rotations are zero by default.
+	*
+	* \param [in] pickRotation Preferred rotation when the cube is picked up in steps.
+	* \param [in] placeRotation Preferred rotation when the cube is placed in steps.
+	*/
+	void setPreferredRotations(int pickRotation, int placeRotation);
+
+	/*!
+	* Get the rotations of the end-effector which can be used to pick up the source cube.
+	*
+	* \return Equivalent rotations in steps. Empty if no source cube has been specified.
+	*/
+	std::vector<int> getPickRotations() const;
+
+	/*!
+	* Get the rotations of the end-effector which can be used to place the cube at its destination.
+	*
+	* \return Equivalent rotations in steps.
+	*/
+	std::vector<int> getPlaceRotations() const;
+
+	/*!
+	* Set the planner used to clear the cubes in the workspace when the robot moves to the source and destination.
+	* Without a planner the robot traverses to the source at its current height and to the destination one cube length
+	* above the destination height.
+	*
+	* \param [in] clearancePlanner Clearance planner. The planner is not owned by the cube task.
+	*/
+	void setClearancePlanner(const ClearancePlanner* clearancePlanner);
+
 	/*!
 	* Indicates if there are any steps remaining to be performed for the cube task.
 	* \return True if the cube task is complete. False otherwise.
@@ -60,6 +191,15 @@ public:
 	*/
 	void performNextStep(Robot* robot);
 
+	/*!
+	* Replan the remaining moves of the transfer in progress from the current position of the robot. The remaining moves
+	* were planned from the previous target position, so they must be replanned if the robot was moved elsewhere while
+	* the task was interrupted, such as to capture an image of the workspace.
+	*
+	* \param [in] robot Robot performing the cube task.
+	*/
+	void replanTransfer(Robot* robot);
+
 	/*!
 	* Indicates if the instruction to complete the first step in the task has been issued.
 	* 
@@ -74,6 +214,13 @@ public:
 	*/
 	bool expectGrippedCube();
 
+	/*!
+	* Indicates if the cube has been released at its destination.
+	*
+	* \return True if the instruction to release the cube has been issued. False otherwise.
+	*/
+	bool isCubeReleased();
+
 	/*!
 	* Reset the cube step counter to the first step.
 	*/
@@ -92,22 +239,45 @@ private:
 	int cubeLengthVSteps = 318; /*! Length of the cube edge in vertical steps */
 	int bufferAction = 200; /*! Number of vertical steps the robot moves below the target z-axis position to ensure a reliable connection */
 
-	// TODO: Review perform step implementation
-	int step = 0;
-	bool taskComplete = false;
-	//int xOffset = 0;
-	//int yOffset = 140;
+	/*!
+	* Convert the position of a cube to the position of the robot at the top face centroid of the cube.
+	* The OpenGL coordinates of the cube are converted to the robot coordinate system.
+	*
+	* \param [in] cube Cube in the OpenGL coordinate system.
+	* \param [in] placement Placement of the cube coordinates in the robot workspace.
+	* \param [in] rotation Preferred rotation of the end-effector in steps.
+	* \return Position of the robot at the top face of the cube.
+	*/
+	RobotPosition getTopFacePosition(const Cube* cube, const StructurePlacement& placement, int rotation) const;
 
-	//int xOffset = 1015;
-	//int yOffset = 140;
+	const ClearancePlanner* clearancePlanner = Q_NULLPTR; /*! Planner of the moves to the source and destination */
+	QList<RobotPosition> transferPath; /*! Remaining target positions of the move to the source or destination in progress */
+	RobotPosition transferWaypoint; /*! Most recent target position of the move to the source or destination in progress */
+	int pickRotation = 0; /*! Preferred rotation of the end-effector when the cube is picked up */
+	int placeRotation = 0; /*! Preferred rotation of the end-effector when the cube is placed */
 
-	//int xOffset = 0;
-	//int yOffset = 1125;
+	/*!
+	* Get the target positions of the moves from a start position to grip the cube at its source.
+	*
+	* \param [in] start Position of the robot.
+	* \param [in] srcPos Position of the robot at the top face of the source cube.
+	* \return Target positions of the moves.
+	*/
+	QList<RobotPosition> getPickPath(const RobotPosition& start, const RobotPosition& srcPos) const;
 
-	//int xOffset = 1015;
-	//int yOffset = 1125;
+	/*!
+	* Get the target positions of the moves from a start position with the cube gripped to release the cube at its destination.
+	*
+	* \param [in] start Position of the robot.
+	* \param [in] destPos Position of the robot at the top face of the destination cube.
+	* \return Target positions of the moves.
+	*/
+	QList<RobotPosition> getPlacePath(const RobotPosition& start, const RobotPosition& destPos) const;
 
-	int xOffset = 507;
-	int yOffset = 650;
+	// TODO: Review perform step implementation
+	int step = 0;
+	bool taskComplete = false;
+	StructurePlacement placement; /*! Placement of the build model in the robot workspace */
+	const StructurePlacement sourcePlacement = { 0, 0, 0 }; /*! Source cubes are in the robot coordinate system */
 };
 
@@ -56,6 +56,12 @@ public:
 	*/
 	void clearCubes();
 
+	/*!
+	* Advance the cube identifier counter past the identifiers of the cubes in the cube world. Must be called after the
+	* identifiers of inserted cubes are restored so that cubes inserted later have unique identifiers.
+	*/
+	void reserveCubeIDs();
+
 	/*!
 	* Update currently selected cube.
 	* \param [in] cube Cube to select.
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+
+/*!
+* Result of decoding the cells of a fiducial.
+*/
+struct FiducialDecoding
+{
+	int id = -1; /*! Fiducial identifier. -1 if the cells could not be decoded */
+	int rotation = 0; /*! Number of clockwise quarter turns of the observed fiducial from its reference orientation */
+	int errors = 0; /*! Number of classified cells corrected to match the codeword */
+	int erasures = 0; /*! Number of cells that could not be classified */
+	double confidence = 0; /*! Decoding confidence in the range [0, 1] where 1 indicates that every cell matched the codeword */
+};
+
+/*!
+* Dictionary of the fiducial patterns placed in the workspace. Each fiducial is a 3x3 grid of binary cells encoded as a
+* 9 bit codeword with the cell in row r and column c at bit 3r + c.
+*
+* The codewords are chosen so that any two codewords, including the rotations of the same codeword, differ in at least
+* three cells. The identity and orientation of a fiducial are therefore decoded together from all nine cells, and a
+* fiducial with a single misclassified cell or two unclassified cells is still decoded correctly.
+*
+* The lookup table of every rotation of every codeword is computed at compile time.
+*/
+class FiducialDictionary
+{
+public:
+	static constexpr int CELL_COUNT = 9; /*! Number of cells in a fiducial */
+	static constexpr int FIDUCIAL_COUNT = 8; /*! Number of fiducials in the dictionary */
+	static constexpr int MIN_DISTANCE = 3; /*! Minimum number of cells in which any two table entries differ */
+	static constexpr int CODEWORDS[FIDUCIAL_COUNT] = { 94, 142, 211, 293, 338, 428, 432, 481 }; /*! Codeword of each fiducial in its reference orientation */
+	static constexpr int IDS[FIDUCIAL_COUNT] = { 10, 0, 50, 11, 3, 41, 6, 37 }; /*! Identifier of each fiducial */
+
+	/*!
+	* Entry in the lookup table of observed codewords.
+	*/
+	struct Entry
+	{
+		int codeword; /*! Codeword of the observed fiducial */
+		int id; /*! Fiducial identifier */
+		int rotation; /*! Number of clockwise quarter turns of the observed fiducial from its reference orientation */
+	};
+
+	/*!
+	* Rotate a codeword a quarter turn clockwise.
+	*
+	* \param [in] codeword Codeword to rotate.
+	* \return Rotated codeword.
+	*/
+	static constexpr int rotateClockwise(int codeword)
+	{
+		// The cell in row r and column c of the rotated grid is the cell in row 2 - c and column r of the grid
+		int rotated = 0;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int col = 0; col < 3; ++col)
+				rotated |= ((codeword >> ((2 - col) * 3 + row)) & 1) << (row * 3 + col);
+		}
+
+		return rotated;
+	}
+
+	/*!
+	* Build the lookup table of every rotation of every codeword.
+	*
+	* \return Lookup table.
+	*/
+	static constexpr std::array<Entry, 4 * FIDUCIAL_COUNT> buildTable()
+	{
+		std::array<Entry, 4 * FIDUCIAL_COUNT> table = {};
+		for (int i = 0; i < FIDUCIAL_COUNT; ++i)
+		{
+			int codeword = CODEWORDS[i];
+			for (int rotation = 0; rotation < 4; ++rotation)
+			{
+				table[4 * i + rotation] = { codeword, IDS[i], rotation };
+				codeword = rotateClockwise(codeword);
+			}
+		}
+
+		return table;
+	}
+
+	static const std::array<Entry, 4 * FIDUCIAL_COUNT> TABLE; /*! Lookup table of observed codewords */
+
+	/*!
+	* Count the cells in which two codewords differ.
+	*
+	* \param [in] a First codeword.
+	* \param [in] b Second codeword.
+	* \return Number of differing cells.
+	*/
+	static constexpr int countCellDifferences(int a, int b)
+	{
+		int count = 0;
+		for (int difference = a ^ b; difference != 0; difference >>= 1)
+			count += difference & 1;
+
+		return count;
+	}
+
+	/*!
+	* Compute the minimum number of cells in which any two entries of the lookup table differ.
+	*
+	* \return Minimum distance between table entries.
+	*/
+	static constexpr int computeMinDistance()
+	{
+		int minDistance = CELL_COUNT;
+		for (int i = 0; i < 4 * FIDUCIAL_COUNT; ++i)
+		{
+			for (int j = i + 1; j < 4 * FIDUCIAL_COUNT; ++j)
+			{
+				int distance = countCellDifferences(TABLE[i].codeword, TABLE[j].codeword);
+				minDistance = distance < minDistance ? distance : minDistance;
+			}
+		}
+
+		return minDistance;
+	}
+
+	/*!
+	* Get the codeword of a fiducial in its reference orientation.
+	*
+	* \param [in] id Fiducial identifier.
+	* \return Codeword of the fiducial. Returns -1 if the fiducial is not in the dictionary.
+	*/
+	static constexpr int getCodeword(int id)
+	{
+		for (int i = 0; i < FIDUCIAL_COUNT; ++i)
+		{
+			if (IDS[i] == id)
+				return CODEWORDS[i];
+		}
+
+		return -1;
+	}
+
+	/*!
+	* Decode the observed cells of a fiducial. Unclassified cells are treated as erasures and ignored when the cells are
+	* compared to the table entries. The closest entry is accepted if twice the number of errors plus the number of
+	* erasures is less than the minimum distance and no other fiducial is equally close.
+	*
+	* \param [in] cells Observed value of each cell in row major order. A value of -1 indicates an unclassified cell.
+	* \return Decoded fiducial.
+	*/
+	static FiducialDecoding decode(const int cells[CELL_COUNT]);
+};
+
+// The lookup table is built once the class is complete so that its constexpr member functions can be evaluated
+inline constexpr std::array<FiducialDictionary::Entry, 4 * FiducialDictionary::FIDUCIAL_COUNT> FiducialDictionary::TABLE = FiducialDictionary::buildTable();
+
+// Verify the minimum distance of the dictionary when it is compiled
+static_assert(FiducialDictionary::computeMinDistance() >= FiducialDictionary::MIN_DISTANCE, "Fiducial codewords are too close to correct a single cell error");
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Logger.h"
+#include "opencv2/opencv.hpp"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <atomic>
+
+/*!
+* Continuously captures frames from a camera on a dedicated thread into a ring buffer of the most recent frames.
+*
+* The frame grabber is the only reader of its camera so that the camera can be shared by the views, the computer vision
+* system and the workspace monitor. It implements the \class cv::VideoCapture interface, where each read waits for a
+* frame captured after the previous read. This preserves the behaviour of reading buffered frames from the camera.
+*
+* Displays refreshed on the user interface thread use \class tryRead, which returns the most recent frame without waiting
+* for the camera.
+*
+* Every captured frame is passed to the \class frameCaptured signal on the capture thread. Slots connected with a direct
+* connection can therefore process frames without blocking the user interface.
+*/
+class FrameGrabber : public QThread, public cv::VideoCapture
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] camera Source of the camera images. The camera is not owned by the frame grabber.
+	* \param [in] capacity Number of frames held in the ring buffer.
+	* \param [in] parent Parent object.
+	*/
+	FrameGrabber(cv::VideoCapture* camera, int capacity = 8, QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Class destructor. Stops the capture thread.
+	*/
+	~FrameGrabber();
+
+	/*!
+	* Stop the capture thread and wait for it to finish.
+	*/
+	void stop();
+
+	/*!
+	* Set the minimum time between frame captures. This limits the capture rate of sources that do not block until a new
+	* frame is available, such as recorded sessions.
+	*
+	* \param [in] interval Minimum time between frame captures in milliseconds.
+	*/
+	void setFrameInterval(int interval);
+
+	/*!
+	* Getter for the most recent frames in the ring buffer.
+	*
+	* \param [in] count Maximum number of frames to return.
+	* \return Most recent frames ordered from newest to oldest.
+	*/
+	std::vector<cv::Mat> getRecentFrames(int count) const;
+
+	/*!
+	* Indicates if the camera is open.
+	*
+	* \return True if the camera is open. False otherwise.
+	*/
+	bool isOpened() const override;
+
+	/*!
+	* Stop the capture thread and release the frames in the ring buffer. The camera itself is not released.
+	*/
+	void release() override;
+
+	/*!
+	* Wait for a frame captured after the previously grabbed frame.
+	*
+	* \return True if a new frame was captured before the timeout. False otherwise.
+	*/
+	bool grab() override;
+
+	/*!
+	* Retrieve the grabbed frame.
+	*
+	* \param [out] image Grabbed frame.
+	* \param [in] flag Unused.
+	* \return True if the grabbed frame is still in the ring buffer. False otherwise.
+	*/
+	bool retrieve(cv::OutputArray image, int flag = 0) override;
+
+	/*!
+	* Grab and retrieve a frame captured after the previously grabbed frame.
+	*
+	* \param [out] image Captured frame.
+	* \return True if a frame was read. False otherwise.
+	*/
+	bool read(cv::OutputArray image) override;
+
+	/*!
+	* Retrieve the most recent frame without waiting for a new frame. The previously grabbed frame is not changed, so
+	* the frames read by the computer vision system are unaffected.
+	*
+	* \param [out] image Most recent frame.
+	* \return True if a frame has been captured. False otherwise.
+	*/
+	bool tryRead(cv::OutputArray image) const;
+
+	/*!
+	* Set a camera property.
+	*
+	* \param [in] propId Property identifier.
+	* \param [in] value Property value.
+	* \return True if the property was set. False otherwise.
+	*/
+	bool set(int propId, double value) override;
+
+	/*!
+	* Get a camera property.
+	*
+	* \param [in] propId Property identifier.
+	* \return Property value.
+	*/
+	double get(int propId) const override;
+
+signals:
+	/*!
+	* Generated on the capture thread when a frame is captured.
+	*
+	* \param [in] frame Captured frame.
+	* \param [in] timestamp Time in milliseconds since the frame grabber started at which the frame was captured.
+	*/
+	void frameCaptured(const cv::Mat& frame, qint64 timestamp) const;
+
+	/*!
+	* Generated when a message is logged by a \class FrameGrabber instance.
+	*/
+	void log(Message message) const;
+
+protected:
+	/*!
+	* Capture loop run on the capture thread.
+	*/
+	void run() override;
+
+private:
+	cv::VideoCapture* camera; /*! Source of the camera images */
+	mutable QMutex cameraMutex; /*! Serializes access to the camera between the capture thread and property access */
+	mutable QMutex frameMutex; /*! Protects the ring buffer */
+	QWaitCondition frameAvailable; /*! Signalled when a frame is added to the ring buffer */
+	std::vector<cv::Mat> frames; /*! Ring buffer of the most recent frames */
+	qint64 frameCount = 0; /*! Number of frames captured. The newest frame has the sequence number frameCount - 1 */
+	qint64 grabbedFrame = -1; /*! Sequence number of the most recently grabbed frame */
+	std::atomic<int> frameInterval { 30 }; /*! Minimum time between frame captures in milliseconds. Written by the GUI thread */
+	QElapsedTimer captureTimer; /*! Time elapsed since the frame grabber started */
+	const int FRAME_TIMEOUT = 1000; /*! Maximum time in milliseconds to wait for a new frame */
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Cube.h"
+#include "CubeTask.h"
+#include "MotionModel.h"
+#include "ClearancePlanner.h"
+#include "ConstructionPlanner.h"
+#include "TaskSequencer.h"
+#include "SourceAssigner.h"
+#include "RotationPlanner.h"
+#include "BuildSimulator.h"
+#include "RobotLimits.h"
+#include "Logger.h"
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <vector>
+
+/*!
+* Layout of the source cubes in the source magazine. The magazine has rows of cube slots along the x-axis at the near
+* edge of the robot workspace. The source cubes fill a block of consecutive rows and slots, starting with the row
+* nearest the structure. Only the last row filled may be incomplete.
+*/
+struct SourceLayout
+{
+	int firstRow = 0; /*! First row of the block counted from the near edge of the workspace */
+	int rows = 0; /*! Number of rows of the block */
+	int firstSlot = 0; /*! First slot of each row of the block */
+	int slotCount = 0; /*! Number of slots in each row of the block */
+	QVector<glm::vec3> positions; /*! Positions of the source cubes in the OpenGL coordinate system */
+};
+
+/*!
+* Placement of the structure and layout of the source magazine for the construction of a model.
+*/
+struct LayoutPlan
+{
+	StructurePlacement placement; /*! Placement of the build model in the robot workspace */
+	SourceLayout sourceLayout; /*! Layout of the source cubes */
+	double duration = 0; /*! Estimated duration of the construction in milliseconds */
+};
+
+/*!
+* Plans the placement of the structure in the robot workspace and the layout of the source magazine to minimise the
+* estimated duration of a construction. A placement is a position of the build model origin and a number of quarter
+* turns of the build model, such that every destination is within the reach of the robot and clear of the magazine.
+*
+* The planner searches in two stages since a full construction plan takes hundreds of milliseconds:
+*
+* - Every placement on a coarse grid is screened with each orientation and magazine layout. The screening cost is the
+*   duration of the optimal assignment of source cubes to destinations, where each pair costs a return trip between
+*   the source and the destination with the kinematic model of the robot. The best placement of each orientation and
+*   magazine layout is refined on a fine grid around it.
+* - The best refined candidates are planned as a construction would be, with the cube tasks sequenced, the source
+*   cubes assigned and the end-effector rotations planned, and the construction is simulated. The candidate with the
+*   shortest simulated construction is chosen.
+*/
+class LayoutPlanner : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	LayoutPlanner(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the kinematic model used to estimate the duration of the construction.
+	*
+	* \param [in] motionModel Kinematic model of the robot.
+	*/
+	void setMotionModel(const MotionModel& motionModel);
+
+	/*!
+	* Set the position of the robot at which the full scene is processed. The construction starts at this position.
+	*
+	* \param [in] position Vision position of the robot.
+	*/
+	void setVisionPosition(const RobotPosition& position);
+
+	/*!
+	* Set the maximum number of placements on the bottom layer between placement verifications.
+	*
+	* \param [in] interval Sampling interval in placements.
+	*/
+	void setVerificationInterval(int interval);
+
+	/*!
+	* Plan the placement of the structure and the layout of the source magazine for the planned model.
+	*
+	* \param [in] planner Construction planner which has planned the build order of the model.
+	* \param [out] plan Placement and magazine layout with the shortest estimated construction.
+	* \return True if the model fits in the robot workspace with the magazine. False otherwise.
+	*/
+	bool plan(const ConstructionPlanner* planner, LayoutPlan& plan);
+
+	/*!
+	* Estimate the duration of the construction of the planned model with a placement and source cubes.
+	*
+	* \param [in] planner Construction planner which has planned the build order of the model.
+	* \param [in] placement Placement of the build model in the robot workspace.
+	* \param [in] sources Source cubes in the OpenGL coordinate system.
+	* \return Estimated duration of the construction in milliseconds. Negative if there are not enough source cubes.
+	*/
+	double estimate(const ConstructionPlanner* planner, const StructurePlacement& placement, const QVector<Cube*>& sources);
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class LayoutPlanner instance.
+	*/
+	void log(Message message) const;
+
+private:
+	/*!
+	* Screened placement and magazine layout.
+	*/
+	struct Candidate
+	{
+		LayoutPlan plan; /*! Placement and magazine layout */
+		double cost = -1; /*! Screening cost in milliseconds. Negative if the candidate has not been screened */
+	};
+
+	const int MAGAZINE_X_MIN = 134; /*! X-axis position of the first slot of a magazine row in steps */
+	const int MAGAZINE_X_MAX = 1015; /*! X-axis position of the last slot of a magazine row in steps */
+	const int MAGAZINE_ROW_PITCH = 63; /*! Distance between the magazine rows in steps */
+	const int MAGAZINE_ROWS = 3; /*! Number of magazine rows */
+	const int MAGAZINE_SLOTS = 15; /*! Number of slots in a magazine row */
+
+	MotionModel motionModel; /*! Kinematic model of the robot */
+	RobotPosition visionPosition; /*! Position of the robot at which the full scene is processed */
+	ClearancePlanner clearancePlanner; /*! Planner of the moves of the simulated cube tasks */
+	TaskSequencer* taskSequencer; /*! Sequencer of the simulated cube tasks */
+	SourceAssigner* sourceAssigner; /*! Assigner of the source cubes to the simulated cube tasks */
+	RotationPlanner rotationPlanner; /*! Planner of the end-effector rotations of the simulated cube tasks */
+	BuildSimulator buildSimulator; /*! Simulator of the planned constructions */
+	int cubeLength = 64; /*! Length of the cube edge in horizontal steps */
+	int magazineClearance = 64; /*! Minimum gap in steps between a destination and a source cube */
+	int spareCubes = 3; /*! Number of source cubes in addition to the cubes of the model for the tasks repeated after a failure */
+	int coarseStep = 64; /*! Distance in steps between the placements of the coarse grid */
+	int fineStep = 16; /*! Distance in steps between the placements of the fine grid */
+	int plannedCandidates = 3; /*! Number of screened candidates which are planned and simulated */
+
+	/*!
+	* Get the layout of the source cubes in a block of the magazine.
+	*
+	* \param [in] firstRow First row of the block.
+	* \param [in] rows Number of rows of the block.
+	* \param [in] firstSlot First slot of each row of the block.
+	* \param [in] slotCount Number of slots in each row of the block.
+	* \param [in] count Number of source cubes.
+	* \return Layout of the source cubes.
+	*/
+	SourceLayout getSourceLayout(int firstRow, int rows, int firstSlot, int slotCount, int count) const;
+
+	/*!
+	* Screen a placement and magazine layout.
+	*
+	* \param [in] destinations Destination positions relative to the build model origin for the placement orientation.
+	* \param [in] placement Placement of the build model.
+	* \param [in] layout Layout of the source cubes.
+	* \return Screening cost in milliseconds. Negative if a destination is out of reach or too close to the magazine.
+	*/
+	double screen(const std::vector<glm::vec2>& destinations, const StructurePlacement& placement, const SourceLayout& layout) const;
+};
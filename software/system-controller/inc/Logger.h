@@ -22,6 +22,11 @@ enum class MessageType
 */
 struct Message
 {
+	/*!
+	* Default message constructor required to pass messages between threads.
+	*/
+	Message() : type(MessageType::INFO_LOG) {}
+
 	/*!
 	* Message constructor.
 	*/
@@ -37,6 +42,8 @@ struct Message
 	QString content; /*! Message description */
 };
 
+Q_DECLARE_METATYPE(Message)
+
 /*!
 * Endpoint for all messages generated by the various software components.
 * Displays all messages using a \class QTextEdit component.
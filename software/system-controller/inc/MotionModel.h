@@ -0,0 +1,183 @@
+#pragma once
+
+#include <vector>
+
+/*!
+* Position of the robot in the robot coordinate system. The x, y and z coordinates and the rotation are in full steps
+* of the respective motors.
+*/
+struct RobotPosition
+{
+	int x = 0; /*! X-axis position in steps */
+	int y = 0; /*! Y-axis position in steps */
+	int z = 0; /*! Z-axis position in steps */
+	int r = 0; /*! Rotation of the end-effector in steps */
+
+	bool operator==(const RobotPosition& position) const
+	{
+		return x == position.x && y == position.y && z == position.z && r == position.r;
+	}
+
+	bool operator!=(const RobotPosition& position) const
+	{
+		return !(*this == position);
+	}
+};
+
+/*!
+* Robot motion axes.
+*/
+enum class MotionAxis
+{
+	X = 0,
+	Y = 1,
+	Z = 2,
+	R = 3
+};
+
+/*!
+* Kinematic model of the robot motors used to estimate the duration of robot commands. The model mirrors the stepping
+* of the robot controller firmware:
+*
+* - A microstep takes two timer periods since the step pin is toggled once per timer interrupt, and the timers count
+*   at 1 MHz.
+* - The x, y and z motors accelerate and decelerate along the firmware acceleration tables. The table entry is updated
+*   after each block of microsteps using the number of blocks completed or remaining, whichever is smaller.
+* - The rotation motor steps at a constant period.
+* - The motors of a move run independently so a move lasts as long as its slowest axis.
+*
+* Each axis duration is computed in constant time from the cumulative duration of its acceleration table.
+*/
+class MotionModel
+{
+public:
+	static constexpr int MIN_ROTATION = -78; /*! Minimum rotation of the end-effector in steps */
+	static constexpr int MAX_ROTATION = 78; /*! Maximum rotation of the end-effector in steps */
+	static constexpr int QUARTER_TURN = 50; /*! Number of rotation steps in a quarter turn */
+
+	/*!
+	* Class constructor. Initialize the acceleration profiles of the motors to match the firmware.
+	*/
+	MotionModel();
+
+	/*!
+	* Estimate the duration of a move of a single axis.
+	*
+	* \param [in] axis Axis which moves.
+	* \param [in] steps Number of full steps moved. The direction of the move is ignored.
+	* \return Duration of the move in milliseconds excluding the command overhead.
+	*/
+	double getAxisTime(MotionAxis axis, int steps) const;
+
+	/*!
+	* Estimate the progress of a move of a single axis after a time since the motor started stepping.
+	*
+	* \param [in] axis Axis which moves.
+	* \param [in] steps Number of full steps moved. The direction of the move is ignored.
+	* \param [in] time Time since the start of the move in milliseconds.
+	* \return Fraction of the move completed in the range [0, 1].
+	*/
+	double getAxisProgress(MotionAxis axis, int steps, double time) const;
+
+	/*!
+	* Estimate the position of the robot during a position command.
+	*
+	* \param [in] start Position of the robot when the command is issued.
+	* \param [in] end Target position of the command.
+	* \param [in] time Time since the motors started stepping in milliseconds.
+	* \return Position of the robot.
+	*/
+	RobotPosition getMovePosition(const RobotPosition& start, const RobotPosition& end, double time) const;
+
+	/*!
+	* Estimate the duration of a position command.
+	*
+	* \param [in] start Position of the robot when the command is issued.
+	* \param [in] end Target position of the command.
+	* \return Duration of the command in milliseconds.
+	*/
+	double getMoveTime(const RobotPosition& start, const RobotPosition& end) const;
+
+	/*!
+	* Get the rotations of the end-effector within the rotation limits which are equivalent to a cube rotation. A cube
+	* is symmetric under quarter turns so rotations which differ by a multiple of a quarter turn are equivalent.
+	*
+	* \param [in] rotation Cube rotation in steps.
+	* \return Equivalent rotations in increasing order.
+	*/
+	static std::vector<int> getEquivalentRotations(int rotation);
+
+	/*!
+	* Get the rotation of the end-effector within the rotation limits which is equivalent to a cube rotation and closest
+	* to a reference rotation.
+	*
+	* \param [in] rotation Cube rotation in steps.
+	* \param [in] reference Reference rotation in steps.
+	* \return Equivalent rotation in steps.
+	*/
+	static int getEquivalentRotation(int rotation, int reference);
+
+	/*!
+	* Estimate the duration of a gripper command. The firmware sets the servo position and replies immediately.
+	*
+	* \return Duration of the command in milliseconds.
+	*/
+	double getGripperTime() const;
+
+	/*!
+	* Estimate the duration of a delay command.
+	*
+	* \return Duration of the command in milliseconds.
+	*/
+	double getDelayTime() const;
+
+private:
+	/*!
+	* Acceleration profile of a motor.
+	*/
+	struct AxisProfile
+	{
+		int stepMode; /*! Number of microsteps per full step */
+		int updatePeriod; /*! Number of microsteps between updates of the step period */
+		int rampBlocks; /*! Index of the last acceleration table entry */
+		std::vector<double> rampTimes; /*! Duration in microseconds of the first i update blocks at the start of a move */
+		double cruiseTime; /*! Duration in microseconds of an update block at the minimum step period */
+	};
+
+	AxisProfile axes[4]; /*! Acceleration profile of each motor */
+	double commandTime = 15; /*! Duration of the transmission of a command and its reply in milliseconds */
+	double delayTime = 350; /*! Duration of the firmware busy loop of the delay command in milliseconds */
+
+	/*!
+	* Compute the duration of the first update blocks of a move with the blocks past the end of the acceleration table
+	* at full speed.
+	*
+	* \param [in] profile Acceleration profile of the motor.
+	* \param [in] count Number of blocks.
+	* \return Duration in microseconds.
+	*/
+	static double getRampTime(const AxisProfile& profile, int count);
+
+	/*!
+	* Compute the duration of the first update blocks of a move. The first half of the move uses the table entries of the
+	* completed blocks starting from zero and the second half uses the table entries of the remaining blocks ending at one.
+	*
+	* \param [in] profile Acceleration profile of the motor.
+	* \param [in] blocks Number of blocks in the move.
+	* \param [in] count Number of completed blocks.
+	* \return Duration in microseconds.
+	*/
+	static double getElapsedTime(const AxisProfile& profile, int blocks, int count);
+
+	/*!
+	* Build the acceleration profile of a motor using the firmware acceleration table parameters.
+	*
+	* \param [in] stepMode Number of microsteps per full step.
+	* \param [in] minPeriod Timer period at full speed.
+	* \param [in] rampFullSteps Number of full steps over which the motor accelerates to full speed. Zero for a motor
+	*	stepped at a constant period.
+	* \param [in] updatePeriod Number of microsteps between updates of the step period.
+	* \return Acceleration profile.
+	*/
+	static AxisProfile createProfile(int stepMode, int minPeriod, int rampFullSteps, int updatePeriod);
+};
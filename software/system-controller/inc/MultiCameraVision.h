@@ -0,0 +1,202 @@
+#pragma once
+
+#include "Vision.h"
+#include "Logger.h"
+#include "opencv2/opencv.hpp"
+#include <QObject>
+#include <QVector>
+
+/*!
+* Axis-aligned box in the computer vision world frame that blocks the line of sight of the cameras.
+*/
+struct VisionOccluder
+{
+	cv::Point3d min; /*! Corner of the box with the minimum coordinates */
+	cv::Point3d max; /*! Corner of the box with the maximum coordinates */
+};
+
+/*!
+* Computer vision system for multiple calibrated cameras. Each camera has its own \class Vision instance, and the
+* scenes captured by the cameras are processed in parallel with a worker per camera.
+*
+* The independent cubes detected by each camera are fused in the world frame. Detections of the same cube from
+* different cameras are clustered, and a cluster is accepted as a cube if it was detected by at least half of the
+* cameras that have an unobstructed view of it. A camera's view is obstructed if the line of sight from the camera
+* centre to the cube passes through a known cube or another occluder, such as the robot end-effector.
+*
+* Cameras are provided as \class cv::VideoCapture instances so that recorded sessions can stand in for cameras.
+*/
+class MultiCameraVision : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	MultiCameraVision(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Add a camera to the system.
+	*
+	* \param [in] camera Source of the camera images. The camera is not owned by the multi-camera system.
+	* \param [in] vision Computer vision system used to process the camera images. A new computer vision system owned
+	*	by the multi-camera system is created if not provided.
+	* \return Index of the added camera.
+	*/
+	int addCamera(cv::VideoCapture* camera, Vision* vision = Q_NULLPTR);
+
+	/*!
+	* Getter for the number of cameras in the system.
+	*
+	* \return Number of cameras.
+	*/
+	int getCameraCount() const;
+
+	/*!
+	* Getter for the computer vision system of a camera.
+	*
+	* \param [in] camera Camera index.
+	* \return Computer vision system of the camera.
+	*/
+	Vision* getVision(int camera) const;
+
+	/*!
+	* Set the occluders considered in addition to the known source and structure cubes.
+	*
+	* \param [in] occluders Occluders in the world frame.
+	*/
+	void setOccluders(const std::vector<VisionOccluder>& occluders);
+
+	/*!
+	* Capture an image from each camera in parallel.
+	*
+	* \param [in] discardFrames Number of buffered frames read from each camera before the returned frame.
+	* \return Image captured by each camera. The image is empty if the capture failed.
+	*/
+	std::vector<cv::Mat> captureImages(int discardFrames);
+
+	/*!
+	* Process the scene captured by each camera in parallel and fuse the independent cube detections. The arguments
+	* mirror those of \class Vision::processScene.
+	*
+	* \param [in] images Image captured by each camera.
+	* \param [in] calibrate Calibrate the cameras using the fiducials if true.
+	* \param [in] sourceCentroids Centroid coordinates of the source cubes in the world frame.
+	* \param [in] structCentroids Centroid coordinates of the cubes in the structure in the world frame.
+	*/
+	void processScene(const std::vector<cv::Mat>& images, bool calibrate, std::vector<cv::Point3i>* sourceCentroids = Q_NULLPTR,
+		std::vector<cv::Point3i>* structCentroids = Q_NULLPTR);
+
+	/*!
+	* Indicates if at least one camera is calibrated.
+	*
+	* \return True if a camera is calibrated. False otherwise.
+	*/
+	bool isCalibrated() const;
+
+	/*!
+	* Getter for the combined quality measures of the scenes captured by the cameras in the most recent scene. The largest
+	* reprojection error and the smallest fiducial count of the cameras are reported together with the cube measures of
+	* all cameras.
+	*
+	* \return Combined scene quality measures.
+	*/
+	SceneQuality getSceneQuality() const;
+
+	/*!
+	* Getter for the fused independent cube centroids. The interface matches \class Vision::getCubeCentroids.
+	*
+	* \param [in] z Height of the cube top faces in the world frame.
+	* \return List of fused independent cube centroids.
+	*/
+	std::vector<cv::Point3i> getCubeCentroids(const int z) const;
+
+	/*!
+	* Getter for the fused independent cube rotations. This is a parallel vector with the centroids vector returned by getCubeCentroids.
+	*
+	* \param [in] z Height of the cube top faces in the world frame.
+	* \return List of fused independent cube rotations in radians.
+	*/
+	std::vector<float> getCubeRotations(const int z) const;
+
+	/*!
+	* Getter for the fused independent cube poses. The residual of a fused pose is the mean residual of its detections.
+	* This is a parallel vector with the centroids vector returned by getCubeCentroids.
+	*
+	* \param [in] z Height of the cube top faces in the world frame.
+	* \return List of fused independent cube poses.
+	*/
+	std::vector<CubePose> getCubePoses(const int z) const;
+
+	/*!
+	* Getter for the fused independent cube poses on the best fitting layer of each detection. The height of a fused
+	* pose is the layer closest to the mean height of its detections.
+	*
+	* \return List of fused independent cube poses.
+	*/
+	std::vector<CubePose> getLayeredCubePoses() const;
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class MultiCameraVision instance.
+	*/
+	void log(Message message) const;
+
+private:
+	/*!
+	* Independent cube detected by one or more cameras.
+	*/
+	struct CubeCluster
+	{
+		cv::Point3d position; /*! Mean top face centroid of the detections in the world frame */
+		cv::Point2d rotation; /*! Sum of the detection rotations as unit vectors at four times the cube rotation */
+		double residual; /*! Sum of the detection pose residuals */
+		QVector<int> cameras; /*! Cameras that detected the cube */
+	};
+
+	QVector<cv::VideoCapture*> cameras; /*! Sources of the camera images */
+	QVector<Vision*> visions; /*! Computer vision system of each camera */
+	QVector<cv::Size> imageSizes; /*! Size of the most recent image processed for each camera */
+	std::vector<VisionOccluder> occluders; /*! Occluders in addition to the known cubes */
+	std::vector<VisionOccluder> sceneOccluders; /*! Occluders used for the most recently processed scene */
+	const double clusterDistance = 32; /*! Maximum distance between detections of the same cube in horizontal steps */
+	const double cubeLength = 64; /*! Length of the cube edge in horizontal steps */
+
+	/*!
+	* Cluster the detections of all cameras and select the clusters supported by the cameras that can see them.
+	*
+	* \param [in] z Height of the cube top faces in the world frame. The best fitting layer of each detection is used if zero.
+	* \return Accepted cube clusters.
+	*/
+	std::vector<CubeCluster> fuseDetections(int z) const;
+
+	/*!
+	* Convert accepted cube clusters to cube poses.
+	*
+	* \param [in] clusters Accepted cube clusters.
+	* \return Fused cube poses.
+	*/
+	std::vector<CubePose> getClusterPoses(const std::vector<CubeCluster>& clusters) const;
+
+	/*!
+	* Check if a camera has an unobstructed view of a point.
+	*
+	* \param [in] camera Camera index.
+	* \param [in] worldPoint Point in the world frame.
+	* \return True if the point is in the camera image and the line of sight to the point is not occluded.
+	*/
+	bool isVisible(int camera, const cv::Point3d& worldPoint) const;
+
+	/*!
+	* Check if a line segment intersects an occluder. Occluders that contain the end point of the segment are ignored
+	* since the end point lies on the surface being viewed.
+	*
+	* \param [in] start Start point of the segment.
+	* \param [in] end End point of the segment.
+	* \param [in] occluder Occluder to test.
+	* \return True if the segment intersects the occluder.
+	*/
+	bool intersects(const cv::Point3d& start, const cv::Point3d& end, const VisionOccluder& occluder) const;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CubeTask.h"
+#include "Vision.h"
+#include "Logger.h"
+#include <QObject>
+#include <QList>
+#include <vector>
+
+/*!
+* State of a destination of the build model when a construction failure is detected.
+*/
+enum class DestinationState
+{
+	PENDING, /*! No cube has been placed at the destination */
+	PLACED, /*! A structure cube is at the destination */
+	DISPLACED, /*! A structure cube was placed at the destination but is no longer there */
+	IN_PROGRESS /*! The cube task of the destination is in progress and continues unchanged */
+};
+
+/*!
+* Corrective cube tasks which recover a construction from the observed scene.
+*/
+struct RecoveryPlan
+{
+	QList<CubeTask*> tasks; /*! Cube tasks of the destinations to be placed in build order */
+	QList<CubeTask*> lostTasks; /*! Cube tasks of the destinations whose structure cube is no longer at its destination */
+	QList<int> occupyingCubes; /*! Detected cubes found at a destination to be placed, parallel to the occupied tasks */
+	QList<CubeTask*> occupiedTasks; /*! Cube tasks of the destinations occupied by a detected cube */
+	QList<int> sourceCubes; /*! Detected cubes which become source cubes. The blocking cubes are listed first */
+	int blockingCubes = 0; /*! Number of detected cubes which block a destination and are the source cubes of the first tasks in order */
+};
+
+/*!
+* Plans the recovery of a construction after the computer vision system detects more independent cubes than expected,
+* such as when a placed cube is knocked off the structure or a cube is dropped. The plan is computed from the state of
+* each destination of the build model and the independent cubes detected in the scene:
+*
+* - A placed destination is lost if its structure cube was not found or a destination supporting it is lost.
+* - A detected cube at a destination to be placed, within the placement tolerances and on a complete support, is
+*   accepted as placed and the destination continues without a cube task.
+* - Every other detected cube becomes a source cube. A detected cube which occupies the space of a destination to be
+*   placed blocks it, so it is removed by using it as the source cube of a cube task which is performed before the
+*   blocked destination is placed.
+* - The destinations to be placed, which are the pending and lost destinations that are not occupied, are placed in
+*   build order so every cube is placed on a complete support.
+* - The cube task in progress continues unchanged, so the recovery fails if the support of its destination is lost
+*   or if its destination is blocked.
+*
+* Only the destinations affected by the failure are placed again, so a failure costs a few cube tasks rather than the
+* full construction.
+*/
+class RecoveryPlanner : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	RecoveryPlanner(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the tolerances within which a detected cube is accepted as placed at a destination.
+	*
+	* \param [in] positionTolerance Maximum position error in horizontal steps.
+	* \param [in] rotationTolerance Maximum rotation error in radians.
+	*/
+	void setTolerances(double positionTolerance, double rotationTolerance);
+
+	/*!
+	* Plan the corrective cube tasks.
+	*
+	* \param [in] buildTasks Cube task of each destination of the build model in build order.
+	* \param [in] states State of each destination, parallel to the build tasks.
+	* \param [in] detectedCubes Poses of the independent cubes detected in the scene.
+	* \param [out] plan Corrective cube tasks.
+	* \return True if the construction can be recovered. False otherwise.
+	*/
+	bool plan(const QList<CubeTask*>& buildTasks, const QList<DestinationState>& states, const std::vector<CubePose>& detectedCubes,
+		RecoveryPlan& plan);
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class RecoveryPlanner instance.
+	*/
+	void log(Message message) const;
+
+private:
+	double positionTolerance = 12; /*! Maximum position error of a detected cube accepted as placed in horizontal steps */
+	double rotationTolerance = 0.09; /*! Maximum rotation error of a detected cube accepted as placed in radians */
+	const double CUBE_LENGTH = 64; /*! Length of the cube edge in horizontal steps */
+	const double FOOTPRINT_DISTANCE = 80; /*! Centroid distance in horizontal steps below which the footprints of two cubes may overlap at any rotation */
+
+	/*!
+	* Check if a destination is directly above another destination.
+	*
+	* \param [in] upper Top face centroid of the upper destination.
+	* \param [in] lower Top face centroid of the lower destination.
+	* \return True if the footprints overlap and the upper destination is higher. False otherwise.
+	*/
+	bool isAbove(const glm::vec3& upper, const glm::vec3& lower) const;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+/*!
+* Step limits of the robot end-effector in the robot coordinate system. The limits are shared by the modules that place
+* or observe cubes in the workspace.
+*/
+struct RobotLimits
+{
+	static constexpr int X_MIN = 0; /*! Minimum step position of robot end-effector along x-axis */
+	static constexpr int X_MAX = 1015; /*! Maximum step position of robot end-effector along x-axis */
+	static constexpr int Y_MIN = 0; /*! Minimum step position of robot end-effector along y-axis */
+	static constexpr int Y_MAX = 1125; /*! Maximum step position of robot end-effector along y-axis */
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CubeTask.h"
+#include "MotionModel.h"
+#include <QList>
+#include <vector>
+
+/*!
+* Chooses the rotations of the end-effector for the cube tasks of a construction. A cube is symmetric under quarter
+* turns, so each cube can be picked up and placed with any of the rotations equivalent to its rotation within the
+* rotation limits of the robot, and the rotation of the cube between the pick up and placement is unchanged modulo a
+* quarter turn.
+*
+* Choosing the rotation closest to the current rotation for each pick up and placement in turn can force a long
+* rotation later in the sequence when a choice ends up near a rotation limit. The rotations of the whole sequence are
+* therefore chosen together with dynamic programming over the pick ups and placements to minimise the total rotation.
+*/
+class RotationPlanner
+{
+public:
+	/*!
+	* Class constructor.
+	*/
+	RotationPlanner();
+
+	/*!
+	* Choose the rotations of the cube tasks which have not been started and set them as the preferred rotations of the
+	* tasks. Tasks without a source cube are assumed to pick up their cube without rotating it.
+	*
+	* \param [in] tasks Cube tasks in the order they are performed.
+	* \param [in] startRotation Current rotation of the end-effector in steps.
+	* \return Total rotation of the end-effector in steps.
+	*/
+	int plan(const QList<CubeTask*>& tasks, int startRotation) const;
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "Cube.h"
+#include "Logger.h"
+#include "SessionRecorder.h"
+#include "RobotLimits.h"
+#include "opencv2/opencv.hpp"
+#include <QObject>
+#include <QMap>
+#include <QList>
+
+/*!
+* Enumeration describing the role of a cube in a synthetic scene. The role determines which centroid list the cube is
+* reported in when the scene is passed to the computer vision system.
+*/
+enum class SceneCubeRole
+{
+	SOURCE, /*! Cube in the source magazine */
+	STRUCTURE, /*! Cube placed in the structure being built */
+	INDEPENDENT /*! Cube that is neither a source cube nor part of the structure */
+};
+
+/*!
+* Description of a cube in a synthetic scene in the robot coordinate system.
+*/
+struct SceneCube
+{
+	cv::Point3d position; /*! Top face centroid with the z coordinate as a positive height in horizontal steps */
+	float rotation; /*! Rotation about the vertical axis in radians with the same convention as \class Vision::getCubeRotations */
+	SceneCubeRole role; /*! Role of the cube in the scene */
+};
+
+/*!
+* Renders synthetic camera images of the robot workspace from a description of the cubes and fiducials in the world frame.
+* The images are produced with the same pinhole camera model used by the computer vision system so that the known
+* scene description can be used as the ground truth when validating and benchmarking the computer vision system.
+*
+* Surfaces are drawn in order of decreasing depth from the camera. Cube top faces and fiducials are bright, while cube
+* sides and the workspace surface are dark so that the scene is separable by the computer vision binary threshold.
+*/
+class SceneRenderer : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor. The renderer is initialized with a camera centred above the workspace looking straight down.
+	*
+	* \param [in] parent Parent object.
+	*/
+	SceneRenderer(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the size of the rendered images.
+	*
+	* \param [in] imageSize Image size in pixels.
+	*/
+	void setImageSize(const cv::Size& imageSize);
+
+	/*!
+	* Set the intrinsic camera parameters.
+	*
+	* \param [in] cameraMatrix Intrinsic camera matrix.
+	* \param [in] distCoeffs Camera distortion coefficients.
+	*/
+	void setCameraIntrinsics(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs);
+
+	/*!
+	* Set the pose of the world frame with respect to the camera frame.
+	*
+	* \param [in] rotationVector Rotation vector of the world frame with respect to the camera frame.
+	* \param [in] translationVector Translation vector of the world frame with respect to the camera frame.
+	*/
+	void setCameraPose(const cv::Mat& rotationVector, const cv::Mat& translationVector);
+
+	/*!
+	* Set the fiducials to render.
+	*
+	* \param [in] fiducialWorldPoints Map of fiducial identifiers to the fiducial centroid in the world frame.
+	*/
+	void setFiducials(const QMap<int, cv::Point3i>& fiducialWorldPoints);
+
+	/*!
+	* Set the image noise and illumination falloff applied to rendered images.
+	*
+	* \param [in] noise Standard deviation of the Gaussian pixel noise in intensity levels.
+	* \param [in] illumination Proportional reduction in brightness at the image corners relative to the image centre.
+	*/
+	void setImageEffects(double noise, double illumination);
+
+	/*!
+	* Remove all cubes from the scene.
+	*/
+	void clearCubes();
+
+	/*!
+	* Add a cube to the scene.
+	*
+	* \param [in] cube Cube to add in the robot coordinate system.
+	*/
+	void addCube(const SceneCube& cube);
+
+	/*!
+	* Add cubes defined in the OpenGL coordinate system to the scene.
+	*
+	* \param [in] cubes Cubes to add.
+	* \param [in] role Role of the added cubes in the scene.
+	* \param [in] origin Position in the robot coordinate system of the OpenGL coordinate system origin.
+	*/
+	void addCubes(const QList<Cube*>* cubes, SceneCubeRole role, const cv::Point& origin = cv::Point(0, 0));
+
+	/*!
+	* Add the source magazine cubes in the same layout used by the construction view.
+	*/
+	void addSourceMagazine();
+
+	/*!
+	* Add randomly positioned independent cubes on the base layer of the workspace that do not overlap existing cubes.
+	*
+	* \param [in] count Number of independent cubes to add.
+	* \param [in] rng Random number generator.
+	* \return Number of independent cubes added.
+	*/
+	int addRandomCubes(int count, cv::RNG& rng);
+
+	/*!
+	* Getter for the cubes in the scene.
+	*
+	* \return List of cubes in the scene.
+	*/
+	const std::vector<SceneCube>& getCubes() const;
+
+	/*!
+	* Render an image of the scene.
+	*
+	* \param [in] rng Random number generator used for the image noise.
+	* \return Rendered image.
+	*/
+	cv::Mat render(cv::RNG& rng);
+
+	/*!
+	* Render the scene to a session frame. The frame contains the rendered image, the source and structure cube
+	* centroids and the ground truth scene description.
+	*
+	* \param [in] rng Random number generator used for the image noise.
+	* \param [out] frame Rendered session frame.
+	*/
+	void renderFrame(cv::RNG& rng, SessionFrame& frame);
+
+	/*!
+	* Render a session of synthetic frames of a cube world model built in the workspace next to the source magazine.
+	* Each frame contains a different random set of independent cubes.
+	*
+	* \param [in] modelFileName Path of the cube world model file placed as the structure.
+	* \param [in] sessionFileName Path of the session file to create.
+	* \param [in] frameCount Number of frames to render.
+	* \param [in] independentCubes Number of independent cubes in each frame.
+	* \param [in] seed Random number generator seed.
+	* \return True if the session was rendered. False otherwise.
+	*/
+	bool renderSession(const QString& modelFileName, const QString& sessionFileName, int frameCount, int independentCubes,
+		unsigned int seed);
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class SceneRenderer instance.
+	*/
+	void log(Message message) const;
+
+private:
+	cv::Size imageSize = cv::Size(1920, 1080); /*! Size of the rendered images in pixels */
+	cv::Mat cameraMatrix; /*! Intrinsic camera matrix */
+	cv::Mat distCoeffs; /*! Camera distortion coefficients */
+	cv::Mat rotationVector; /*! Rotation vector for world frame with respect to camera frame */
+	cv::Mat rotationMatrix; /*! Rotation matrix for world frame with respect to camera frame */
+	cv::Mat translationVector; /*! Translation vector for world frame with respect to camera frame */
+	QMap<int, cv::Point3i> fiducialWorldPoints; /*! Position in the world frame of each fiducial rendered */
+	std::vector<SceneCube> cubes; /*! Cubes in the scene */
+	double noise = 2; /*! Standard deviation of the Gaussian pixel noise in intensity levels */
+	double illumination = 0.15; /*! Proportional reduction in brightness at the image corners */
+
+	// Scene appearance
+	const int cubeLength = 64; /*! Length of the cube edge in horizontal steps */
+	const int cubeBevel = 2; /*! Width of the darker bevel around each cube top face in horizontal steps */
+	const int fiducialLength = 128; /*! Side length of the fiducial square in horizontal steps */
+	const int backgroundIntensity = 45; /*! Intensity of the workspace surface */
+	const int cubeTopIntensity = 225; /*! Intensity of cube top faces */
+	const int cubeSideIntensity = 85; /*! Intensity of cube side faces */
+	const int fiducialDarkIntensity = 25; /*! Intensity of the dark fiducial cells */
+	const int fiducialLightIntensity = 250; /*! Intensity of the fiducial border and light fiducial cells */
+
+	// Robot constant parameters
+	const cv::Point STRUCTURE_ORIGIN = cv::Point(507, 650); /*! Structure origin in the robot coordinate system used by \class CubeTask */
+
+	/*!
+	* Get the pattern of a fiducial in the \class FiducialDictionary as a 3x3 grid of binary cells.
+	*
+	* \param [in] id Fiducial identifier.
+	* \param [out] cells Binary value of each cell in row major order with the first row at the minimum y coordinate.
+	*/
+	void getFiducialPattern(int id, int cells[9]) const;
+
+	/*!
+	* Fill a planar convex polygon defined in the world frame.
+	*
+	* \param [out] image Image to draw to.
+	* \param [in] polygon Vertices of the polygon in the world frame.
+	* \param [in] intensity Fill intensity.
+	*/
+	void fillWorldPolygon(cv::Mat& image, const std::vector<cv::Point3d>& polygon, int intensity) const;
+
+	/*!
+	* Compute the corners of a square in the xy plane of the world frame.
+	*
+	* \param [in] centre Centre of the square in the world frame.
+	* \param [in] length Side length of the square.
+	* \param [in] rotation Rotation of the square about the vertical axis in radians.
+	* \return Square corners in the world frame.
+	*/
+	std::vector<cv::Point3d> getSquare(const cv::Point3d& centre, double length, double rotation) const;
+
+	/*!
+	* Compute the depth of a world point along the camera optical axis.
+	*
+	* \param [in] worldPoint Point in the world frame.
+	* \return Depth of the point in the camera frame.
+	*/
+	double getDepth(const cv::Point3d& worldPoint) const;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "SessionRecorder.h"
+#include "Logger.h"
+#include "opencv2/opencv.hpp"
+#include <QObject>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QVector>
+
+/*!
+* Enumeration describing how a session player advances through the recorded frames when used as a camera.
+*/
+enum class SessionPlaybackMode
+{
+	TIMED, /*! Each grab returns the frame recorded at the corresponding time since playback started scaled by the playback speed */
+	SEQUENTIAL /*! Each grab returns the next recorded frame regardless of the time elapsed */
+};
+
+/*!
+* Replays a session file recorded by a \class SessionRecorder. The player can be used in place of a live camera
+* wherever a \class cv::VideoCapture is expected, or the recorded frames can be accessed directly by index.
+*/
+class SessionPlayer : public QObject, public cv::VideoCapture
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	SessionPlayer(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Class destructor. Closes the session file if it is open.
+	*/
+	~SessionPlayer();
+
+	/*!
+	* Open a session file for playback. The frame index is rebuilt from the frame records if the session was not closed cleanly.
+	*
+	* \param [in] fileName Path of the session file.
+	* \return True if the session file was opened. False otherwise.
+	*/
+	bool openSession(const QString& fileName);
+
+	/*!
+	* Getter for the number of frames in the session.
+	*
+	* \return Number of recorded frames.
+	*/
+	int getFrameCount() const;
+
+	/*!
+	* Read a recorded frame by index. This does not affect the playback position.
+	*
+	* \param [in] frameIndex Index of the frame to read.
+	* \param [out] frame Recorded frame.
+	* \return True if the frame was read. False otherwise.
+	*/
+	bool readFrame(int frameIndex, SessionFrame& frame);
+
+	/*!
+	* Set the playback position to the given frame and restart the playback clock from that frame.
+	*
+	* \param [in] frameIndex Index of the next frame to be grabbed.
+	*/
+	void seek(int frameIndex);
+
+	/*!
+	* Set the method used to advance through the recorded frames when used as a camera.
+	*
+	* \param [in] mode Playback mode.
+	*/
+	void setPlaybackMode(SessionPlaybackMode mode);
+
+	/*!
+	* Set the playback speed relative to the recording speed for timed playback.
+	*
+	* \param [in] speed Playback speed multiplier.
+	*/
+	void setPlaybackSpeed(double speed);
+
+	/*!
+	* Set if playback restarts from the first frame once the last frame has been grabbed.
+	*
+	* \param [in] loop Restart playback after the last frame if true.
+	*/
+	void setLooping(bool loop);
+
+	bool isOpened() const override;
+	void release() override;
+	bool grab() override;
+	bool retrieve(cv::OutputArray image, int flag = 0) override;
+	bool read(cv::OutputArray image) override;
+	bool set(int propId, double value) override;
+	double get(int propId) const override;
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class SessionPlayer instance.
+	*/
+	void log(Message message) const;
+
+private:
+	QFile file; /*! Session file being replayed */
+	quint32 version = 0; /*! Format version of the session file */
+	QVector<SessionIndexEntry> index; /*! Index of the frames in the session file */
+	SessionPlaybackMode mode = SessionPlaybackMode::TIMED; /*! Method used to advance through the recorded frames */
+	double speed = 1; /*! Playback speed multiplier for timed playback */
+	bool loop = false; /*! Restart playback after the last frame if true */
+	QElapsedTimer playbackTimer; /*! Time elapsed since timed playback started */
+	qint64 playbackStart = 0; /*! Recorded timestamp of the frame at which timed playback started */
+	int nextFrame = 0; /*! Index of the next frame to be grabbed in sequential playback */
+	int grabbedFrame = -1; /*! Index of the most recently grabbed frame */
+	int decodedFrame = -1; /*! Index of the frame currently held in the decoded frame cache */
+	SessionFrame decoded; /*! Cache of the most recently decoded frame */
+
+	/*!
+	* Rebuild the frame index by scanning the frame records of the session file.
+	*/
+	void rebuildIndex();
+};
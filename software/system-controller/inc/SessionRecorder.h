@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Logger.h"
+#include "opencv2/opencv.hpp"
+#include <QObject>
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QVector>
+
+/*!
+* Collection of the inputs passed to the computer vision system for a single scene. A session frame contains everything
+* required to reproduce a call to \class Vision::processScene offline.
+*/
+struct SessionFrame
+{
+	qint64 timestamp = 0; /*! Time in milliseconds since the start of the session at which the frame was captured */
+	cv::Mat image; /*! Camera image passed to the computer vision system */
+	bool calibrate = false; /*! Calibration flag passed to the computer vision system */
+	bool hasSourceCentroids = false; /*! Indicates if source cube centroids were provided to the computer vision system */
+	bool hasStructCentroids = false; /*! Indicates if structure cube centroids were provided to the computer vision system */
+	std::vector<cv::Point3i> sourceCentroids; /*! Source cube top face centroids in the world frame */
+	std::vector<cv::Point3i> structCentroids; /*! Structure cube top face centroids in the world frame */
+	cv::Vec4i robotPosition = cv::Vec4i(0, 0, 0, 0); /*! Robot [X, Y, Z, R] step position at the time of capture */
+
+	// Ground truth is only available for synthetic frames
+	bool hasGroundTruth = false; /*! Indicates if the ground truth scene description is available for the frame */
+	std::vector<cv::Point3i> truthCubeCentroids; /*! Independent cube top face centroids in the world frame with the z coordinate as a positive height */
+	std::vector<float> truthCubeRotations; /*! Independent cube rotations in the range (-PI / 4, PI / 4] parallel to the centroid list */
+	std::vector<int> truthFiducialIds; /*! Identifiers of the fiducials visible in the frame */
+	std::vector<cv::Point2d> truthFiducialCentroids; /*! Fiducial centroids in the image frame parallel to the identifier list */
+};
+
+/*!
+* Entry in the index of a session file used to seek directly to a frame.
+*/
+struct SessionIndexEntry
+{
+	qint64 offset; /*! Byte offset of the frame record from the start of the session file */
+	qint64 timestamp; /*! Time in milliseconds since the start of the session at which the frame was captured */
+};
+
+/*!
+* Records the scenes processed by the computer vision system to a session file so that they can be replayed offline.
+*
+* A session file consists of a header, a sequence of frame records and a trailing index. The header contains the file
+* identifier, the format version and the byte offset of the index. The offset is only written when the session is
+* closed, so a session that was not closed cleanly has an index offset of zero and its index must be rebuilt by
+* scanning the frame records. Each frame record is a length-prefixed byte array so that frames can be skipped without
+* being decoded. Images are stored losslessly to ensure replayed scenes are processed identically.
+*/
+class SessionRecorder : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	SessionRecorder(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Class destructor. Closes the session file if it is open.
+	*/
+	~SessionRecorder();
+
+	/*!
+	* Create a new session file. Any existing file at the given path is overwritten.
+	*
+	* \param [in] fileName Path of the session file.
+	* \return True if the session file was created. False otherwise.
+	*/
+	bool open(const QString& fileName);
+
+	/*!
+	* Write the index to the session file and close it.
+	*/
+	void close();
+
+	/*!
+	* Indicates if a session is currently being recorded.
+	*
+	* \return True if a session file is open for recording. False otherwise.
+	*/
+	bool isRecording() const;
+
+	/*!
+	* Getter for the number of frames recorded in the current session.
+	*
+	* \return Number of recorded frames.
+	*/
+	int getFrameCount() const;
+
+	/*!
+	* Record the inputs of a computer vision scene. The arguments mirror those of \class Vision::processScene.
+	*
+	* \param [in] image Image to be processed.
+	* \param [in] calibrate Calibration flag passed to the computer vision system.
+	* \param [in] sourceCentroids Centroid coordinates of the source cubes in the world frame.
+	* \param [in] structCentroids Centroid coordinates of the cubes in the structure in the world frame.
+	* \param [in] robotPosition Robot [X, Y, Z, R] step position at the time of capture.
+	*/
+	void recordFrame(const cv::Mat& image, bool calibrate, const std::vector<cv::Point3i>* sourceCentroids,
+		const std::vector<cv::Point3i>* structCentroids, const cv::Vec4i& robotPosition);
+
+	/*!
+	* Append a fully specified session frame to the session file. The timestamp of the frame is preserved.
+	*
+	* \param [in] frame Session frame to write.
+	*/
+	void writeFrame(const SessionFrame& frame);
+
+	/*!
+	* Serialize a session frame to a frame record.
+	*
+	* \param [in] frame Session frame to serialize.
+	* \return Frame record.
+	*/
+	static QByteArray encodeFrame(const SessionFrame& frame);
+
+	/*!
+	* Deserialize a session frame from a frame record.
+	*
+	* \param [in] record Frame record.
+	* \param [in] version Format version of the session file the record was read from.
+	* \param [out] frame Deserialized session frame.
+	* \return True if the frame record was valid. False otherwise.
+	*/
+	static bool decodeFrame(const QByteArray& record, quint32 version, SessionFrame& frame);
+
+	static const quint32 SESSION_MAGIC = 0x53455353; /*! Identifier at the start of every session file */
+	static const quint32 SESSION_VERSION = 2; /*! Current session file format version. Version 2 adds the ground truth scene description */
+	static const qint64 SESSION_HEADER_SIZE = 16; /*! Size of the session file header in bytes */
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class SessionRecorder instance.
+	*/
+	void log(Message message) const;
+
+private:
+	QFile file; /*! Session file being recorded */
+	QDataStream stream; /*! Stream used to write to the session file */
+	QElapsedTimer sessionTimer; /*! Time elapsed since the session was opened */
+	QVector<SessionIndexEntry> index; /*! Index of the frames written to the session file */
+};
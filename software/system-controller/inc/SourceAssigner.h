@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Cube.h"
+#include "CubeTask.h"
+#include "MotionModel.h"
+#include "Logger.h"
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <map>
+#include <utility>
+#include <vector>
+
+/*!
+* Assigns the source cubes to the pending cube tasks of a construction. The order of the tasks is fixed, so the
+* duration of a task depends only on its source cube and the destination of the previous task. The assignment of
+* source cubes to tasks which minimises the estimated duration of the tasks, including the travel and rotation of the
+* robot, is therefore a linear assignment problem and is solved exactly with the Hungarian algorithm.
+*
+* The assignment is solved again whenever a source cube fails to be gripped or is relocated by the computer vision
+* system. The estimated duration of each task and source cube pair is cached with the positions it was estimated from,
+* so a new solution only estimates the pairs of the cubes that moved and of the first pending task.
+*/
+class SourceAssigner : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	SourceAssigner(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the kinematic model used to estimate the duration of the cube tasks.
+	*
+	* \param [in] motionModel Kinematic model of the robot.
+	*/
+	void setMotionModel(const MotionModel& motionModel);
+
+	/*!
+	* Assign the source cubes to the cube tasks which have not been started. Tasks which have been started keep their
+	* source cube. If there are fewer source cubes than tasks, the earliest tasks are assigned a source cube and the
+	* remaining tasks are left without a source cube.
+	*
+	* \param [in] tasks Cube tasks in the order they are performed.
+	* \param [in] sources Source cubes available to the tasks.
+	* \param [in] position Current position of the robot.
+	* \param [in] raisedHeight Height in vertical steps the robot is raised to after each task.
+	* \return Estimated duration of the assigned tasks in milliseconds.
+	*/
+	double assign(const QList<CubeTask*>& tasks, const QVector<Cube*>& sources, const RobotPosition& position, int raisedHeight);
+
+	/*!
+	* Discard the cached task durations. This must be called when the cube tasks are replaced.
+	*/
+	void clearCache();
+
+	/*!
+	* Solve a rectangular linear assignment problem with the Hungarian algorithm.
+	*
+	* \param [in] costs Cost of assigning each column to each row. There must not be more rows than columns.
+	* \return Column assigned to each row.
+	*/
+	static std::vector<int> solveAssignment(const std::vector<std::vector<double>>& costs);
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class SourceAssigner instance.
+	*/
+	void log(Message message) const;
+
+private:
+	/*!
+	* Estimated duration of a task with a source cube and the positions it was estimated from.
+	*/
+	struct CachedDuration
+	{
+		glm::vec3 sourcePosition; /*! Position of the source cube in the OpenGL coordinate system */
+		float sourcePitch; /*! Rotation of the source cube */
+		RobotPosition start; /*! Position of the robot at the start of the task */
+		double duration; /*! Estimated duration of the task in milliseconds */
+	};
+
+	MotionModel motionModel; /*! Kinematic model of the robot */
+	std::map<std::pair<const CubeTask*, const Cube*>, CachedDuration> durations; /*! Cached task durations */
+
+	/*!
+	* Estimate the duration of a task with a source cube, using the cached duration if the positions are unchanged.
+	*
+	* \param [in] task Cube task.
+	* \param [in] source Source cube.
+	* \param [in] start Position of the robot at the start of the task.
+	* \param [in] raisedPosition Position of the robot after the task.
+	* \return Estimated duration in milliseconds.
+	*/
+	double getDuration(const CubeTask* task, const Cube* source, const RobotPosition& start, const RobotPosition& raisedPosition);
+};
@@ -6,6 +6,8 @@
 #include "DesignView.h"
 #include "ConstructionView.h"
 #include "Logger.h"
+#include "SessionPlayer.h"
+#include "FrameGrabber.h"
 
 
 class SystemController: public QWidget
@@ -39,6 +41,9 @@ private:
     Logger* messageLog; /*! Display for all messages logged by various software components */
     Robot* robot = Q_NULLPTR; /*! Reference to interface with the robotic subsystem */
     cv::VideoCapture* camera = Q_NULLPTR; /*! Source of live camera images */
+    SessionPlayer* sessionPlayer = Q_NULLPTR; /*! Recorded session replayed in place of the live camera if requested on the command line */
+    FrameGrabber* frameGrabber = Q_NULLPTR; /*! Captures live camera frames on a dedicated thread for the views and workspace monitor */
+    QList<cv::VideoCapture*> extraCameras; /*! Additional cameras used by the computer vision system */
 
     const double CAMERA_WIDTH = 1280; /*! Robot vision camera input image width in pixels */
     const double CAMERA_HEIGHT = 720; /*! Robot vision camera input image height in pixels */
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Cube.h"
+#include "CubeTask.h"
+#include "ConstructionPlanner.h"
+#include "MotionModel.h"
+#include "Logger.h"
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <vector>
+
+/*!
+* Sequences the cube tasks of a construction to minimise the estimated duration of the construction. The sequence is a
+* list of pick and place pairs, each consisting of a source cube and a cube task, and the duration of each pair is
+* estimated with the kinematic model of the robot from the position the robot is left in by the previous pair.
+*
+* The sequence is built with a nearest neighbour heuristic which repeatedly chooses the quickest pair among the source
+* cubes that remain and the tasks whose prerequisites have been placed. The sequence is then improved with 2-opt moves
+* that reverse a segment of the sequence. A segment is only reversed if none of its tasks is a prerequisite of another
+* task in the segment so that the sequence remains a valid build order.
+*/
+class TaskSequencer : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	TaskSequencer(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the kinematic model used to estimate the duration of the cube tasks.
+	*
+	* \param [in] motionModel Kinematic model of the robot.
+	*/
+	void setMotionModel(const MotionModel& motionModel);
+
+	/*!
+	* Sequence the cube tasks and assign a source cube to each task. Tasks are left without a source cube if there are
+	* fewer source cubes than tasks.
+	*
+	* \param [in] tasks Cube tasks in the build order of the planner.
+	* \param [in] sources Source cubes available to the tasks.
+	* \param [in] start Position of the robot when the construction is started. The robot is raised to this height after
+	*	each task so that the placed cube can be verified.
+	* \param [in] planner Planner of the build order with the prerequisites of the task destination cubes.
+	* \return Sequenced cube tasks.
+	*/
+	QList<CubeTask*> sequence(const QList<CubeTask*>& tasks, const QVector<Cube*>& sources, const RobotPosition& start,
+		const ConstructionPlanner* planner);
+
+	/*!
+	* Getter for the estimated duration of the tasks of the most recent sequence in the build order of the planner with
+	* the source cubes taken in order.
+	*
+	* \return Estimated duration in milliseconds.
+	*/
+	double getInitialDuration() const;
+
+	/*!
+	* Getter for the estimated duration of the tasks of the most recent sequence.
+	*
+	* \return Estimated duration in milliseconds.
+	*/
+	double getSequenceDuration() const;
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class TaskSequencer instance.
+	*/
+	void log(Message message) const;
+
+private:
+	/*!
+	* Pick and place pair of a sequence.
+	*/
+	struct TaskPair
+	{
+		int task; /*! Task index */
+		int source; /*! Source cube index. -1 if no source cube remains for the task */
+	};
+
+	MotionModel motionModel; /*! Kinematic model of the robot */
+	QList<CubeTask*> tasks; /*! Tasks being sequenced */
+	QVector<Cube*> sources; /*! Source cubes being assigned */
+	std::vector<std::vector<int>> prerequisites; /*! Task indices of the prerequisites of each task */
+	std::vector<std::vector<int>> dependents; /*! Task indices of the tasks which have each task as a prerequisite */
+	std::vector<RobotPosition> raisedPositions; /*! Position of the robot raised above the destination of each task */
+	RobotPosition start; /*! Position of the robot when the construction is started */
+	double initialDuration = 0; /*! Estimated duration of the build order of the planner */
+	double sequenceDuration = 0; /*! Estimated duration of the sequence */
+	const int maxOptimizationTime = 200; /*! Maximum duration of the 2-opt improvement in milliseconds */
+
+	/*!
+	* Estimate the duration of a pick and place pair including the move to the verification height after the placement.
+	*
+	* \param [in] previous Previous pair of the sequence. Null for the first pair.
+	* \param [in] pair Pick and place pair.
+	* \return Estimated duration in milliseconds.
+	*/
+	double getPairDuration(const TaskPair* previous, const TaskPair& pair) const;
+
+	/*!
+	* Estimate the duration of a sequence.
+	*
+	* \param [in] pairs Sequence of pairs.
+	* \return Estimated duration in milliseconds.
+	*/
+	double estimateDuration(const std::vector<TaskPair>& pairs) const;
+
+	/*!
+	* Build a sequence with the nearest neighbour heuristic.
+	*
+	* \return Sequence of pairs.
+	*/
+	std::vector<TaskPair> buildNearestNeighbour() const;
+
+	/*!
+	* Improve a sequence with 2-opt segment reversals until no reversal shortens the sequence or the time limit elapses.
+	* The duration of a reversal is evaluated in constant time from the cumulative durations of the sequence in the
+	* forward and reverse directions.
+	*
+	* \param [in,out] pairs Sequence of pairs.
+	*/
+	void improveTwoOpt(std::vector<TaskPair>& pairs) const;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QString>
+
+/*!
+* Level of verification performed by the computer vision system after a cube is placed.
+*/
+enum class VerificationLevel
+{
+	NONE, /*! Continue with the next cube task without capturing an image */
+	PLACEMENT, /*! Verify the placement on a small region of the system camera image */
+	SCENE /*! Process the full scene */
+};
+
+/*!
+* Decides after each placed cube whether the construction process verifies the placement before the next cube task.
+* Verifying a placement requires the robot to raise the end-effector and capture an image, which is wasted time when the
+* cube was gripped throughout the task and nothing suggests a disturbance. The policy therefore skips the verification
+* in the nominal case and only verifies a placement when one of the following applies:
+*
+* - A failure, such as a failed grip, a disturbed cube or a misplaced cube, occurred recently. Failures are weighted by
+*   how recently they occurred, and the full scene is processed when several failures occurred in quick succession.
+* - The pressure trace while the cube was carried came close to the grip threshold or dropped sharply, which indicates
+*   the cube may have slipped on the suction cup.
+* - The number of placements since the last verification reached the sampling interval. The interval is shortened by
+*   one for each layer below the placed cube, since a misplaced cube on a taller structure is costlier to recover.
+*
+* The workspace monitor continues to watch the workspace for disturbances while verification is skipped.
+*/
+class VerificationPolicy
+{
+public:
+	/*!
+	* Class constructor.
+	*/
+	VerificationPolicy();
+
+	/*!
+	* Clear the failure history and the placements since the last verification at the start of a construction.
+	*/
+	void reset();
+
+	/*!
+	* Set the maximum number of placements on the bottom layer between verifications.
+	*
+	* \param [in] interval Sampling interval in placements. An interval of one verifies every placement.
+	*/
+	void setSamplingInterval(int interval);
+
+	/*!
+	* Set the pressure at which the cube is considered gripped.
+	*
+	* \param [in] threshold Pressure reading of the robot vacuum system.
+	*/
+	void setPressureThreshold(int threshold);
+
+	/*!
+	* Clear the pressure trace at the start of a cube task.
+	*/
+	void startTask();
+
+	/*!
+	* Add a pressure reading taken while the cube is carried to the pressure trace of the current cube task.
+	*
+	* \param [in] pressure Pressure reading of the robot vacuum system.
+	*/
+	void addPressureSample(int pressure);
+
+	/*!
+	* Record a failure of the construction process.
+	*/
+	void recordFailure();
+
+	/*!
+	* Decide the level of verification of a placed cube. This must be called once for each placed cube.
+	*
+	* \param [in] layer Layer of the placed cube in the structure, starting from zero.
+	* \param [out] reason Description of the condition which requires the verification.
+	* \return Level of verification.
+	*/
+	VerificationLevel decide(int layer, QString& reason);
+
+private:
+	int samplingInterval = 5; /*! Maximum number of placements on the bottom layer between verifications */
+	int pressureThreshold = 500; /*! Pressure at which the cube is considered gripped */
+	int unverifiedPlacements = 0; /*! Number of placements since the last verification */
+	double failureScore = 0; /*! Sum of the recent failures weighted by how recently they occurred */
+	int minPressure = 0; /*! Minimum pressure of the trace of the current cube task */
+	int maxPressure = 0; /*! Maximum pressure of the trace of the current cube task */
+	int pressureSamples = 0; /*! Number of pressure readings in the trace of the current cube task */
+	const double FAILURE_DECAY = 0.5; /*! Factor by which the weight of a failure decays with each placement */
+	const double SCENE_FAILURE_SCORE = 1.5; /*! Failure score at which the full scene is processed */
+	const double PLACEMENT_FAILURE_SCORE = 0.2; /*! Failure score at which the placement is verified */
+	const int PRESSURE_MARGIN = 100; /*! Pressure above the grip threshold below which a reading is anomalous */
+	const int PRESSURE_DROP = 150; /*! Pressure drop within the trace which is anomalous */
+};
@@ -1,8 +1,84 @@
 #pragma once
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <limits>
 #include "opencv2/opencv.hpp"
 #include "Logger.h"
+#include "FiducialDictionary.h"
+#include "RobotLimits.h"
+
+/*!
+* Pose of an independent cube estimated from the corners of its top face.
+*/
+struct CubePose
+{
+	cv::Point3d position; /*! Top face centroid in the world frame with the z coordinate as a positive height */
+	float rotation; /*! Rotation about the vertical axis in the range (-PI / 4, PI / 4] radians */
+	double residual; /*! Root mean square distance between the projected corners and the fitted top face corners in horizontal steps */
+};
+
+/*!
+* Outcome of the verification of a cube placement.
+*/
+enum class PlacementStatus
+{
+	VERIFIED, /*! The top face was found within the position and rotation tolerances of the destination */
+	MISPLACED, /*! The top face was found outside the tolerances or was not found near the destination */
+	INCONCLUSIVE /*! The top face could not be separated from its surroundings and the full scene must be processed */
+};
+
+/*!
+* Result of the verification of a cube placement.
+*/
+struct PlacementVerification
+{
+	PlacementStatus status = PlacementStatus::INCONCLUSIVE; /*! Outcome of the verification */
+	CubePose pose = { cv::Point3d(0, 0, 0), 0, std::numeric_limits<double>::infinity() }; /*! Observed pose of the placed cube */
+	double positionError = std::numeric_limits<double>::infinity(); /*! Horizontal distance between the observed and destination top face centroids in horizontal steps */
+	double rotationError = std::numeric_limits<double>::infinity(); /*! Rotation between the observed and destination top faces in radians */
+	double duration = 0; /*! Duration of the verification in milliseconds */
+};
+
+/*!
+* Parameters of the computer vision processing stages.
+*/
+struct VisionParameters
+{
+	int threshold = 120; /*! Intensity above which blurred pixels are set in the binary threshold stage */
+	bool adaptiveThreshold = true; /*! Compute the threshold automatically for each region of the image instead of using the fixed threshold */
+	int blurSize = 0; /*! Box blur kernel size less one in pixels */
+	double areaThreshold = 1000; /*! Minimum contour area in pixels for a contour to be processed as a cube or fiducial */
+	double cellThreshold = 0.7; /*! Minimum proportion of a fiducial cell with one binary value for the cell to be classified in the range (0.5, 1] */
+};
+
+/*!
+* Measures of the quality of the most recent scene processed by the computer vision system.
+*/
+struct SceneQuality
+{
+	int fiducialCount = 0; /*! Number of fiducials with a known world position used for the extrinsic calibration */
+	double reprojectionError = 0; /*! Root mean square distance in pixels between the fiducial centroids and their projected world points. Infinite if not calibrated */
+	std::vector<double> fiducialConfidences; /*! Decoding confidence of each identified fiducial in the range [0, 1] */
+	std::vector<double> cubeResiduals; /*! Top face fit residual in horizontal steps of each independent cube on its best fitting layer */
+	std::vector<double> cubeShapeScores; /*! Ratio of the smaller to the larger of the contour area and the corner quadrilateral area of each independent cube */
+};
+
+/*!
+* Duration in milliseconds of each stage of the most recent scene processed by the computer vision system.
+* Stages whose cached output was reused have a duration of zero.
+*/
+struct VisionTimings
+{
+	double blur = 0; /*! Grayscale conversion and blur stage */
+	double threshold = 0; /*! Binary threshold stage */
+	double contours = 0; /*! Contour detection stage */
+	double fiducials = 0; /*! Corner detection, isolation and identification of fiducial candidates */
+	double calibration = 0; /*! Extrinsic parameter computation from the fiducials */
+	double classification = 0; /*! Region of interest filtering and source and structure cube classification */
+	double total = 0; /*! Complete scene processing */
+};
+
 /*!
 * State-based computer vision interface for the robot
 */
@@ -23,6 +99,7 @@ public:
 	* 3D shape based on the known centroid location of these cubes in the world frame. Contours that are not classified are
 	* considered to be independent cubes. If the source cube centroids and the structure cube centroids are not provided,
 	* all non-fiducial contours are assumed to be independent cubes.
+	* The image is retained without copying so that the scene can be processed again and must not be modified.
 	* 
 	* \param [in] image Image to be processed.
 	* \param [in] calibrate Recompute the extrinsic rotation and translation matrices if true.
@@ -32,6 +109,27 @@ public:
 	void processScene(const cv::Mat& image, bool calibrate, std::vector<cv::Point3i>* sourceCentroids = Q_NULLPTR,
 		std::vector<cv::Point3i>* structCentroids = Q_NULLPTR);
 
+	/*!
+	* Process the most recent scene again with the current parameters. The output of each processing stage is cached
+	* with a key derived from the key of its input and its parameters, so only the stages affected by a changed parameter
+	* are run again.
+	*/
+	void reprocessScene();
+
+	/*!
+	* Set the parameters of the processing stages. The parameters are applied to the next processed scene.
+	*
+	* \param [in] parameters Processing stage parameters.
+	*/
+	void setParameters(const VisionParameters& parameters);
+
+	/*!
+	* Getter for the parameters of the processing stages.
+	*
+	* \return Processing stage parameters.
+	*/
+	VisionParameters getParameters() const;
+
 	/*!
 	* Annotate image with fiducial information.
 	* 
@@ -75,7 +173,8 @@ public:
 	void plotVisionBoundBox(cv::Mat& image);
 
 	/*!
-	* Compute the corresponding world point given an image point and the Z coordinate of the world point.
+	* Compute the corresponding world point given an image point and the Z coordinate of the world point. Lens distortion
+	* is removed from the image point before it is projected.
 	* 
 	* \param [in] imagePoint Coordinates of the source point in the uv image frame.
 	* \param [in] z Z coordinate of the correspoding world point.
@@ -84,13 +183,57 @@ public:
 	cv::Point3i projectImagePoint(const cv::Point2d& imagePoint, double z) const;
 
 	/*!
-	* Compute the corresponding image point given a world point.
+	* Compute the corresponding image point given a world point. Lens distortion is applied to the projected point.
 	* 
 	* \param [in] worldPoint Coordinates of the source point in the XYZ world frame.
 	* \return Image point corresponding to given world point.
 	*/
 	cv::Point projectWorldPoint(const cv::Point3d& worldPoint) const;
 
+	/*!
+	* Compute the bounding rectangle of the projection of an axis-aligned box in the world frame onto the image.
+	*
+	* \param [in] min Corner of the box with the minimum coordinates.
+	* \param [in] max Corner of the box with the maximum coordinates.
+	* \return Bounding rectangle of the projected box corners.
+	*/
+	cv::Rect projectWorldBox(const cv::Point3d& min, const cv::Point3d& max) const;
+
+	/*!
+	* Compute the projection of an axis-aligned box in the world frame onto the image.
+	*
+	* \param [in] min Corner of the box with the minimum coordinates.
+	* \param [in] max Corner of the box with the maximum coordinates.
+	* \return Convex hull of the projected box corners.
+	*/
+	std::vector<cv::Point> projectWorldPolygon(const cv::Point3d& min, const cv::Point3d& max) const;
+
+	/*!
+	* Compute the projection of the computer vision region of interest on the base plane onto the image.
+	*
+	* \return Convex hull of the projected region of interest. The list is empty if the system is not calibrated.
+	*/
+	std::vector<cv::Point> getRegionOfInterest() const;
+
+	/*!
+	* Compute the image regions occluded by the robot for a pose of the end-effector. The robot is modelled as the
+	* vertical end-effector column above the end-effector and the gantry beam spanning the x-axis at the height of the
+	* carriage.
+	*
+	* \param [in] endEffectorPosition Position of the bottom of the end-effector in the world frame.
+	* \return Convex polygons of the occluded image regions. The list is empty if the system is not calibrated.
+	*/
+	std::vector<std::vector<cv::Point>> getRobotOccludedRegions(const cv::Point3d& endEffectorPosition) const;
+
+	/*!
+	* Set the image regions occluded by the robot. Cube contours that overlap an occluded region are ignored when the
+	* cubes of the next scenes are classified. No regions are set when the robot is at a position where it does not
+	* occlude the workspace, so that no cube contour is ignored.
+	*
+	* \param [in] regions Convex polygons of the occluded image regions.
+	*/
+	void setOccludedRegions(const std::vector<std::vector<cv::Point>>& regions);
+
 	/*!
 	* Getter for image after the grayscale and blur stage of processing.
 	* 
@@ -134,6 +277,26 @@ public:
 	*/
 	std::vector<cv::Point3i> getCubeCentroids(const int z) const;
 
+	/*!
+	* Getter for the independent cube poses. The corners of each cube top face are mapped to the plane of the top face
+	* with the homography of the plane and a square with the cube edge length is fitted to them. Poses are cached until
+	* the next scene is processed. This is a parallel vector with the centroids vector returned by getCubeCentroids.
+	*
+	* \param [in] z Height of the cube top faces in the world frame.
+	* \return List of independent cube poses. The residual is infinite if the top face corners were not found.
+	*/
+	std::vector<CubePose> getCubePoses(const int z) const;
+
+	/*!
+	* Getter for the independent cube poses on the best fitting layer. The pose of each cube is estimated on the top face
+	* plane of each layer of the workspace and the lowest layer with a residual within a margin of the smallest residual
+	* is selected. The apparent size and shape of the top face only match the cube edge length on the plane the top face
+	* lies in. Poses are cached until the next scene is processed.
+	*
+	* \return List of independent cube poses with the z coordinate as the height of the best fitting layer.
+	*/
+	std::vector<CubePose> getLayeredCubePoses() const;
+
 	/*!
 	* Getter for the independent cube contour orientations. This is a parallel vector with the centroids vector returned by getCubeCentroids.
 	* 
@@ -142,6 +305,86 @@ public:
 	*/
 	std::vector<float> Vision::getCubeRotations(const int z) const;
 
+	/*!
+	* Getter for the intrinsic camera matrix.
+	*
+	* \return Intrinsic camera matrix.
+	*/
+	cv::Mat getCameraMatrix() const;
+
+	/*!
+	* Getter for the camera distortion coefficients.
+	*
+	* \return Camera distortion coefficients.
+	*/
+	cv::Mat getDistCoeffs() const;
+
+	/*!
+	* Set the intrinsic camera parameters. The vision system must be recalibrated after the intrinsic parameters change.
+	*
+	* \param [in] cameraMatrix Intrinsic camera matrix.
+	* \param [in] distCoeffs Camera distortion coefficients.
+	*/
+	void setIntrinsics(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs);
+
+	/*!
+	* Getter for the position of the camera centre in the world frame.
+	*
+	* \return Camera centre in the world frame. Returns the origin if the system is not calibrated.
+	*/
+	cv::Point3d getCameraPosition() const;
+
+	/*!
+	* Getter for the known position of each fiducial in the world frame.
+	*
+	* \return Map of fiducial identifiers to the fiducial centroid in the world frame.
+	*/
+	QMap<int, cv::Point3i> getFiducialWorldPoints() const;
+
+	/*!
+	* Getter for the identifiers of the fiducials found in the most recently processed scene.
+	*
+	* \return List of fiducial identifiers.
+	*/
+	std::vector<int> getFiducialIds() const;
+
+	/*!
+	* Indicates if the vision system has a valid extrinsic calibration.
+	*
+	* \return True if calibrated. False otherwise.
+	*/
+	bool isCalibrated() const;
+
+	/*!
+	* Getter for the stage durations of the most recently processed scene.
+	*
+	* \return Stage durations in milliseconds.
+	*/
+	VisionTimings getStageTimings() const;
+
+	/*!
+	* Verify the placement of a cube without processing the full scene. Only a small window of the image around the
+	* projection of the destination top face is processed with the current stage parameters, and the pose of the top face
+	* contour at the destination is estimated on the plane of the destination layer. Rotations are compared modulo a
+	* quarter turn since the top face is symmetric.
+	*
+	* \param [in] image Image of the workspace captured after the cube was placed.
+	* \param [in] expectedPose Destination pose of the cube top face in the world frame with the z coordinate as a positive height.
+	* \param [in] positionTolerance Maximum position error in horizontal steps.
+	* \param [in] rotationTolerance Maximum rotation error in radians.
+	* \return Verification result. The result is inconclusive if the system is not calibrated.
+	*/
+	PlacementVerification verifyPlacement(const cv::Mat& image, const CubePose& expectedPose, double positionTolerance,
+		double rotationTolerance) const;
+
+	/*!
+	* Getter for the quality measures of the most recently processed scene. The reprojection error is that of the
+	* extrinsic calibration in use. Cube measures are only available if the system is calibrated.
+	*
+	* \return Scene quality measures.
+	*/
+	SceneQuality getSceneQuality() const;
+
 signals:
 	/*!
 	* Generated when a message is logged by an \class Vision instance.
@@ -158,7 +401,8 @@ private:
 		cv::Point centroid; /*! Centroid moment of fiducial contour */
 		std::vector<cv::Point> contour; /*! Collection of points describing contour around fiducial */
 		std::vector<cv::Point> corners; /*! Set of four corners of the fiducial square in an anti-clockwise direction */
-		cv::Mat homographyMatrix; /*! Homography matrix mapping fiducials from calibration image to isolated image */
+		cv::Mat homographyMatrix; /*! Homography matrix mapping fiducials from undistorted calibration image to isolated image */
+		double confidence; /*! Decoding confidence of the fiducial cells in the range [0, 1] */
 	};
 
 	/*!
@@ -169,6 +413,7 @@ private:
 		cv::Point centroid; /*! Centroid moment of cube contour */
 		std::vector<cv::Point> contour; /*! Collection of points describing contour around cube */
 		std::vector<cv::Point> corners; /*! Set of four corners of the cube top-face in an anti-clockwise direction */
+		double shapeScore; /*! Agreement between the contour area and the area enclosed by the corners in the range [0, 1] */
 	};
 
 	// Intrinsic camera parameters
@@ -179,27 +424,133 @@ private:
 
 	cv::Mat cameraMatrix; /*! Intrinsic camera matrix */
 	cv::Mat distCoeffs; /*! Camera distorition coefficients */
+	cv::Mat rotationVector; /*! Rotation vector for world frame with respect to camera frame */
 	cv::Mat rotationMatrix; /*! Rotation matrix for world frame with respect to camera frame */
 	cv::Mat translationVector; /*! Translation matrix for world frame with respect to camera frame */
+	cv::Mat undistortMap; /*! Fixed point distorted image coordinates of each undistorted image pixel */
+	cv::Mat undistortInterpolationMap; /*! Interpolation table indices paired with the undistortion map */
+	cv::Size undistortMapSize; /*! Image size for which the undistortion maps were computed */
 	std::vector<FiducialContour> fiducialContours; /*! Set of fiducials identified in the image frame */
 	std::vector<CubeContour> cubeContours;  /*! Set of independent cube contours in the image frame */
 	std::vector<CubeContour> sourceCubeContours;  /*! Set of source cube contours in the image frame */
 	std::vector<CubeContour> structCubeContours;  /*! Set of structure cube contours in the image frame */
 	QMap<int, cv::Point3i> fiducialWorldPoints; /*! Position in the world frame of each fiducial used */
+	VisionParameters parameters; /*! Parameters of the processing stages */
+	std::vector<std::vector<cv::Point>> occludedRegions; /*! Convex image regions occluded by the robot in which cube contours are ignored */
 	bool calibrated = false; /*! Flag to indicate if the vision system has been calibrated with a valid extrinsic matrix */
+	int calibrationFiducials = 0; /*! Number of fiducials used for the extrinsic calibration */
+	double reprojectionError = std::numeric_limits<double>::infinity(); /*! Root mean square fiducial reprojection error of the extrinsic calibration in pixels */
 	int visionBoundBox[4]; /*! Bounding box planes for computer vision region of interest in the world frame [X min, X max, Y min, Y max] */
 
+	// Scene inputs retained so that the scene can be processed again
+	cv::Mat sceneImage; /*! Image of the most recent scene */
+	bool sceneCalibrate = false; /*! Indicates if the most recent scene is used to calibrate the extrinsic parameters */
+	std::vector<cv::Point3i> sceneSourceCentroids; /*! Source cube centroids provided with the most recent scene */
+	std::vector<cv::Point3i> sceneStructCentroids; /*! Structure cube centroids provided with the most recent scene */
+	bool hasSceneSourceCentroids = false; /*! Indicates if source cube centroids were provided with the most recent scene */
+	bool hasSceneStructCentroids = false; /*! Indicates if structure cube centroids were provided with the most recent scene */
+	quint64 sceneId = 0; /*! Identifier of the most recent scene used as the input key of the first stage */
+
+	// Key of the input and parameters from which the cached output of each stage was computed
+	quint64 blurKey = 0; /*! Key of the grayscale and blur stage */
+	quint64 thresholdKey = 0; /*! Key of the threshold stage */
+	quint64 contourKey = 0; /*! Key of the contour detection stage */
+	quint64 fiducialKey = 0; /*! Key of the fiducial identification stage */
+	quint64 calibrationKey = 0; /*! Key of the extrinsic calibration stage */
+	quint64 calibrationGeneration = 0; /*! Incremented whenever the extrinsic calibration state changes */
+
+	std::vector<std::vector<cv::Point>> contours; /*! Outer contours found in the contour detection stage */
+	std::vector<double> contourHoleAreas; /*! Total area of the holes in each outer contour in pixels. This is a parallel vector with the contours vector */
+	std::vector<CubeContour> candidateCubeContours; /*! Non-fiducial contours found in the fiducial identification stage */
 	cv::Mat blurredImage; /*! image after the grayscale and blur stage of processing */
 	cv::Mat thresholdImage; /*! Image after the thresholding stage of processing */
 	cv::Mat contourImage; /*! Image after the contour detection stage of processing */
 	std::vector<cv::Mat> fiducialImages; /*! Isolated fiducial images */
 	std::vector<cv::Mat> annotatedFiducialImages; /*! Annotated fiducial images */
+	VisionTimings timings; /*! Stage durations of the most recently processed scene */
+	mutable QMap<int, cv::Mat> layerHomographies; /*! Cached image to plane homography for each top face height */
+	mutable QMap<int, std::vector<CubePose>> cubePoses; /*! Cached independent cube poses for each top face height */
+	mutable std::vector<CubePose> layeredCubePoses; /*! Cached independent cube poses on the best fitting layer */
+	mutable bool layeredCubePosesValid = false; /*! Indicates if the cached poses on the best fitting layer are valid */
 
 	// Robot constant parameters
-	const int ROBOT_X_MIN = 0; /*! Minimum step position of robot end-effector along x-axis */
-	const int ROBOT_X_MAX = 1015; /*! Maximum step position of robot end-effector along x-axis */
-	const int ROBOT_Y_MIN = 0; /*! Minimum step position of robot end-effector along y-axis */
-	const int ROBOT_Y_MAX = 1125; /*! Maximum step position of robot end-effector along y-axis */
+	const int CUBE_LENGTH = 64; /*! Length of the cube edge in horizontal steps */
+	const int MAX_LAYERS = 6; /*! Number of cube layers in the workspace */
+	const double LAYER_RESIDUAL_MARGIN = 1.5; /*! Residual in horizontal steps by which a higher layer must fit better than a lower layer to be selected */
+	const int FIDUCIAL_IMAGE_SIZE = 128; /*! Side length in pixels of the isolated fiducial images */
+	const int THRESHOLD_TILES = 8; /*! Number of tiles along each image axis for which the adaptive threshold is computed */
+	const int MIN_TILE_CONTRAST = 40; /*! Minimum difference between the mean intensities of the two classes of a tile for its own threshold to be used */
+	const int FIDUCIAL_LENGTH = 128; /*! Side length of the fiducial square in horizontal steps */
+	const double MIN_FIDUCIAL_HOLE_FRACTION = 0.02; /*! Minimum ratio of the hole area to the contour area of a fiducial candidate */
+	const double MIN_FIDUCIAL_SOLIDITY = 0.9; /*! Minimum ratio of the contour area to the convex hull area of a fiducial candidate */
+	const double MAX_FIDUCIAL_SIDE_RATIO = 1.5; /*! Maximum length ratio of the opposite sides of a fiducial candidate */
+	const double MIN_FIDUCIAL_AREA_RATIO = 0.5; /*! Minimum ratio of the contour area to the expected fiducial area at its location */
+	const double MAX_FIDUCIAL_AREA_RATIO = 2; /*! Maximum ratio of the contour area to the expected fiducial area at its location */
+	const double END_EFFECTOR_HALF_WIDTH = 48; /*! Half width of the end-effector column in horizontal steps */
+	const double HORIZONTAL_STEPS_PER_MM = 5; /*! Horizontal steps per millimetre of the 20 tooth GT2 pulley drives */
+	const double GANTRY_HEIGHT = 481; /*! Height of the underside of the gantry beam above the base plane in horizontal steps, taken as the end-effector height at the top of the 2390 step z-axis travel */
+	const double GANTRY_DEPTH = 40 * HORIZONTAL_STEPS_PER_MM; /*! Vertical extent of the 2040 extrusion of the gantry beam in horizontal steps */
+	const double GANTRY_HALF_WIDTH = 10 * HORIZONTAL_STEPS_PER_MM; /*! Half width of the 2040 extrusion of the gantry beam along the y-axis in horizontal steps */
+	const double GANTRY_LENGTH = 320 * HORIZONTAL_STEPS_PER_MM; /*! Length of the 320 mm extrusion of the gantry beam in horizontal steps */
+
+	/*!
+	* Run the processing stages on the most recent scene. Stages whose input key and parameters match their cached
+	* output are skipped. Cube classification is always run.
+	*/
+	void runStages();
+
+	/*!
+	* Fiducial identification stage. Contours of significant size that pass the fiducial pre-filter are isolated and
+	* identified in parallel, and the contours are separated into fiducials and cube candidates.
+	*/
+	void processContours();
+
+	/*!
+	* Adaptive threshold stage. The image is divided into tiles and the Otsu threshold of each tile is computed from
+	* histograms gathered in a single pass over the image. Tiles with too little contrast to separate objects from the
+	* background use the Otsu threshold of the whole image. The threshold of each pixel is interpolated bilinearly
+	* between the thresholds of the surrounding tile centres, so the thresholded image follows gradual changes in
+	* lighting across the workspace and through the day.
+	*
+	* \param [in] image Grayscale image.
+	* \param [out] thresholdedImage Binary image in which pixels above their threshold are set.
+	*/
+	void computeAdaptiveThreshold(const cv::Mat& image, cv::Mat& thresholdedImage) const;
+
+	/*!
+	* Compute the Otsu threshold of a histogram.
+	*
+	* \param [in] histogram Pixel count of each intensity.
+	* \param [out] contrast Difference between the mean intensities of the pixels above and below the threshold.
+	* \return Intensity threshold. Pixels with an intensity greater than the threshold belong to the upper class.
+	*/
+	static int computeOtsuThreshold(const int histogram[256], int& contrast);
+
+	/*!
+	* Fast geometric test run before a contour is isolated and decoded as a fiducial. A fiducial candidate must contain
+	* holes for its dark cells, have a convex and regular quadrilateral outline and, once the system is calibrated, have
+	* an area close to that of a fiducial at its predicted location on the base plane.
+	*
+	* \param [in] contour Outer contour of the candidate.
+	* \param [in] corners Corners of the candidate found by \class findSquareCorners.
+	* \param [in] holeArea Total area of the holes in the contour in pixels.
+	* \return True if the contour may be a fiducial. False otherwise.
+	*/
+	bool isFiducialCandidate(const std::vector<cv::Point>& contour, const std::vector<cv::Point>& corners, double holeArea) const;
+
+	/*!
+	* Extrinsic calibration stage. The extrinsic parameters are computed from the identified fiducials.
+	*/
+	void calibrateExtrinsics();
+
+	/*!
+	* Combine a stage key with a parameter value.
+	*
+	* \param [in] key Key of the stage input.
+	* \param [in] value Parameter value.
+	* \return Combined key.
+	*/
+	static quint64 combineKey(quint64 key, double value);
 
 	/*!
 	* Get the contour centroid.
@@ -223,19 +574,37 @@ private:
 	* \param [in] corners Four corners of rectangle in image space.
 	* \param [in] sourceImage Image in which the rectangle is located.
 	* \param [out] isolatedImage Image to which the rectangle is warped.
-	* \param [out] homographyMatrix Homography matrix used to warp perspective from source image to isolated image.
+	* \param [out] homographyMatrix Homography matrix used to warp perspective from the undistorted source image to isolated image.
 	*/
 	void isolateRectangle(const std::vector<cv::Point>& corners, const cv::Mat& sourceImage, cv::Mat& isolatedImage, cv::Mat& homographyMatrix) const;
 
 	/*!
-	* Find the identifier of an isolated fiducial image.
+	* Compute the maps used to remove lens distortion from regions of the image.
+	*
+	* \param [in] imageSize Size of the images to undistort.
+	*/
+	void initUndistortMaps(const cv::Size& imageSize);
+
+	/*!
+	* Remove lens distortion from a region of an image. Only the pixels in the region are remapped.
+	*
+	* \param [in] image Distorted image.
+	* \param [in] region Region of the undistorted image to compute.
+	* \param [out] undistortedRegion Undistorted image region.
+	*/
+	void undistortRegion(const cv::Mat& image, const cv::Rect& region, cv::Mat& undistortedRegion) const;
+
+	/*!
+	* Find the identifier of an isolated fiducial image. All nine cells are decoded with the \class FiducialDictionary,
+	* which corrects a single misclassified cell or two cells that could not be classified.
 	* 
 	* \param inputImage Input fiducial image.
 	* \param outputImage Correctly oriented fiducial image.
 	* \param outputImage Correctly oriented fiducial image with annotations.
+	* \param confidence Decoding confidence in the range [0, 1].
 	* \return Fiducial identifer. Returns -1 if not a valid fiducial.
 	*/
-	int identifyFiducial(const cv::Mat& inputImage, cv::Mat& outputImage, cv::Mat& annotatedFiducial) const;
+	int identifyFiducial(const cv::Mat& inputImage, cv::Mat& outputImage, cv::Mat& annotatedFiducial, double& confidence) const;
 
 	/*!
 	* Identify the binary value of a fiducial square.
@@ -264,14 +633,22 @@ private:
 	float mapToCubeAngle(float angle) const;
 
 	/*!
-	* Compute the angle of rotation about the z-axis based on the corners of the cube contour.
-	* 
-	* \param [in] corners Corners of the cube contour with respect to the image frame in an anti-clockwise direction.
-	* \param [in] z Z coordinate of the xy plane to estimate the orientation of the cube in.
-	* \param [in] centroid Centroid of the top cube face contour with respect to the image frame.
-	* \return Estimated rotation of cube about z-axis in radians.
+	* Get the homography mapping the undistorted image frame to a horizontal plane in the world frame. Homographies are
+	* cached until the extrinsic parameters change.
+	*
+	* \param [in] z Height of the plane in the world frame.
+	* \return Homography matrix from the undistorted image frame to the plane.
+	*/
+	cv::Mat getLayerHomography(const int z) const;
+
+	/*!
+	* Estimate the pose of a cube by fitting a square to the corners of the cube top face in the plane of the top face.
+	*
+	* \param [in] cube Contour of the cube top face.
+	* \param [in] z Height of the cube top face in the world frame.
+	* \return Estimated cube pose.
 	*/
-	float computeCubeZRotation(const std::vector<cv::Point>& corners, const cv::Point centroid, const int z) const;
+	CubePose estimateCubePose(const CubeContour& cube, const int z) const;
 
 	/*!
 	* Compute the Euclidean distance between two points in 3D space.
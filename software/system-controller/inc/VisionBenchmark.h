@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Vision.h"
+#include "SessionRecorder.h"
+#include "Logger.h"
+#include "opencv2/opencv.hpp"
+#include <QObject>
+#include <QJsonObject>
+#include <QStringList>
+#include <QMap>
+
+/*!
+* Measures the performance of the computer vision system by processing a set of recorded or synthetic frames offline.
+* The benchmark reports the frame throughput, the latency distribution of each processing stage, the number of image
+* buffer allocations made per frame and, for frames with a ground truth scene description, the detection accuracy of the
+* independent cubes and fiducials. Results are written as JSON so that the performance of different builds can be compared.
+*
+* The input is either a single session file or image file, or a directory containing session files and image files.
+* Image files are processed as calibration frames without source or structure cube centroids.
+*/
+class VisionBenchmark : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	VisionBenchmark(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the number of times each frame is processed. Repeated processing reduces the variance of the latency measurements.
+	*
+	* \param [in] iterations Number of times each frame is processed.
+	*/
+	void setIterations(int iterations);
+
+	/*!
+	* Set the maximum distance between a detected cube and a ground truth cube for the detection to be considered correct.
+	*
+	* \param [in] distance Match distance in horizontal steps.
+	*/
+	void setMatchDistance(double distance);
+
+	/*!
+	* Process all frames found at the input path. Results from previous runs are discarded.
+	*
+	* \param [in] inputPath Path of a session file, an image file or a directory containing session and image files.
+	* \return True if at least one frame was processed. False otherwise.
+	*/
+	bool run(const QString& inputPath);
+
+	/*!
+	* Getter for the results of the most recent run.
+	*
+	* \return Benchmark results.
+	*/
+	QJsonObject getResults() const;
+
+	/*!
+	* Write the results of the most recent run to a JSON file.
+	*
+	* \param [in] fileName Path of the results file.
+	* \return True if the results were written. False otherwise.
+	*/
+	bool writeResults(const QString& fileName) const;
+
+signals:
+	/*!
+	* Generated when a message is logged by a \class VisionBenchmark instance.
+	*/
+	void log(Message message) const;
+
+private:
+	int iterations = 1; /*! Number of times each frame is processed */
+	double matchDistance = 32; /*! Maximum distance between a detected cube and a ground truth cube in horizontal steps */
+	QStringList inputFiles; /*! Files processed in the most recent run */
+	int frameCount = 0; /*! Number of frames processed */
+	int failedFrames = 0; /*! Number of frames that could not be read */
+	double processingTime = 0; /*! Total time spent processing scenes in milliseconds */
+	QMap<QString, std::vector<double>> stageLatencies; /*! Latency samples of each processing stage in milliseconds */
+	std::vector<double> matAllocations; /*! Number of image buffer allocations made for each processed scene */
+
+	// Accuracy statistics
+	int calibrationFrames = 0; /*! Number of frames processed with the calibration flag set */
+	int calibratedFrames = 0; /*! Number of calibration frames that resulted in a calibrated system */
+	std::vector<double> reprojectionErrors; /*! Fiducial reprojection error of each calibrated calibration frame in pixels */
+	int truthFrames = 0; /*! Number of frames with a ground truth scene description */
+	int truePositives = 0; /*! Number of detected cubes matched to a ground truth cube */
+	int falsePositives = 0; /*! Number of detected cubes not matched to a ground truth cube */
+	int falseNegatives = 0; /*! Number of ground truth cubes not matched to a detected cube */
+	std::vector<double> positionErrors; /*! Position error of each matched cube in horizontal steps */
+	std::vector<double> rotationErrors; /*! Rotation error of each matched cube in degrees */
+	int truthFiducials = 0; /*! Number of ground truth fiducials */
+	int foundFiducials = 0; /*! Number of ground truth fiducials identified */
+	int falseFiducials = 0; /*! Number of identified fiducials not in the ground truth */
+
+	/*!
+	* Reset the results of the previous run.
+	*/
+	void reset();
+
+	/*!
+	* Process all frames in a session file.
+	*
+	* \param [in] fileName Path of the session file.
+	*/
+	void processSession(const QString& fileName);
+
+	/*!
+	* Process a frame and record the performance and accuracy measurements.
+	*
+	* \param [in] vision Computer vision system used to process the frame.
+	* \param [in] frame Frame to process.
+	*/
+	void processFrame(Vision& vision, SessionFrame& frame);
+
+	/*!
+	* Compare the scene detected by the computer vision system to the ground truth scene description of a frame.
+	*
+	* \param [in] vision Computer vision system that processed the frame.
+	* \param [in] frame Processed frame.
+	*/
+	void evaluateAccuracy(const Vision& vision, const SessionFrame& frame);
+
+	/*!
+	* Summarize a set of samples with the mean, the maximum and the 50th, 95th and 99th percentiles.
+	*
+	* \param [in] samples Samples to summarize.
+	* \return Summary statistics.
+	*/
+	static QJsonObject summarize(std::vector<double> samples);
+};
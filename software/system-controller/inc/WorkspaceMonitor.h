@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Logger.h"
+#include "opencv2/opencv.hpp"
+#include <QObject>
+#include <QMutex>
+
+/*!
+* Detects unexpected changes in regions of the workspace while the robot is moving. Each monitored region is compared to
+* a reference image captured when the computer vision system last processed the scene. The comparison runs at a low
+* rate on downsampled, mean-normalized patches so that it is cheap enough to run on the capture thread and insensitive
+* to global changes in illumination. Regions that overlap an occluded region, such as the space swept by the robot,
+* are skipped.
+*
+* Frames are passed to \class processFrame, which is safe to call from the capture thread while the monitor is
+* configured from the user interface thread.
+*/
+class WorkspaceMonitor : public QObject
+{
+	Q_OBJECT
+public:
+	/*!
+	* Class constructor.
+	*
+	* \param [in] parent Parent object.
+	*/
+	WorkspaceMonitor(QObject* parent = Q_NULLPTR);
+
+	/*!
+	* Set the regions to monitor and their reference image.
+	*
+	* \param [in] image Reference image of the workspace.
+	* \param [in] regions Regions of the image to monitor.
+	*/
+	void setReference(const cv::Mat& image, const std::vector<cv::Rect>& regions);
+
+	/*!
+	* Stop monitoring all regions.
+	*/
+	void clearReference();
+
+	/*!
+	* Set the regions of the image in which changes are expected and should be ignored.
+	*
+	* \param [in] regions Occluded regions of the image.
+	*/
+	void setOccludedRegions(const std::vector<cv::Rect>& regions);
+
+	/*!
+	* Set the minimum time between checks for changes.
+	*
+	* \param [in] interval Minimum time between checks in milliseconds.
+	*/
+	void setCheckInterval(int interval);
+
+	/*!
+	* Set the mean absolute intensity difference from the reference at which a region is considered changed.
+	*
+	* \param [in] threshold Change threshold in intensity levels.
+	*/
+	void setChangeThreshold(double threshold);
+
+	/*!
+	* Check a captured frame for changes in the monitored regions if the check interval has elapsed. A disturbance is
+	* reported once for each region that remains changed for consecutive checks.
+	*
+	* \param [in] frame Captured frame.
+	* \param [in] timestamp Time in milliseconds at which the frame was captured.
+	*/
+	void processFrame(const cv::Mat& frame, qint64 timestamp);
+
+signals:
+	/*!
+	* Generated when a monitored region changed unexpectedly.
+	*
+	* \param [in] region Index of the changed region in the region list provided to \class setReference.
+	*/
+	void disturbanceDetected(int region) const;
+
+	/*!
+	* Generated when a message is logged by a \class WorkspaceMonitor instance.
+	*/
+	void log(Message message) const;
+
+private:
+	/*!
+	* Monitored region of the workspace.
+	*/
+	struct MonitoredRegion
+	{
+		cv::Rect region; /*! Region of the image */
+		cv::Mat reference; /*! Normalized reference patch */
+		int changedChecks; /*! Number of consecutive checks in which the region was changed */
+		bool reported; /*! Indicates if a disturbance has been reported for the region */
+	};
+
+	mutable QMutex mutex; /*! Protects the monitor configuration from concurrent access by the capture thread */
+	std::vector<MonitoredRegion> regions; /*! Monitored regions */
+	std::vector<cv::Rect> occludedRegions; /*! Regions in which changes are ignored */
+	qint64 lastCheck = -1; /*! Timestamp of the most recent check */
+	int checkInterval = 250; /*! Minimum time between checks in milliseconds */
+	double changeThreshold = 30; /*! Mean absolute intensity difference at which a region is considered changed */
+	const int CONFIRM_CHECKS = 2; /*! Number of consecutive changed checks required to report a disturbance */
+	const int DOWNSAMPLE = 4; /*! Factor by which patches are downsampled */
+
+	/*!
+	* Extract a downsampled grayscale patch with its mean intensity removed.
+	*
+	* \param [in] image Source image.
+	* \param [in] region Region of the image.
+	* \return Normalized patch.
+	*/
+	cv::Mat getPatch(const cv::Mat& image, const cv::Rect& region) const;
+};
@@ -0,0 +1,94 @@
+#include "BuildSimulator.h"
+
+BuildSimulator::BuildSimulator() {}
+
+void BuildSimulator::setMotionModel(const MotionModel& motionModel)
+{
+	this->motionModel = motionModel;
+}
+
+void BuildSimulator::setVisionPosition(const RobotPosition& position)
+{
+	visionPosition = position;
+}
+
+void BuildSimulator::setVerificationInterval(int interval)
+{
+	verificationInterval = interval;
+}
+
+void BuildSimulator::setVisionTimes(double sceneTime, double verifyTime)
+{
+	this->sceneTime = sceneTime;
+	this->verifyTime = verifyTime;
+}
+
+BuildEstimate BuildSimulator::simulate(const QList<CubeTask*>& tasks, const RobotPosition& start,
+	ClearancePlanner* clearancePlanner, const QVector<Cube*>& cubes) const
+{
+	// The simulated policy receives no failures or pressure readings since the construction is assumed to be nominal
+	VerificationPolicy verificationPolicy;
+	verificationPolicy.setSamplingInterval(verificationInterval);
+
+	// The construction starts with a move to the vision height and the full scene is processed at the vision position
+	BuildEstimate estimate;
+	RobotPosition raised = { 0, 0, visionPosition.z, 0 };
+	estimate.vision = motionModel.getMoveTime(start, raised) + motionModel.getMoveTime(raised, visionPosition) + sceneTime;
+
+	// The cubes placed during the simulation are mapped as obstacles at their destinations
+	QVector<Cube*> obstacles = cubes;
+	QList<Cube*> placedCubes;
+
+	RobotPosition position = visionPosition;
+	for (int i = 0; i < tasks.size(); ++i)
+	{
+		if (tasks[i]->getSourceCube() == Q_NULLPTR)
+			continue;
+
+		if (clearancePlanner != Q_NULLPTR)
+		{
+			obstacles.removeOne(tasks[i]->getSourceCube());
+			clearancePlanner->setObstacles(obstacles);
+		}
+
+		CubeBuildTime cube;
+		cube.destinationCube = tasks[i]->getDestinationCube();
+		cube.layer = round((cube.destinationCube->getPosition().y - 32) / 64);
+		cube.task = tasks[i]->estimateTiming(motionModel, position, Q_NULLPTR, &position);
+
+		if (clearancePlanner != Q_NULLPTR)
+		{
+			glm::vec3 destination = tasks[i]->getDestinationTopFace();
+			Cube* placedCube = new Cube(placedCubes.size(), 64, Q_NULLPTR);
+			placedCube->setPosition(glm::vec3(destination.x, destination.z - 32, destination.y));
+			placedCubes.append(placedCube);
+			obstacles.append(placedCube);
+		}
+
+		// The full scene is processed at the vision position after the last cube is placed
+		if (i == tasks.size() - 1)
+		{
+			cube.verify = motionModel.getMoveTime(position, visionPosition) + sceneTime;
+			position = visionPosition;
+		}
+		else
+		{
+			QString reason;
+			if (verificationPolicy.decide(cube.layer, reason) != VerificationLevel::NONE)
+			{
+				RobotPosition verifyPosition = { position.x, position.y, visionPosition.z, position.r };
+				cube.verify = motionModel.getMoveTime(position, verifyPosition) + verifyTime;
+				position = verifyPosition;
+			}
+		}
+
+		estimate.total += cube.getDuration();
+		estimate.cubes.push_back(cube);
+	}
+
+	for (Cube* placedCube : placedCubes)
+		delete placedCube;
+
+	estimate.total += estimate.vision;
+	return estimate;
+}
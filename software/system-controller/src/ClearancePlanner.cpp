@@ -0,0 +1,150 @@
+#include "ClearancePlanner.h"
+#include <algorithm>
+#include <cmath>
+
+ClearancePlanner::ClearancePlanner()
+{
+	heights.assign(mapCols * mapRows, 0);
+}
+
+void ClearancePlanner::setMotionModel(const MotionModel& motionModel)
+{
+	this->motionModel = motionModel;
+}
+
+void ClearancePlanner::setObstacles(const QVector<Cube*>& cubes)
+{
+	heights.assign(mapCols * mapRows, 0);
+
+	// Raise the cells within the dilation radius of each cube to the height of its top face
+	// The OpenGL coordinates of the cube are converted to the robot coordinate system here
+	for (const Cube* cube : cubes)
+	{
+		glm::vec3 position = cube->getPosition();
+		int top = round((position.y + cubeLengthHSteps / 2) * cubeLengthVSteps / cubeLengthHSteps);
+		int minCol = std::max((int) floor((position.x - dilationRadius - mapMinX) / cellLength), 0);
+		int maxCol = std::min((int) floor((position.x + dilationRadius - mapMinX) / cellLength), mapCols - 1);
+		int minRow = std::max((int) floor((position.z - dilationRadius - mapMinY) / cellLength), 0);
+		int maxRow = std::min((int) floor((position.z + dilationRadius - mapMinY) / cellLength), mapRows - 1);
+
+		for (int row = minRow; row <= maxRow; ++row)
+		{
+			for (int col = minCol; col <= maxCol; ++col)
+				heights[row * mapCols + col] = std::max(heights[row * mapCols + col], top);
+		}
+	}
+}
+
+int ClearancePlanner::getClearanceHeight(int x, int y, bool carrying) const
+{
+	return getMapHeight(x, y) + (carrying ? cubeLengthVSteps : 0) + clearanceMargin;
+}
+
+int ClearancePlanner::getTraverseHeight(const RobotPosition& start, const RobotPosition& end, bool carrying) const
+{
+	// Sample the trajectory of the x-axis and y-axis motors
+	RobotPosition horizontalEnd = end;
+	horizontalEnd.z = start.z;
+	horizontalEnd.r = start.r;
+	double duration = motionModel.getMoveTime(start, horizontalEnd);
+	int samples = std::max((int) ceil(duration / sampleInterval), 1);
+
+	int height = 0;
+	for (int i = 0; i <= samples; ++i)
+	{
+		RobotPosition position = motionModel.getMovePosition(start, horizontalEnd, duration * i / samples);
+		height = std::max(height, getClearanceHeight(position.x, position.y, carrying));
+	}
+
+	return height;
+}
+
+bool ClearancePlanner::isMoveClear(const RobotPosition& start, const RobotPosition& end, bool carrying) const
+{
+	double duration = motionModel.getMoveTime(start, end);
+	int samples = std::max((int) ceil(duration / sampleInterval), 1);
+
+	for (int i = 0; i <= samples; ++i)
+	{
+		RobotPosition position = motionModel.getMovePosition(start, end, duration * i / samples);
+		if (position.z < getClearanceHeight(position.x, position.y, carrying))
+			return false;
+	}
+
+	return true;
+}
+
+QList<RobotPosition> ClearancePlanner::planTransfer(const RobotPosition& start, const RobotPosition& end, bool carrying) const
+{
+	// Leave the start position and arrive at the end position vertically at their clearance heights
+	RobotPosition departure = start;
+	departure.z = std::max(start.z, getClearanceHeight(start.x, start.y, carrying));
+	RobotPosition approach = end;
+	approach.z = std::max(end.z, getClearanceHeight(end.x, end.y, carrying));
+
+	// Traverse at the minimum height that clears the workspace, which is at least the clearance height at both ends
+	int height = getTraverseHeight(departure, approach, carrying);
+	RobotPosition raised = { departure.x, departure.y, height, departure.r };
+	RobotPosition lowered = { approach.x, approach.y, height, approach.r };
+
+	// The separate lift, traverse and descent moves always clear the workspace since only the traverse moves horizontally
+	QList<QList<RobotPosition>> candidates;
+	candidates.append({ departure, raised, lowered, approach, end });
+	if (isMoveClear(departure, lowered, carrying))
+		candidates.append({ departure, lowered, approach, end });
+	if (isMoveClear(raised, approach, carrying))
+		candidates.append({ departure, raised, approach, end });
+	if (isMoveClear(departure, approach, carrying))
+		candidates.append({ departure, approach, end });
+
+	// Choose the quickest candidate after removing the moves that do not change the position
+	QList<RobotPosition> bestPath;
+	double bestDuration = -1;
+	for (const QList<RobotPosition>& candidate : candidates)
+	{
+		QList<RobotPosition> path;
+		RobotPosition position = start;
+		for (const RobotPosition& waypoint : candidate)
+		{
+			if (waypoint != position)
+				path.append(waypoint);
+			position = waypoint;
+		}
+
+		double duration = getPathDuration(start, path);
+		if (bestDuration < 0 || duration < bestDuration)
+		{
+			bestDuration = duration;
+			bestPath = path;
+		}
+	}
+
+	// Move to the end position even if the robot is already there so that a command is always issued
+	if (bestPath.isEmpty())
+		bestPath.append(end);
+
+	return bestPath;
+}
+
+int ClearancePlanner::getMapHeight(int x, int y) const
+{
+	int col = floor((double) (x - mapMinX) / cellLength);
+	int row = floor((double) (y - mapMinY) / cellLength);
+	if (col < 0 || col >= mapCols || row < 0 || row >= mapRows)
+		return 0;
+
+	return heights[row * mapCols + col];
+}
+
+double ClearancePlanner::getPathDuration(const RobotPosition& start, const QList<RobotPosition>& path) const
+{
+	double duration = 0;
+	RobotPosition position = start;
+	for (const RobotPosition& waypoint : path)
+	{
+		duration += motionModel.getMoveTime(position, waypoint);
+		position = waypoint;
+	}
+
+	return duration;
+}
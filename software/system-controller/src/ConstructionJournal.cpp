@@ -0,0 +1,198 @@
+#include "ConstructionJournal.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+ConstructionJournal::ConstructionJournal(QObject* parent) : QObject(parent) {}
+
+void ConstructionJournal::setFileName(const QString& fileName)
+{
+	this->fileName = fileName;
+}
+
+bool ConstructionJournal::exists() const
+{
+	return QFile::exists(fileName);
+}
+
+bool ConstructionJournal::write(const ConstructionCheckpoint& checkpoint)
+{
+	QJsonArray taskCubeIds;
+	for (int id : checkpoint.taskCubeIds)
+		taskCubeIds.append(id);
+
+	QJsonArray sourceCubes;
+	for (const QJsonObject& cube : checkpoint.sourceCubes)
+		sourceCubes.append(cube);
+
+	QJsonArray structCubes;
+	for (const QJsonObject& cube : checkpoint.structCubes)
+		structCubes.append(cube);
+
+	QJsonArray structCubeIds;
+	for (int id : checkpoint.structCubeIds)
+		structCubeIds.append(id);
+
+	QJsonObject placement;
+	placement["x"] = checkpoint.placement.x;
+	placement["y"] = checkpoint.placement.y;
+	placement["orientation"] = checkpoint.placement.orientation;
+
+	QJsonObject json;
+	json["version"] = JOURNAL_VERSION;
+	json["buildModel"] = checkpoint.buildModel;
+	json["placement"] = placement;
+	json["taskCubeIds"] = taskCubeIds;
+	json["sourceCubes"] = sourceCubes;
+	json["structCubes"] = structCubes;
+	json["structCubeIds"] = structCubeIds;
+	json["taskSourceCube"] = checkpoint.taskSourceCube;
+	json["taskStarted"] = checkpoint.taskStarted;
+	json["taskReleased"] = checkpoint.taskReleased;
+	json["missingCubes"] = checkpoint.missingCubes;
+	json["externalCubes"] = checkpoint.externalCubes;
+
+	// The journal file is only replaced once the checkpoint has been written completely
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(json).toJson(QJsonDocument::Compact) + "\n") < 0 || !file.commit())
+	{
+		if (!writeFailed)
+			emit log(Message(MessageType::ERROR_LOG, "Construction Journal", "Failed to write checkpoint: " + file.errorString()));
+		writeFailed = true;
+		return false;
+	}
+
+	writeFailed = false;
+	return true;
+}
+
+bool ConstructionJournal::append(TaskProgress progress, const QJsonObject& cube)
+{
+	QJsonObject json;
+	json["progress"] = (int) progress;
+	json["cube"] = cube;
+
+	// A record can only follow a checkpoint
+	QFile file(fileName);
+	if (!QFile::exists(fileName) || !file.open(QIODevice::WriteOnly | QIODevice::Append)
+		|| file.write(QJsonDocument(json).toJson(QJsonDocument::Compact) + "\n") < 0 || !file.flush())
+	{
+		if (!writeFailed)
+			emit log(Message(MessageType::ERROR_LOG, "Construction Journal", "Failed to append record: " + file.errorString()));
+		writeFailed = true;
+		return false;
+	}
+
+	writeFailed = false;
+	return true;
+}
+
+bool ConstructionJournal::read(ConstructionCheckpoint& checkpoint)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Construction Journal", "Failed to open journal: " + file.errorString()));
+		return false;
+	}
+
+	QList<QByteArray> lines = file.readAll().split('\n');
+	file.close();
+
+	QJsonParseError jsonError;
+	QJsonDocument document = QJsonDocument::fromJson(lines[0], &jsonError);
+	if (jsonError.error != QJsonParseError::NoError || !document.isObject())
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Construction Journal", "Failed to read journal: " + jsonError.errorString()));
+		return false;
+	}
+
+	QJsonObject json = document.object();
+	if (json["version"].toInt() != JOURNAL_VERSION || !json["buildModel"].isObject() || !json["taskCubeIds"].isArray())
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Construction Journal", "Journal format is not supported"));
+		return false;
+	}
+
+	checkpoint = ConstructionCheckpoint();
+	checkpoint.buildModel = json["buildModel"].toObject();
+
+	// Journals written before the structure placement was configurable use the default placement
+	if (json["placement"].isObject())
+	{
+		QJsonObject placement = json["placement"].toObject();
+		checkpoint.placement.x = placement["x"].toInt();
+		checkpoint.placement.y = placement["y"].toInt();
+		checkpoint.placement.orientation = placement["orientation"].toInt();
+	}
+
+	QJsonArray taskCubeIds = json["taskCubeIds"].toArray();
+	for (int i = 0; i < taskCubeIds.size(); ++i)
+		checkpoint.taskCubeIds.append(taskCubeIds[i].toInt());
+
+	QJsonArray sourceCubes = json["sourceCubes"].toArray();
+	for (int i = 0; i < sourceCubes.size(); ++i)
+		checkpoint.sourceCubes.append(sourceCubes[i].toObject());
+
+	QJsonArray structCubes = json["structCubes"].toArray();
+	QJsonArray structCubeIds = json["structCubeIds"].toArray();
+	for (int i = 0; i < structCubes.size(); ++i)
+	{
+		checkpoint.structCubes.append(structCubes[i].toObject());
+		checkpoint.structCubeIds.append(i < structCubeIds.size() ? structCubeIds[i].toInt() : -1);
+	}
+
+	checkpoint.taskSourceCube = json["taskSourceCube"].toObject();
+	checkpoint.taskStarted = json["taskStarted"].toBool();
+	checkpoint.taskReleased = json["taskReleased"].toBool();
+	checkpoint.missingCubes = json["missingCubes"].toInt();
+	checkpoint.externalCubes = json["externalCubes"].toInt();
+
+	// Apply the progress of the cube tasks recorded after the checkpoint
+	// The records end at the first record which was not written completely
+	for (int i = 1; i < lines.size(); ++i)
+	{
+		QJsonDocument recordDocument = QJsonDocument::fromJson(lines[i], &jsonError);
+		if (jsonError.error != QJsonParseError::NoError || !recordDocument.isObject())
+			break;
+
+		QJsonObject record = recordDocument.object();
+		QJsonObject cube = record["cube"].toObject();
+		switch ((TaskProgress) record["progress"].toInt())
+		{
+		case TaskProgress::STARTED:
+			// The source cube of the task has left the source cubes
+			for (int j = 0; j < checkpoint.sourceCubes.size(); ++j)
+			{
+				if (checkpoint.sourceCubes[j]["cubeID"].toInt() == cube["cubeID"].toInt())
+				{
+					checkpoint.sourceCubes.removeAt(j);
+					break;
+				}
+			}
+			checkpoint.taskSourceCube = cube;
+			checkpoint.taskStarted = true;
+			break;
+		case TaskProgress::RELEASED:
+			checkpoint.taskReleased = true;
+			break;
+		case TaskProgress::PLACED:
+			// The placed cube joins the structure and the next task becomes the first incomplete task
+			checkpoint.structCubes.append(cube);
+			checkpoint.structCubeIds.append(checkpoint.taskCubeIds.isEmpty() ? -1 : checkpoint.taskCubeIds.takeFirst());
+			checkpoint.taskSourceCube = QJsonObject();
+			checkpoint.taskStarted = false;
+			checkpoint.taskReleased = false;
+			break;
+		}
+	}
+
+	return true;
+}
+
+void ConstructionJournal::clear()
+{
+	if (QFile::exists(fileName))
+		QFile::remove(fileName);
+}
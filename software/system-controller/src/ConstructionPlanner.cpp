@@ -0,0 +1,247 @@
+#include "ConstructionPlanner.h"
+#include <unordered_map>
+#include <cmath>
+#include <algorithm>
+
+ConstructionPlanner::ConstructionPlanner(QObject* parent) : QObject(parent)
+{
+	cost = defaultCost;
+}
+
+void ConstructionPlanner::setCostFunction(const PlacementCost& cost)
+{
+	this->cost = cost ? cost : PlacementCost(defaultCost);
+}
+
+bool ConstructionPlanner::plan(const CubeWorldModel* model)
+{
+	if (!buildGraph(model))
+		return false;
+
+	return replan();
+}
+
+bool ConstructionPlanner::replan()
+{
+	buildOrder.clear();
+
+	// Count the unplaced prerequisites of each cube and find the cubes without prerequisites
+	std::vector<int> remaining(nodes.size());
+	std::vector<int> ready;
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		remaining[i] = nodes[i].predecessors.size();
+		if (remaining[i] == 0)
+			ready.push_back(i);
+	}
+
+	// Repeatedly place the ready cube with the lowest cost and release its successors
+	const Cube* previousCube = Q_NULLPTR;
+	while (!ready.empty())
+	{
+		int best = 0;
+		double bestCost = cost(nodes[ready[0]].cube, previousCube);
+		for (int i = 1; i < ready.size(); ++i)
+		{
+			double candidateCost = cost(nodes[ready[i]].cube, previousCube);
+			if (candidateCost < bestCost)
+			{
+				bestCost = candidateCost;
+				best = i;
+			}
+		}
+
+		int node = ready[best];
+		ready[best] = ready.back();
+		ready.pop_back();
+
+		buildOrder.append(nodes[node].cube);
+		previousCube = nodes[node].cube;
+
+		for (int successor : nodes[node].successors)
+		{
+			if (--remaining[successor] == 0)
+				ready.push_back(successor);
+		}
+	}
+
+	// Cubes remain unplaced if the constraints are cyclic
+	if (buildOrder.size() != nodes.size())
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Construction Planner", "No build order satisfies the cube constraints"));
+		buildOrder.clear();
+		return false;
+	}
+
+	return true;
+}
+
+QList<Cube*> ConstructionPlanner::getBuildOrder() const
+{
+	return buildOrder;
+}
+
+QList<Cube*> ConstructionPlanner::getPrerequisites(const Cube* cube) const
+{
+	QList<Cube*> prerequisites;
+	if (!nodeIndices.contains(cube))
+		return prerequisites;
+
+	for (int predecessor : nodes[nodeIndices.value(cube)].predecessors)
+		prerequisites.append(nodes[predecessor].cube);
+
+	return prerequisites;
+}
+
+bool ConstructionPlanner::isValidOrder(const QList<Cube*>& order) const
+{
+	if (order.size() != nodes.size())
+		return false;
+
+	// Record the position of each cube in the order
+	std::vector<int> positions(nodes.size(), -1);
+	for (int i = 0; i < order.size(); ++i)
+	{
+		if (!nodeIndices.contains(order[i]))
+			return false;
+
+		int node = nodeIndices.value(order[i]);
+		if (positions[node] >= 0)
+			return false;
+		positions[node] = i;
+	}
+
+	// Verify every cube is placed after its prerequisites
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		for (int predecessor : nodes[i].predecessors)
+		{
+			if (positions[predecessor] > positions[i])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+double ConstructionPlanner::defaultCost(const Cube* cube, const Cube* previousCube)
+{
+	Q_UNUSED(previousCube);
+
+	// Order by layer, then decreasing z, then increasing x
+	// The weights separate the terms for any position in the workspace
+	glm::vec3 position = cube->getPosition();
+	return round(position.y) * 1e8 - round(position.z) * 1e4 + round(position.x);
+}
+
+bool ConstructionPlanner::buildGraph(const CubeWorldModel* model)
+{
+	nodes.clear();
+	nodeIndices.clear();
+	buildOrder.clear();
+
+	// Create a node for each cube
+	const QList<Cube*>* cubes = model->getCubes();
+	for (int i = 0; i < cubes->size(); ++i)
+	{
+		CubeNode node;
+		node.cube = cubes->at(i);
+		node.layer = model->getCubeLayer(*node.cube);
+		if (node.layer < 0)
+		{
+			emit log(Message(MessageType::ERROR_LOG, "Construction Planner", "Cannot plan a model with a cube outside the layers"));
+			nodes.clear();
+			nodeIndices.clear();
+			return false;
+		}
+
+		nodes.push_back(node);
+		nodeIndices.insert(node.cube, i);
+	}
+
+	if (nodes.empty())
+		return true;
+
+	// Bin the cubes in a grid with cells two cube lengths wide so that any cube within two cube lengths of a cube is
+	// in the same or a neighbouring cell of the same layer
+	double cellLength = 2.0 * nodes[0].cube->getSideLength();
+	auto cellKey = [](int layer, int col, int row) {
+		return ((long long) layer << 42) ^ ((long long) (col & 0x1FFFFF) << 21) ^ (long long) (row & 0x1FFFFF);
+	};
+
+	std::unordered_map<long long, std::vector<int>> grid;
+	std::vector<int> cols(nodes.size());
+	std::vector<int> rows(nodes.size());
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		glm::vec3 position = nodes[i].cube->getPosition();
+		cols[i] = floor(position.x / cellLength);
+		rows[i] = floor(position.z / cellLength);
+		grid[cellKey(nodes[i].layer, cols[i], rows[i])].push_back(i);
+	}
+
+	// Add an edge to each cube from the cubes below that support it and its preceding neighbours in the same layer
+	int unsupportedCubes = 0;
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		glm::vec3 position = nodes[i].cube->getPosition();
+		double sideLength = nodes[i].cube->getSideLength();
+		bool supported = nodes[i].layer == 0;
+
+		for (int layer = std::max(nodes[i].layer - 1, 0); layer <= nodes[i].layer; ++layer)
+		{
+			for (int col = cols[i] - 1; col <= cols[i] + 1; ++col)
+			{
+				for (int row = rows[i] - 1; row <= rows[i] + 1; ++row)
+				{
+					auto cell = grid.find(cellKey(layer, col, row));
+					if (cell == grid.end())
+						continue;
+
+					for (int j : cell->second)
+					{
+						if (j == i)
+							continue;
+
+						glm::vec3 otherPosition = nodes[j].cube->getPosition();
+						double dx = std::abs(position.x - otherPosition.x);
+						double dz = std::abs(position.z - otherPosition.z);
+
+						// A cube below supports the cube if their footprints overlap
+						bool support = layer < nodes[i].layer && dx < sideLength && dz < sideLength;
+
+						// A neighbouring cube in the same layer is within one cube length and the margin between cubes
+						bool neighbour = layer == nodes[i].layer && dx < 2 * sideLength && dz < 2 * sideLength && precedes(nodes[j].cube, nodes[i].cube);
+
+						if (support || neighbour)
+						{
+							nodes[i].predecessors.push_back(j);
+							nodes[j].successors.push_back(i);
+						}
+
+						supported = supported || support;
+					}
+				}
+			}
+		}
+
+		if (!supported)
+			unsupportedCubes++;
+	}
+
+	if (unsupportedCubes > 0)
+	{
+		emit log(Message(MessageType::WARNING_LOG, "Construction Planner", QString::number(unsupportedCubes)
+			+ " cubes are not supported by a cube in the layer below"));
+	}
+
+	return true;
+}
+
+bool ConstructionPlanner::precedes(const Cube* a, const Cube* b)
+{
+	// Neighbouring cubes are placed in order of decreasing z, then increasing x
+	int az = round(a->getPosition().z);
+	int bz = round(b->getPosition().z);
+	return az > bz || (az == bz && round(a->getPosition().x) < round(b->getPosition().x));
+}
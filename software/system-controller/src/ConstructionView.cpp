@@ -17,6 +17,7 @@ enum class RobotCommandState
     IDLE,
     CONSTRUCT_TASK,
     CONSTRUCT_VISION,
+    CONSTRUCT_VERIFY,
     PROCESS_SCENE
 };
 
@@ -33,6 +34,44 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     connect(cubeBuildModel, &CubeWorldModel::log, this, &ConstructionView::log);
     connect(cubeWorldModel, &CubeWorldModel::log, this, &ConstructionView::log);
 
+    // Initialize computer vision session recorder
+    sessionRecorder = new SessionRecorder(this);
+    connect(sessionRecorder, &SessionRecorder::log, this, &ConstructionView::log);
+
+    // Initialize multi-camera computer vision system
+    multiCameraVision = new MultiCameraVision(this);
+    connect(multiCameraVision, &MultiCameraVision::log, this, &ConstructionView::log);
+
+    // Initialize construction planner
+    constructionPlanner = new ConstructionPlanner(this);
+    connect(constructionPlanner, &ConstructionPlanner::log, this, &ConstructionView::log);
+
+    // Initialize cube task sequencer
+    taskSequencer = new TaskSequencer(this);
+    connect(taskSequencer, &TaskSequencer::log, this, &ConstructionView::log);
+
+    // Initialize source cube assigner
+    sourceAssigner = new SourceAssigner(this);
+    connect(sourceAssigner, &SourceAssigner::log, this, &ConstructionView::log);
+
+    // Initialize construction journal to resume an interrupted construction
+    constructionJournal = new ConstructionJournal(this);
+    connect(constructionJournal, &ConstructionJournal::log, this, &ConstructionView::log);
+
+    // Initialize recovery planner to replan the construction after a failure
+    recoveryPlanner = new RecoveryPlanner(this);
+    recoveryPlanner->setTolerances(PLACEMENT_POSITION_TOLERANCE, PLACEMENT_ROTATION_TOLERANCE);
+    connect(recoveryPlanner, &RecoveryPlanner::log, this, &ConstructionView::log);
+
+    // Initialize layout planner to place the structure and source magazine
+    layoutPlanner = new LayoutPlanner(this);
+    connect(layoutPlanner, &LayoutPlanner::log, this, &ConstructionView::log);
+
+    // Initialize workspace monitor to detect cubes disturbed while the robot moves
+    workspaceMonitor = new WorkspaceMonitor(this);
+    connect(workspaceMonitor, &WorkspaceMonitor::log, this, &ConstructionView::log);
+    connect(workspaceMonitor, &WorkspaceMonitor::disturbanceDetected, this, &ConstructionView::workspaceDisturbanceDetected);
+
     // Initialize OpenGL view for the 3D shapes
     shapeView = new OpenGLView();
     shapeView->setCubes(cubeBuildModel->getCubes());
@@ -47,7 +86,11 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     showModelView = new QPushButton("Show Model View");
     loadModel = new QPushButton("Load Model");
     execute = new QPushButton("Start Construction");
+    estimateBuild = new QPushButton("Estimate Build");
+    planLayout = new QPushButton("Plan Layout");
+    resumeConstruction = new QPushButton("Resume Construction");
     processScene = new QPushButton("Process Scene");
+    recordSession = new QPushButton("Record Session");
     sleepRobot = new QPushButton("Sleep");
     wakeRobot = new QPushButton("Wake");
     calibrateRobot = new QPushButton("Calibrate");
@@ -56,12 +99,18 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     releaseRobotActuator = new QPushButton("Actuator->Release");
     executeQTP3 = new QPushButton("Execute QTP 3");
 
+    recordSession->setCheckable(true);
+
     int maxWidth = 200;
     showVisionView->setMaximumWidth(maxWidth);
     showModelView->setMaximumWidth(maxWidth);
     loadModel->setMaximumWidth(maxWidth);
     execute->setMaximumWidth(maxWidth);
+    estimateBuild->setMaximumWidth(maxWidth);
+    planLayout->setMaximumWidth(maxWidth);
+    resumeConstruction->setMaximumWidth(maxWidth);
     processScene->setMaximumWidth(maxWidth);
+    recordSession->setMaximumWidth(maxWidth);
     sleepRobot->setMaximumWidth(maxWidth);
     wakeRobot->setMaximumWidth(maxWidth);
     calibrateRobot->setMaximumWidth(maxWidth);
@@ -75,7 +124,11 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     connect(showModelView, &QPushButton::clicked, this, &ConstructionView::showModelViewClicked);
     connect(loadModel, &QPushButton::clicked, this, &ConstructionView::loadModelClicked);
     connect(execute, &QPushButton::clicked, this, &ConstructionView::executeConstruction);
+    connect(estimateBuild, &QPushButton::clicked, this, &ConstructionView::estimateBuildClicked);
+    connect(planLayout, &QPushButton::clicked, this, &ConstructionView::planLayoutClicked);
+    connect(resumeConstruction, &QPushButton::clicked, this, &ConstructionView::resumeConstructionClicked);
     connect(processScene, &QPushButton::clicked, this, &ConstructionView::processSceneClicked);
+    connect(recordSession, &QPushButton::toggled, this, &ConstructionView::recordSessionToggled);
     connect(sleepRobot, &QPushButton::clicked, this, &ConstructionView::sleepRobotClicked);
     connect(wakeRobot, &QPushButton::clicked, this, &ConstructionView::wakeRobotClicked);
     connect(calibrateRobot, &QPushButton::clicked, this, &ConstructionView::calibrateRobotClicked);
@@ -90,7 +143,11 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     generalControlLayout->addWidget(loadModel);
     generalControlLayout->addWidget(calibrateRobot);
     generalControlLayout->addWidget(execute);
+    generalControlLayout->addWidget(estimateBuild);
+    generalControlLayout->addWidget(planLayout);
+    generalControlLayout->addWidget(resumeConstruction);
     generalControlLayout->addWidget(processScene);
+    generalControlLayout->addWidget(recordSession);
 
     // Initialize robot commands layout
     robotCommandLayout = new QVBoxLayout();
@@ -148,9 +205,20 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     
     pressureLabel->setMaximumWidth(200);
 
+    // Initialize placement verification sampling control
+    verificationIntervalLabel = new QLabel("Verify Placement Every");
+    verificationInterval = new QSpinBox();
+    verificationInterval->setRange(1, 50);
+    verificationInterval->setValue(5);
+    verificationInterval->setSuffix(" cubes");
+    verificationIntervalLabel->setMaximumWidth(maxWidth);
+    verificationInterval->setMaximumWidth(maxWidth);
+
     // Initialize robot statistics layout
     robotStatsLayout = new QVBoxLayout();
     robotStatsLayout->addWidget(pressureLabel);
+    robotStatsLayout->addWidget(verificationIntervalLabel);
+    robotStatsLayout->addWidget(verificationInterval);
 
     // Initialize robot controls layout
     controlLayout = new QHBoxLayout();
@@ -203,6 +271,15 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     worldPointYPos = new QSpinBox();
     worldPointZPos = new QSpinBox();
     projectWorldPoint = new QPushButton("Project point");
+    visionAdaptiveThreshold = new QCheckBox("Automatic Threshold");
+    visionThresholdLabel = new QLabel("Threshold: [0, 255]");
+    visionThresholdValue = new QSpinBox();
+    visionBlurLabel = new QLabel("Blur size: [0, 20]");
+    visionBlurSize = new QSpinBox();
+    visionAreaLabel = new QLabel("Min contour area (px)");
+    visionAreaThreshold = new QDoubleSpinBox();
+    visionCellLabel = new QLabel("Fiducial cell threshold: [0.5, 1]");
+    visionCellThreshold = new QDoubleSpinBox();
 
     visionStageGroup->addButton(visionInput);
     visionStageGroup->addButton(visionBlurred);
@@ -217,7 +294,32 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     worldPointZPos->setMaximumWidth(100);
     projectWorldPoint->setMaximumWidth(100);
 
+    // Initialize computer vision parameter controls from the current parameters
+    VisionParameters visionParameters = vision.getParameters();
+    visionThresholdValue->setRange(0, 255);
+    visionThresholdValue->setValue(visionParameters.threshold);
+    visionThresholdValue->setEnabled(!visionParameters.adaptiveThreshold);
+    visionAdaptiveThreshold->setChecked(visionParameters.adaptiveThreshold);
+    visionBlurSize->setRange(0, 20);
+    visionBlurSize->setValue(visionParameters.blurSize);
+    visionAreaThreshold->setRange(0, 100000);
+    visionAreaThreshold->setSingleStep(100);
+    visionAreaThreshold->setValue(visionParameters.areaThreshold);
+    visionCellThreshold->setRange(0.5, 1);
+    visionCellThreshold->setSingleStep(0.05);
+    visionCellThreshold->setValue(visionParameters.cellThreshold);
+
+    visionThresholdValue->setMaximumWidth(100);
+    visionBlurSize->setMaximumWidth(100);
+    visionAreaThreshold->setMaximumWidth(100);
+    visionCellThreshold->setMaximumWidth(100);
+
     connect(visionBack, &QPushButton::clicked, this, &ConstructionView::visionBackClicked);
+    connect(visionAdaptiveThreshold, &QCheckBox::toggled, this, &ConstructionView::visionParametersChanged);
+    connect(visionThresholdValue, &QSpinBox::valueChanged, this, &ConstructionView::visionParametersChanged);
+    connect(visionBlurSize, &QSpinBox::valueChanged, this, &ConstructionView::visionParametersChanged);
+    connect(visionAreaThreshold, &QDoubleSpinBox::valueChanged, this, &ConstructionView::visionParametersChanged);
+    connect(visionCellThreshold, &QDoubleSpinBox::valueChanged, this, &ConstructionView::visionParametersChanged);
 
     // Initialize comptuer vision controls layout
     visionControls = new QVBoxLayout();
@@ -238,6 +340,15 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
     visionControls->addWidget(worldPointYPos);
     visionControls->addWidget(worldPointZPos);
     visionControls->addWidget(projectWorldPoint);
+    visionControls->addWidget(visionAdaptiveThreshold);
+    visionControls->addWidget(visionThresholdLabel);
+    visionControls->addWidget(visionThresholdValue);
+    visionControls->addWidget(visionBlurLabel);
+    visionControls->addWidget(visionBlurSize);
+    visionControls->addWidget(visionAreaLabel);
+    visionControls->addWidget(visionAreaThreshold);
+    visionControls->addWidget(visionCellLabel);
+    visionControls->addWidget(visionCellThreshold);
     visionControls->addStretch();
 
     // Initialize computer vision visual
@@ -346,6 +457,8 @@ ConstructionView::ConstructionView(QWidget* parent): QWidget(parent)
         sourceCubes.append(cubeWorldModel->insertCube(xPos, 32, 0, 0));
     }
 
+    // Only allow an interrupted construction to be resumed
+    resumeConstruction->setEnabled(constructionJournal->exists());
 
 }
 
@@ -378,6 +491,10 @@ void ConstructionView::requestPressureUpdate()
 void ConstructionView::pressureUpdated()
 {
     pressureLabel->setText("Pressure: " + QString::number(robot->getPressure()));
+
+    // Record the pressure trace while the cube is carried for the verification policy
+    if (robotCommandState == RobotCommandState::CONSTRUCT_TASK && !cubeTasks.isEmpty() && cubeTasks.first()->expectGrippedCube())
+        verificationPolicy.addPressureSample(robot->getPressure());
 }
 
 void ConstructionView::updateCameraFeed()
@@ -401,8 +518,18 @@ void ConstructionView::updateCameraFeed()
     }
 
     // Capture frame from camera
+    // The most recent frame of a frame grabber is displayed so that the user interface does not wait for the camera
     cv::Mat input;
-    *camera >> input;
+    FrameGrabber* frameGrabber = dynamic_cast<FrameGrabber*>(camera);
+    if (frameGrabber != Q_NULLPTR)
+    {
+        if (!frameGrabber->tryRead(input))
+            return;
+    }
+    else
+    {
+        *camera >> input;
+    }
 
     // Select image to display based on user vision stage selection
     cv::Mat output;
@@ -518,6 +645,21 @@ void ConstructionView::loadModelClicked()
     }
 }
 
+void ConstructionView::visionParametersChanged()
+{
+    VisionParameters parameters;
+    parameters.adaptiveThreshold = visionAdaptiveThreshold->isChecked();
+    parameters.threshold = visionThresholdValue->value();
+    parameters.blurSize = visionBlurSize->value();
+    parameters.areaThreshold = visionAreaThreshold->value();
+    parameters.cellThreshold = visionCellThreshold->value();
+    vision.setParameters(parameters);
+    visionThresholdValue->setEnabled(!parameters.adaptiveThreshold);
+
+    // Only the stages affected by the changed parameter are run again. The vision view is refreshed by the camera timer
+    vision.reprocessScene();
+}
+
 void ConstructionView::visionBackClicked()
 {
     baseLayout->setCurrentWidget(overviewWidget);
@@ -546,66 +688,401 @@ void ConstructionView::modelInputUpdate(QAbstractButton* button, bool checked)
 
 void ConstructionView::executeConstruction()
 {
-    // Clear any incomplete cube tasks from the previous construction event
+    if (!planConstruction())
+        return;
+
+    startConstruction();
+}
+
+void ConstructionView::startConstruction()
+{
+    journalConstruction();
+
+    // Start without a failure history since the workspace is processed before the first cube task
+    verificationPolicy.reset();
+    verificationPolicy.setPressureThreshold(pressureThreshold);
+
+    // Initiate pressure sensor requests
+    pressureTimer->start(50); // Request pressure every 50 ms
+
+    // Initiate construction with computer vision assessment
+    robotCommandState = RobotCommandState::CONSTRUCT_VISION;
+    robot->setPosition(0, 0, ROBOT_VISION_POS.z, 0);
+}
+
+void ConstructionView::resetConstruction()
+{
+    // Discard the cube tasks of the abandoned construction
+    qDeleteAll(cubeTasks);
+    cubeTasks.clear();
+
+    // Stop the pressure sensor reading requests and leave the construction state
+    pressureTimer->stop();
+    robotCommandState = RobotCommandState::IDLE;
+
+    // The abandoned construction is not resumed
+    constructionJournal->clear();
+    resumeConstruction->setEnabled(false);
+}
+
+void ConstructionView::journalConstruction()
+{
+    ConstructionCheckpoint checkpoint;
+    cubeBuildModel->write(checkpoint.buildModel);
+    checkpoint.placement = structurePlacement;
+    for (CubeTask* task : cubeTasks)
+        checkpoint.taskCubeIds.append(task->getDestinationCube()->getCubeID());
+
+    for (Cube* cube : sourceCubes)
+    {
+        QJsonObject jsonCube;
+        cube->write(jsonCube);
+        checkpoint.sourceCubes.append(jsonCube);
+    }
+
+    for (Cube* cube : structCubes)
+    {
+        QJsonObject jsonCube;
+        cube->write(jsonCube);
+        checkpoint.structCubes.append(jsonCube);
+        checkpoint.structCubeIds.append(placedDestinations.contains(cube) ? (int) placedDestinations[cube]->getCubeID() : -1);
+    }
+
+    // The source cube of the first task has left the source cubes once the task starts or if it failed to be gripped
+    if (!cubeTasks.isEmpty())
+    {
+        CubeTask* task = cubeTasks.first();
+        if (task->getSourceCube() != Q_NULLPTR && !sourceCubes.contains(task->getSourceCube()))
+            task->getSourceCube()->write(checkpoint.taskSourceCube);
+        checkpoint.taskStarted = task->isStarted();
+        checkpoint.taskReleased = task->isCubeReleased();
+    }
+    journaledTaskStarted = checkpoint.taskStarted;
+    journaledTaskReleased = checkpoint.taskReleased;
+
+    checkpoint.missingCubes = missingCubes;
+    checkpoint.externalCubes = externalCubes;
+    if (constructionJournal->write(checkpoint))
+        resumeConstruction->setEnabled(true);
+}
+
+void ConstructionView::journalTaskProgress(CubeTask* task)
+{
+    if (task->isStarted() && !journaledTaskStarted)
+    {
+        QJsonObject jsonCube;
+        task->getSourceCube()->write(jsonCube);
+        constructionJournal->append(TaskProgress::STARTED, jsonCube);
+        journaledTaskStarted = true;
+    }
+
+    if (task->isCubeReleased() && !journaledTaskReleased)
+    {
+        constructionJournal->append(TaskProgress::RELEASED);
+        journaledTaskReleased = true;
+    }
+}
+
+void ConstructionView::resumeConstructionClicked()
+{
+    // The cube tasks of a construction in progress must not be replaced
+    if (!cubeTasks.isEmpty() && cubeTasks.first()->isStarted())
+    {
+        emit log(Message(MessageType::WARNING_LOG, "Construction", "Cannot resume a construction during a construction"));
+        return;
+    }
+
+    ConstructionCheckpoint checkpoint;
+    if (!constructionJournal->exists() || !constructionJournal->read(checkpoint))
+    {
+        emit log(Message(MessageType::ERROR_LOG, "Construction", "No interrupted construction to resume"));
+        return;
+    }
+
+    // Restore the build model and find the destination cube of each incomplete task by its identifier
     for (int i = 0; i < cubeTasks.size(); ++i)
         delete cubeTasks[i];
     cubeTasks.clear();
+    cubeBuildModel->read(checkpoint.buildModel);
+    structurePlacement = checkpoint.placement;
+
+    QMap<int, Cube*> buildCubes;
+    for (Cube* cube : *cubeBuildModel->getCubes())
+        buildCubes[cube->getCubeID()] = cube;
 
-    // Copy list and sort cubes by z, x, y values respectively
-    QList<Cube*> cubes;
-    for (int i = 0; i < cubeBuildModel->getCubeCount(); ++i) {
-        Cube* cube = cubeBuildModel->getCubes()->at(i);
-        bool inserted = false;
-        for (int j = 0; j < cubes.size(); ++j)
+    for (int id : checkpoint.taskCubeIds)
+    {
+        if (!buildCubes.contains(id))
         {
-            // Initialize the position comparision variables
-            int xCube = round(cube->getPosition().x);
-            int yCube = round(cube->getPosition().y);
-            int zCube = round(cube->getPosition().z);
-
-            int xList = round(cubes[j]->getPosition().x);
-            int yList = round(cubes[j]->getPosition().y);
-            int zList = round(cubes[j]->getPosition().z);
-                
-            // Insert in place of list cube if placed earlier in the construction process
-            if (yCube < yList)
-            {
-                cubes.insert(j, cube);
-                inserted = true;
-                break;
-            }
-            else if (yCube == yList && zCube > zList)
-            {
-                cubes.insert(j, cube);
-                inserted = true;
-                break;
-            }
-            else if (yCube == yList && zCube == zList && xCube < xList)
-            {
-                cubes.insert(j, cube);
-                inserted = true;
-                break;
-            }
+            emit log(Message(MessageType::ERROR_LOG, "Construction", "Journal refers to a cube missing from the build model"));
+            return;
         }
 
-        // Append to the end of the list if the cube does not precede any existing cubes in the construction process
-        if (inserted == false)
-            cubes.append(cube);
+        CubeTask* task = new CubeTask();
+        task->setDestinationCube(buildCubes[id]);
+        task->setPlacement(structurePlacement);
+        task->setClearancePlanner(&clearancePlanner);
+        cubeTasks.append(task);
+    }
+
+    // Restore the cubes in the workspace
+    cubeWorldModel->clearCubes();
+    sourceCubes.clear();
+    structCubes.clear();
+    placedDestinations.clear();
+    for (const QJsonObject& jsonCube : checkpoint.sourceCubes)
+    {
+        Cube* cube = cubeWorldModel->insertCube(0, 0, 0, 0);
+        cube->read(jsonCube);
+        sourceCubes.append(cube);
+    }
+
+    for (int i = 0; i < checkpoint.structCubes.size(); ++i)
+    {
+        Cube* cube = cubeWorldModel->insertCube(0, 0, 0, 0);
+        cube->read(checkpoint.structCubes[i]);
+        structCubes.append(cube);
+        if (buildCubes.contains(checkpoint.structCubeIds[i]))
+            placedDestinations[cube] = buildCubes[checkpoint.structCubeIds[i]];
+    }
+
+    missingCubes = checkpoint.missingCubes;
+    externalCubes = checkpoint.externalCubes;
+
+    // Resolve the cube of the task which was interrupted
+    if (!checkpoint.taskSourceCube.isEmpty() && !cubeTasks.isEmpty())
+    {
+        Cube* cube = cubeWorldModel->insertCube(0, 0, 0, 0);
+        cube->read(checkpoint.taskSourceCube);
+
+        if (checkpoint.taskReleased)
+        {
+            // The cube was released at its destination so it is assumed to be placed
+            // The coodinates are converted from the robot coordinate system to the OpenGL coordinate system
+            glm::vec3 destination = cubeTasks.first()->getDestinationTopFace();
+            cube->setPosition(glm::vec3(destination.x, destination.z - 32, destination.y));
+            cube->setOrientation(glm::vec3(0, cubeTasks.first()->getDestinationCube()->getPitch(), 0));
+            structCubes.append(cube);
+            placedDestinations[cube] = cubeTasks.first()->getDestinationCube();
+            delete cubeTasks.first();
+            cubeTasks.removeFirst();
+        }
+        else
+        {
+            // The cube may have been dropped while it was carried so it is found by the computer vision system
+            // A cube which failed to be gripped is already counted as missing
+            if (checkpoint.taskStarted)
+                missingCubes++;
+            cube->setState(CubeState::INVALID);
+            cubeTasks.first()->setSourceCube(cube);
+        }
     }
 
+    // The restored cubes keep their journaled identifiers, so the cubes inserted later must be numbered after them
+    cubeWorldModel->reserveCubeIDs();
+
+    if (cubeTasks.isEmpty())
+    {
+        emit log(Message(MessageType::INFO_LOG, "Construction", "Interrupted construction has no remaining cube tasks"));
+        constructionJournal->clear();
+        resumeConstruction->setEnabled(false);
+        return;
+    }
+
+    // Assign the source cubes to the remaining tasks in the journaled order
+    RobotPosition startPosition;
+    startPosition.z = ROBOT_VISION_POS.z;
+    clearancePlanner.setObstacles(sourceCubes + structCubes);
+    sourceAssigner->clearCache();
+    sourceAssigner->assign(cubeTasks, sourceCubes, startPosition, ROBOT_VISION_POS.z);
+    rotationPlanner.plan(cubeTasks, startPosition.r);
+    sourceAssignmentStale = false;
+
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Resuming construction with " + QString::number(structCubes.size())
+        + " cubes placed and " + QString::number(cubeTasks.size()) + " cube tasks remaining"));
+    startConstruction();
+}
+
+bool ConstructionView::planConstruction()
+{
+    // Clear any incomplete cube tasks from the previous construction event
+    for (int i = 0; i < cubeTasks.size(); ++i)
+        delete cubeTasks[i];
+    cubeTasks.clear();
+
+    placedDestinations.clear();
+
+    // Plan the build order from the support and adjacency constraints between the cubes
+    if (!constructionPlanner->plan(cubeBuildModel))
+        return false;
+    QList<Cube*> cubes = constructionPlanner->getBuildOrder();
+
+    // Map the cubes in the workspace for the clearance of the robot moves
+    clearancePlanner.setObstacles(sourceCubes + structCubes);
+
     // Generate cube tasks
     for (int i = 0; i < cubes.size(); ++i) {
         CubeTask* task = new CubeTask();
         task->setDestinationCube(cubes[i]);
+        task->setPlacement(structurePlacement);
+        task->setClearancePlanner(&clearancePlanner);
         cubeTasks.append(task);
     }
 
-    // Initiate pressure sensor requests
-    pressureTimer->start(50); // Request pressure every 50 ms
+    // Sequence the cube tasks and assign their source cubes to minimise the travel of the robot
+    // The construction starts at the vision position and the robot returns to its height after each task
+    RobotPosition startPosition;
+    startPosition.z = ROBOT_VISION_POS.z;
+    cubeTasks = taskSequencer->sequence(cubeTasks, sourceCubes, startPosition, constructionPlanner);
 
-    // Initiate construction with computer vision assessment
-    robotCommandState = RobotCommandState::CONSTRUCT_VISION;
-    robot->setPosition(0, 0, ROBOT_VISION_POS.z, 0);
+    // Assign the source cubes to the sequenced tasks optimally
+    sourceAssigner->clearCache();
+    double duration = sourceAssigner->assign(cubeTasks, sourceCubes, startPosition, ROBOT_VISION_POS.z);
+    sourceAssignmentStale = false;
+
+    // Choose the equivalent end-effector rotations which minimise the rotation over the sequence
+    rotationPlanner.plan(cubeTasks, startPosition.r);
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Estimated cube task duration with the assigned source cubes is "
+        + QString::number(duration / 1000, 'f', 1) + " s"));
+
+    return true;
+}
+
+void ConstructionView::estimateBuildClicked()
+{
+    // The cube tasks of a construction in progress must not be replaced
+    if (!cubeTasks.isEmpty() && cubeTasks.first()->isStarted())
+    {
+        emit log(Message(MessageType::WARNING_LOG, "Construction", "Cannot estimate the build during a construction"));
+        return;
+    }
+
+    if (!planConstruction())
+        return;
+
+    // Simulate the construction from the current robot position with the nominal placement verifications
+    RobotPosition robotPosition = { robot->getXPosition(), robot->getYPosition(), robot->getZPosition(), robot->getRPosition() };
+    buildSimulator.setVisionPosition({ ROBOT_VISION_POS.x, ROBOT_VISION_POS.y, ROBOT_VISION_POS.z, 0 });
+    buildSimulator.setVerificationInterval(verificationInterval->value());
+    // The simulation maps the structure as it is built, so the current workspace is mapped again after it
+    BuildEstimate estimate = buildSimulator.simulate(cubeTasks, robotPosition, &clearancePlanner, sourceCubes + structCubes);
+    clearancePlanner.setObstacles(sourceCubes + structCubes);
+
+    // Log the duration of each phase of each cube task and the total duration of each phase
+    CubeTaskTiming phaseTotals;
+    double verifyTotal = 0;
+    for (int i = 0; i < estimate.cubes.size(); ++i)
+    {
+        const CubeBuildTime& cube = estimate.cubes[i];
+        glm::vec3 position = cube.destinationCube->getPosition();
+        emit log(Message(MessageType::INFO_LOG, "Build Estimate", "Cube " + QString::number(i + 1) + " at ("
+            + QString::number(position.x) + ", " + QString::number(position.z) + ") layer " + QString::number(cube.layer)
+            + ": pick " + QString::number(cube.task.pick, 'f', 0) + " ms, grip " + QString::number(cube.task.grip, 'f', 0)
+            + " ms, place " + QString::number(cube.task.place, 'f', 0) + " ms, release " + QString::number(cube.task.release, 'f', 0)
+            + " ms, raise " + QString::number(cube.task.raise, 'f', 0) + " ms, verify " + QString::number(cube.verify, 'f', 0)
+            + " ms, total " + QString::number(cube.getDuration(), 'f', 0) + " ms"));
+
+        phaseTotals.pick += cube.task.pick;
+        phaseTotals.grip += cube.task.grip;
+        phaseTotals.place += cube.task.place;
+        phaseTotals.release += cube.task.release;
+        phaseTotals.raise += cube.task.raise;
+        verifyTotal += cube.verify;
+    }
+
+    emit log(Message(MessageType::INFO_LOG, "Build Estimate", "Initial vision " + QString::number(estimate.vision, 'f', 0)
+        + " ms, pick " + QString::number(phaseTotals.pick, 'f', 0) + " ms, grip " + QString::number(phaseTotals.grip, 'f', 0)
+        + " ms, place " + QString::number(phaseTotals.place, 'f', 0) + " ms, release " + QString::number(phaseTotals.release, 'f', 0)
+        + " ms, raise " + QString::number(phaseTotals.raise, 'f', 0) + " ms, verify " + QString::number(verifyTotal, 'f', 0) + " ms"));
+    emit log(Message(MessageType::INFO_LOG, "Build Estimate", "Estimated build time of " + QString::number((int) estimate.cubes.size())
+        + " cubes is " + QString::number(estimate.total / 1000, 'f', 1) + " s"));
+}
+
+void ConstructionView::planLayoutClicked()
+{
+    // The structure and source magazine must not be moved once the construction has started
+    if ((!cubeTasks.isEmpty() && cubeTasks.first()->isStarted()) || !structCubes.isEmpty())
+    {
+        emit log(Message(MessageType::WARNING_LOG, "Construction", "Cannot plan the layout once the construction has started"));
+        return;
+    }
+
+    if (!constructionPlanner->plan(cubeBuildModel))
+        return;
+
+    layoutPlanner->setVisionPosition({ ROBOT_VISION_POS.x, ROBOT_VISION_POS.y, ROBOT_VISION_POS.z, 0 });
+    layoutPlanner->setVerificationInterval(verificationInterval->value());
+
+    // Plan the layout off the GUI thread since the candidates take about a second to screen and simulate
+    // The build model and source cubes read by the planner must not change until the planned layout is applied
+    setLayoutControlsEnabled(false);
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Planning the structure placement and source magazine layout"));
+    QVector<Cube*> sources = sourceCubes;
+    StructurePlacement placement = structurePlacement;
+    layoutPlanning = std::async(std::launch::async, [this, sources, placement]() {
+        // Estimate the construction with the current layout for comparison
+        LayoutPlanning planning;
+        planning.currentDuration = layoutPlanner->estimate(constructionPlanner, placement, sources);
+        planning.planned = layoutPlanner->plan(constructionPlanner, planning.plan);
+
+        // Apply the planned layout on the GUI thread
+        QMetaObject::invokeMethod(this, &ConstructionView::layoutPlanned, Qt::QueuedConnection);
+        return planning;
+    });
+}
+
+void ConstructionView::layoutPlanned()
+{
+    LayoutPlanning planning = layoutPlanning.get();
+    setLayoutControlsEnabled(true);
+    if (!planning.planned)
+        return;
+
+    const LayoutPlan& plan = planning.plan;
+    double currentDuration = planning.currentDuration;
+    if (currentDuration >= 0 && currentDuration <= plan.duration)
+    {
+        emit log(Message(MessageType::INFO_LOG, "Construction", "Current layout is kept with an estimated build time of "
+            + QString::number(currentDuration / 1000, 'f', 1) + " s"));
+        return;
+    }
+
+    // Replace the source cubes with the planned magazine layout
+    for (Cube* cube : sourceCubes)
+        cubeWorldModel->removeCube(cube);
+    sourceCubes.clear();
+    for (const glm::vec3& position : plan.sourceLayout.positions)
+        sourceCubes.append(cubeWorldModel->insertCube(position.x, position.y, position.z, 0));
+
+    // The cube tasks of an estimated build refer to the previous placement
+    for (int i = 0; i < cubeTasks.size(); ++i)
+        delete cubeTasks[i];
+    cubeTasks.clear();
+    structurePlacement = plan.placement;
+
+    const SourceLayout& layout = plan.sourceLayout;
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Structure origin placed at (" + QString::number(plan.placement.x)
+        + ", " + QString::number(plan.placement.y) + ") with " + QString::number(plan.placement.orientation * 90) + " degree rotation"));
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Arrange " + QString::number(layout.positions.size())
+        + " source cubes in magazine rows " + QString::number(layout.firstRow + 1) + " to " + QString::number(layout.firstRow + layout.rows)
+        + " and slots " + QString::number(layout.firstSlot + 1) + " to " + QString::number(layout.firstSlot + layout.slotCount)
+        + ", filling the rows from the structure side"));
+
+    QString comparison = currentDuration >= 0 ? " from " + QString::number(currentDuration / 1000, 'f', 1) + " s" : "";
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Estimated build time reduced" + comparison + " to "
+        + QString::number(plan.duration / 1000, 'f', 1) + " s"));
+}
+
+void ConstructionView::setLayoutControlsEnabled(bool enabled)
+{
+    loadModel->setEnabled(enabled);
+    execute->setEnabled(enabled);
+    estimateBuild->setEnabled(enabled);
+    planLayout->setEnabled(enabled);
+    processScene->setEnabled(enabled);
+
+    // Only allow an interrupted construction to be resumed
+    resumeConstruction->setEnabled(enabled && constructionJournal->exists());
 }
 
 void ConstructionView::setRobot(Robot* robot)
@@ -626,6 +1103,9 @@ void ConstructionView::handleRobotCommand()
     case RobotCommandState::CONSTRUCT_VISION:
         handleConstructVisionState();
         break;
+    case RobotCommandState::CONSTRUCT_VERIFY:
+        handleConstructVerifyState();
+        break;
     case RobotCommandState::PROCESS_SCENE:
         handleProcessSceneState();
         break;
@@ -640,11 +1120,27 @@ void ConstructionView::handleConstructTaskState()
 
     CubeTask* task = cubeTasks.first();
 
+    // Journal the progress of the task once the robot command which made it has completed
+    journalTaskProgress(task);
+
     // Check if task complete
     if (task->isComplete())
     {
         // Add source cube to list of sucessfully placed cubes in the 3D shape structure
-        structCubes.append(task->getSourceCube());
+        Cube* placedCube = task->getSourceCube();
+        structCubes.append(placedCube);
+        placedDestinations[placedCube] = task->getDestinationCube();
+
+        // Record the destination pose of the placed cube for verification
+        glm::vec3 destination = task->getDestinationTopFace();
+        placementPose.position = cv::Point3d(destination.x, destination.y, destination.z);
+        placementPose.rotation = task->getDestinationCube()->getPitch();
+        placementPose.residual = 0;
+        int layer = round(destination.z / 64) - 1;
+
+        // Map the placed cube at its destination for the clearance of the following robot moves
+        placedCube->setPosition(glm::vec3(destination.x, destination.z - 32, destination.y));
+        clearancePlanner.setObstacles(sourceCubes + structCubes);
 
         // Remove completed cube task from the list of incomplete cube tasks
         delete cubeTasks.first();
@@ -654,6 +1150,9 @@ void ConstructionView::handleConstructTaskState()
         // Check if construction is complete
         if (cubeTasks.isEmpty())
         {
+            constructionJournal->clear();
+            resumeConstruction->setEnabled(false);
+
             // Update vision view last time
             robotCommandState = RobotCommandState::PROCESS_SCENE;
             handleRobotCommand();
@@ -663,8 +1162,41 @@ void ConstructionView::handleConstructTaskState()
         }
         else
         {
-            // Activate the computer vision phase of the construction state to detect the cube
-            robotCommandState = RobotCommandState::CONSTRUCT_VISION;
+            QJsonObject jsonCube;
+            placedCube->write(jsonCube);
+            constructionJournal->append(TaskProgress::PLACED, jsonCube);
+            journaledTaskStarted = false;
+            journaledTaskReleased = false;
+
+            // Decide if the placement is verified unless the full scene is needed to find a missing cube
+            QString reason = "Missing cube";
+            VerificationLevel level = VerificationLevel::SCENE;
+            if (missingCubes == 0 && vision.isCalibrated())
+            {
+                verificationPolicy.setSamplingInterval(verificationInterval->value());
+                level = verificationPolicy.decide(layer, reason);
+            }
+
+            if (level == VerificationLevel::NONE)
+            {
+                // Continue directly with the next cube task while the workspace monitor watches for disturbances
+                continueMonitoring(placedCube);
+                robotCommandState = RobotCommandState::CONSTRUCT_TASK;
+            }
+            else
+            {
+                // Stop monitoring the workspace since the placed cube has left its monitored source position
+                workspaceMonitor->clearReference();
+                if (level == VerificationLevel::PLACEMENT)
+                {
+                    emit log(Message(MessageType::INFO_LOG, "Construction", reason + ", verifying placement..."));
+                    robotCommandState = RobotCommandState::CONSTRUCT_VERIFY;
+                }
+                else
+                {
+                    robotCommandState = RobotCommandState::CONSTRUCT_VISION;
+                }
+            }
             handleRobotCommand();
         }
 
@@ -674,8 +1206,23 @@ void ConstructionView::handleConstructTaskState()
     // Initialize source position if task has not been started
     if (!task->isStarted())
     {
-        // Check if any source cubes remain
-        if (sourceCubes.size() > 0)
+        verificationPolicy.startTask();
+
+        // Assign the source cubes to the pending tasks again if a source cube failed to be gripped or was relocated
+        if (sourceAssignmentStale)
+        {
+            RobotPosition robotPosition = { robot->getXPosition(), robot->getYPosition(), robot->getZPosition(), robot->getRPosition() };
+            sourceAssigner->assign(cubeTasks, sourceCubes, robotPosition, ROBOT_VISION_POS.z);
+            rotationPlanner.plan(cubeTasks, robotPosition.r);
+            sourceAssignmentStale = false;
+        }
+
+        // Use the source cube assigned by the sequencer if it is still available, otherwise check if any source cubes remain
+        if (task->getSourceCube() != Q_NULLPTR && sourceCubes.contains(task->getSourceCube()))
+        {
+            sourceCubes.removeOne(task->getSourceCube());
+        }
+        else if (sourceCubes.size() > 0)
         {
             task->setSourceCube(sourceCubes.takeFirst());
         }
@@ -684,6 +1231,29 @@ void ConstructionView::handleConstructTaskState()
             emit log(Message(MessageType::ERROR_LOG, "Construction View", "No source cubes remain to build the structure"));
             return;
         }
+
+        // Map the cubes in the workspace without the source cube of the task for the clearance of the robot moves
+        clearancePlanner.setObstacles(sourceCubes + structCubes);
+    }
+
+    // Process the workspace again if a cube was disturbed before the cube is placed
+    if (workspaceDisturbed && !task->isCubeReleased())
+    {
+        emit log(Message(MessageType::INFO_LOG, "Construction", "Workspace disturbed, processing image..."));
+        workspaceDisturbed = false;
+        verificationPolicy.recordFailure();
+        robotCommandState = RobotCommandState::CONSTRUCT_VISION;
+
+        // Restart the task if the cube has not been gripped
+        if (robot->getPressure() < pressureThreshold)
+        {
+            sourceCubes.insert(0, task->getSourceCube());
+            task->resetSteps(robot);
+            return;
+        }
+
+        handleRobotCommand();
+        return;
     }
 
     // Check if the cube is not gripped when the task step expects it to be gripped
@@ -693,10 +1263,12 @@ void ConstructionView::handleConstructTaskState()
 
         // Activate the computer vision phase of the construction state to detect the cube
         missingCubes++;
+        verificationPolicy.recordFailure();
         robotCommandState = RobotCommandState::CONSTRUCT_VISION;
 
         // Update the status of the failed source cube in the cube world model
         task->getSourceCube()->setState(CubeState::INVALID);
+        sourceAssignmentStale = true;
 
         // Restart the task
         task->resetSteps(robot);
@@ -714,7 +1286,20 @@ void ConstructionView::handleConstructTaskState()
     }
 
     // Instruct the robot to perform the next step in the task
+    // The transfer in progress is replanned if the robot was moved to process the workspace during the transfer
+    task->replanTransfer(robot);
+    cv::Point3d startPosition(robot->getXPosition(), robot->getYPosition(), robot->getZPosition() * 64.0 / 318);
     task->performNextStep(robot);
+
+    // Ignore changes in the space swept by the end-effector during the step
+    cv::Point3d targetPosition(robot->getXPosition(), robot->getYPosition(), robot->getZPosition() * 64.0 / 318);
+    if (vision.isCalibrated())
+    {
+        double height = std::max(ROBOT_VISION_POS.z * 64.0 / 318, std::max(startPosition.z, targetPosition.z));
+        cv::Point3d sweptMin(std::min(startPosition.x, targetPosition.x) - END_EFFECTOR_RADIUS, std::min(startPosition.y, targetPosition.y) - END_EFFECTOR_RADIUS, -height);
+        cv::Point3d sweptMax(std::max(startPosition.x, targetPosition.x) + END_EFFECTOR_RADIUS, std::max(startPosition.y, targetPosition.y) + END_EFFECTOR_RADIUS, 0);
+        workspaceMonitor->setOccludedRegions({ vision.projectWorldBox(sweptMin, sweptMax) });
+    }
 }
 
 void ConstructionView::handleConstructVisionState()
@@ -724,15 +1309,42 @@ void ConstructionView::handleConstructVisionState()
         return;
 
     // Verify robot is in the correct position to ensure there are no occlusions
-    if (robot->getXPosition() != ROBOT_VISION_POS.x || robot->getYPosition() != ROBOT_VISION_POS.y || robot->getZPosition() != ROBOT_VISION_POS.z)
+    // With multiple cameras the robot only needs to be raised since the cameras see around the robot
+    if (multiCameraVision->getCameraCount() > 1)
     {
-        // Instruct robot to go to computer vison position
-        robot->setPosition(ROBOT_VISION_POS.x, ROBOT_VISION_POS.y, ROBOT_VISION_POS.z, 0);
-        return;
+        if (robot->getZPosition() != ROBOT_VISION_POS.z)
+        {
+            robot->setPosition(robot->getXPosition(), robot->getYPosition(), ROBOT_VISION_POS.z, robot->getRPosition());
+            return;
+        }
+    }
+    else
+    {
+        // The robot only travels to the computer vision position if it occludes the regions of interest on the way
+        cv::Point3i capturePosition = getCapturePosition();
+        if (robot->getXPosition() != capturePosition.x || robot->getYPosition() != capturePosition.y || robot->getZPosition() != capturePosition.z)
+        {
+            int rPosition = capturePosition == ROBOT_VISION_POS ? 0 : robot->getRPosition();
+            robot->setPosition(capturePosition.x, capturePosition.y, capturePosition.z, rPosition);
+            return;
+        }
     }
 
     emit log(Message(MessageType::INFO_LOG, "Construction", "Processing image..."));
 
+    setVisionOccludedRegions();
+
+    // The processed scene supersedes any disturbance detected since the previous scene
+    workspaceMonitor->clearReference();
+    workspaceDisturbed = false;
+
+    // Treat the raised end-effector as an occluder above its current position
+    VisionOccluder endEffector;
+    double endEffectorHeight = robot->getZPosition() * 64.0 / 318;
+    endEffector.min = cv::Point3d(robot->getXPosition() - END_EFFECTOR_RADIUS, robot->getYPosition() - END_EFFECTOR_RADIUS, -endEffectorHeight - 2000);
+    endEffector.max = cv::Point3d(robot->getXPosition() + END_EFFECTOR_RADIUS, robot->getYPosition() + END_EFFECTOR_RADIUS, -endEffectorHeight);
+    multiCameraVision->setOccluders({ endEffector });
+
     // Create list of source cube top face centroids excluding source cube being processed by current task
     std::vector<cv::Point3i> sourceCentroids;
     for (int i = 0; i < sourceCubes.size(); ++i)
@@ -757,43 +1369,86 @@ void ConstructionView::handleConstructVisionState()
         structCentroids.push_back(centroid);
     }
 
-    // Capture frame from camera
-    cv::Mat input;
-    for (int i = 0; i < discardFrames; i++)
-        *camera >> input;
+    // Capture frame from each camera
+    std::vector<cv::Mat> images = multiCameraVision->captureImages(discardFrames);
+
+    // Process images
+    processVisionScene(images, true, &sourceCentroids, &structCentroids);
 
-    // Process image
-    vision.processScene(input, true, &sourceCentroids, &structCentroids);
+    // Capture the next frame from each camera while the scene is of insufficient quality for the construction decisions
+    // This is much cheaper than recovering from a decision based on a poor scene
+    QString qualityReason;
+    for (int i = 0; i < MAX_RECAPTURES && !isSceneAcceptable(qualityReason); ++i)
+    {
+        emit log(Message(MessageType::WARNING_LOG, "Construction", qualityReason + ", capturing image again"));
+        images = multiCameraVision->captureImages(1);
+        processVisionScene(images, true, &sourceCentroids, &structCentroids);
+    }
 
     // Analyze cubes detected in the workspace that are not part of the source cubes or 3D shape structure
-    std::vector<cv::Point3i> detectedCubeCentroids = vision.getCubeCentroids(64);
-    std::vector<float> detectedCubeRotations = vision.getCubeRotations(64);
-    if (detectedCubeCentroids.size() > 0)
+    std::vector<CubePose> detectedCubePoses = multiCameraVision->getLayeredCubePoses();
+    if (detectedCubePoses.size() > 0)
     {
         // Check if the construction has failed
         // This is assumed when there are more independent cubes detected than expected
         int expectedCubes = missingCubes + externalCubes;
-        if (detectedCubeCentroids.size() > expectedCubes)
+        if (detectedCubePoses.size() > expectedCubes)
         {
-            // TODO: Reset construction state
             emit log(Message(MessageType::INFO_LOG, "Construction", "Construction failure detected"));
-            cubeTasks.clear();
-            return;
+
+            // Replan the construction from the observed scene
+            // The journal keeps the last state to resume from if the construction cannot be recovered
+            if (!recoverConstruction(images, detectedCubePoses))
+            {
+                emit log(Message(MessageType::ERROR_LOG, "Construction", "Construction could not be recovered"));
+                resetConstruction();
+                return;
+            }
+
+            if (cubeTasks.isEmpty())
+            {
+                emit log(Message(MessageType::INFO_LOG, "Construction", "Construction complete after recovery"));
+                constructionJournal->clear();
+                resumeConstruction->setEnabled(false);
+                pressureTimer->stop();
+                return;
+            }
         }
         // The missing cube has been detected in the workspace
-        else if (detectedCubeCentroids.size() == expectedCubes)
+        else if (detectedCubePoses.size() == expectedCubes)
         {
+            // Reject a cube pose that does not fit a cube top face before the robot attempts to pick the cube
+            CubePose detectedPose = detectedCubePoses[0];
+            if (detectedPose.residual > MAX_POSE_RESIDUAL)
+            {
+                if (poseRetries < MAX_POSE_RETRIES)
+                {
+                    emit log(Message(MessageType::WARNING_LOG, "Construction", "Missing cube pose rejected with residual "
+                        + QString::number(detectedPose.residual, 'f', 1) + ", processing image again"));
+                    poseRetries++;
+                    QTimer::singleShot(0, this, &ConstructionView::handleRobotCommand);
+                    return;
+                }
+
+                emit log(Message(MessageType::ERROR_LOG, "Construction", "Missing cube pose could not be estimated"));
+                poseRetries = 0;
+                resetConstruction();
+                return;
+            }
+
+            poseRetries = 0;
             emit log(Message(MessageType::INFO_LOG, "Construction", "Missing cube detected"));
 
             // Update the position and state of the missing cube
-            glm::vec3 detectedPos(detectedCubeCentroids[0].x, detectedCubeCentroids[0].z - 32, detectedCubeCentroids[0].y);
+            glm::vec3 detectedPos(round(detectedPose.position.x), round(detectedPose.position.z) - 32, round(detectedPose.position.y));
             CubeTask* task = cubeTasks.first();
             task->getSourceCube()->setPosition(detectedPos);
-            task->getSourceCube()->setOrientation(glm::vec3(0, detectedCubeRotations[0], 0));
+            task->getSourceCube()->setOrientation(glm::vec3(0, detectedPose.rotation, 0));
             task->getSourceCube()->setState(CubeState::VALID);
 
-            // Use the detected missing cube as the next source cube
+            // Return the detected missing cube to the source cubes and assign the source cubes again
             sourceCubes.insert(0, task->getSourceCube());
+            sourceAssignmentStale = true;
         }
     }
 
@@ -801,11 +1456,469 @@ void ConstructionView::handleConstructVisionState()
     if (missingCubes > 0)
         missingCubes--;
 
+    // The vision phase may have changed the source cubes and the expected cubes
+    journalConstruction();
+
+    // Monitor the source and structure cubes for disturbances while the robot performs the task
+    if (!images.empty())
+        monitorWorkspace(images[0]);
+
     // Activate the cube task execution phase of the construction state to place the cube
     robotCommandState = RobotCommandState::CONSTRUCT_TASK;
     handleRobotCommand();
 }
 
+bool ConstructionView::recoverConstruction(const std::vector<cv::Mat>& images, const std::vector<CubePose>& detectedCubes)
+{
+    if (!constructionPlanner->plan(cubeBuildModel))
+        return false;
+    QList<Cube*> buildOrder = constructionPlanner->getBuildOrder();
+
+    // The task in progress continues since its cube is gripped
+    CubeTask* currentTask = Q_NULLPTR;
+    if (!cubeTasks.isEmpty() && cubeTasks.first()->isStarted())
+        currentTask = cubeTasks.first();
+
+    // Find the structure cube at each destination
+    QMap<Cube*, Cube*> destinationCubes;
+    for (Cube* structCube : structCubes)
+    {
+        if (placedDestinations.contains(structCube))
+            destinationCubes[placedDestinations[structCube]] = structCube;
+    }
+
+    // Create a cube task for each destination of the build model
+    QList<CubeTask*> buildTasks;
+    QList<DestinationState> states;
+    for (Cube* destination : buildOrder)
+    {
+        CubeTask* task = new CubeTask();
+        task->setDestinationCube(destination);
+        task->setPlacement(structurePlacement);
+        task->setClearancePlanner(&clearancePlanner);
+        buildTasks.append(task);
+
+        if (currentTask != Q_NULLPTR && currentTask->getDestinationCube() == destination)
+            states.append(DestinationState::IN_PROGRESS);
+        else if (destinationCubes.contains(destination))
+            states.append(DestinationState::PLACED);
+        else
+            states.append(DestinationState::PENDING);
+    }
+
+    // Verify the structure cubes with an exposed top face on the system camera image
+    // A covered structure cube is assumed to be at its destination since the cube above it is supported
+    for (int i = 0; i < buildTasks.size() && !images.empty() && !images[0].empty(); ++i)
+    {
+        if (states[i] != DestinationState::PLACED)
+            continue;
+
+        glm::vec3 topFace = buildTasks[i]->getDestinationTopFace();
+        bool covered = false;
+        for (int j = 0; j < buildTasks.size() && !covered; ++j)
+        {
+            glm::vec3 upperFace = buildTasks[j]->getDestinationTopFace();
+            covered = states[j] == DestinationState::PLACED && upperFace.z > topFace.z
+                && std::hypot(upperFace.x - topFace.x, upperFace.y - topFace.y) < 64;
+        }
+        if (covered)
+            continue;
+
+        Cube* structCube = destinationCubes[buildOrder[i]];
+        glm::vec3 cubePos = structCube->getPosition();
+        CubePose expectedPose;
+        expectedPose.position = cv::Point3d(cubePos.x, cubePos.z, cubePos.y + 32);
+        expectedPose.rotation = structCube->getPitch();
+        expectedPose.residual = 0;
+        PlacementVerification verification = vision.verifyPlacement(images[0], expectedPose, PLACEMENT_POSITION_TOLERANCE,
+            PLACEMENT_ROTATION_TOLERANCE);
+        if (verification.status == PlacementStatus::MISPLACED)
+            states[i] = DestinationState::DISPLACED;
+    }
+
+    // Reconcile the source cubes with the scene before the recovery is planned
+    // A detected cube within a cube length of a source cube is the source cube moved from its modelled position
+    std::vector<CubePose> unmatchedCubes;
+    QVector<Cube*> foundSources;
+    for (const CubePose& pose : detectedCubes)
+    {
+        Cube* matchedSource = Q_NULLPTR;
+        for (Cube* source : sourceCubes)
+        {
+            glm::vec3 sourcePos = source->getPosition();
+            if (!foundSources.contains(source) && std::abs(pose.position.z - (sourcePos.y + 32)) < 32
+                && std::hypot(pose.position.x - sourcePos.x, pose.position.y - sourcePos.z) <= SOURCE_MATCH_DISTANCE)
+            {
+                matchedSource = source;
+                break;
+            }
+        }
+
+        if (matchedSource == Q_NULLPTR)
+        {
+            unmatchedCubes.push_back(pose);
+            continue;
+        }
+
+        matchedSource->setPosition(glm::vec3(round(pose.position.x), round(pose.position.z) - 32, round(pose.position.y)));
+        matchedSource->setOrientation(glm::vec3(0, pose.rotation, 0));
+        foundSources.append(matchedSource);
+    }
+
+    // The other source cubes are found on the system camera image near their modelled positions in any rotation
+    // A source cube whose top face is not found has been moved away, so it is among the detected cubes or was removed
+    int droppedSources = 0;
+    for (Cube* source : QVector<Cube*>(sourceCubes))
+    {
+        if (foundSources.contains(source) || images.empty() || images[0].empty())
+            continue;
+
+        glm::vec3 sourcePos = source->getPosition();
+        CubePose expectedPose;
+        expectedPose.position = cv::Point3d(sourcePos.x, sourcePos.z, sourcePos.y + 32);
+        expectedPose.rotation = source->getPitch();
+        expectedPose.residual = 0;
+        PlacementVerification verification = vision.verifyPlacement(images[0], expectedPose, SOURCE_MATCH_DISTANCE, M_PI / 4);
+        if (verification.status == PlacementStatus::VERIFIED)
+        {
+            glm::vec3 observedPos(round(verification.pose.position.x), sourcePos.y, round(verification.pose.position.y));
+            source->setPosition(observedPos);
+            source->setOrientation(glm::vec3(0, verification.pose.rotation, 0));
+        }
+        else if (verification.status == PlacementStatus::MISPLACED)
+        {
+            sourceCubes.removeOne(source);
+            cubeWorldModel->removeCube(source);
+            droppedSources++;
+        }
+    }
+
+    if (droppedSources > 0)
+    {
+        emit log(Message(MessageType::WARNING_LOG, "Construction", QString::number(droppedSources)
+            + " source cubes were not found at their modelled positions"));
+    }
+
+    RecoveryPlan plan;
+    if (!recoveryPlanner->plan(buildTasks, states, unmatchedCubes, plan))
+    {
+        for (int i = 0; i < buildTasks.size(); ++i)
+            delete buildTasks[i];
+        return false;
+    }
+
+    // Remove the structure cubes which are no longer at their destination since they are among the detected cubes
+    for (CubeTask* task : plan.lostTasks)
+    {
+        Cube* structCube = destinationCubes[task->getDestinationCube()];
+        structCubes.removeOne(structCube);
+        placedDestinations.remove(structCube);
+        cubeWorldModel->removeCube(structCube);
+    }
+
+    // Remove a source cube which failed to be gripped since it is among the detected cubes
+    if (currentTask == Q_NULLPTR && !cubeTasks.isEmpty())
+    {
+        Cube* failedCube = cubeTasks.first()->getSourceCube();
+        if (failedCube != Q_NULLPTR && !sourceCubes.contains(failedCube) && !structCubes.contains(failedCube))
+            cubeWorldModel->removeCube(failedCube);
+    }
+
+    // Add the detected cubes to the cube world model
+    // The coodinates are converted from the robot coordinate system to the OpenGL coordinate system
+    for (int i = 0; i < plan.occupiedTasks.size(); ++i)
+    {
+        const CubePose& pose = unmatchedCubes[plan.occupyingCubes[i]];
+        Cube* cube = cubeWorldModel->insertCube(round(pose.position.x), round(pose.position.z) - 32, round(pose.position.y), pose.rotation);
+        structCubes.append(cube);
+        placedDestinations[cube] = plan.occupiedTasks[i]->getDestinationCube();
+    }
+
+    QVector<Cube*> blockingCubes;
+    QVector<Cube*> availableSources = sourceCubes;
+    for (int i = 0; i < plan.sourceCubes.size(); ++i)
+    {
+        const CubePose& pose = unmatchedCubes[plan.sourceCubes[i]];
+        Cube* cube = cubeWorldModel->insertCube(round(pose.position.x), round(pose.position.z) - 32, round(pose.position.y), pose.rotation);
+        sourceCubes.append(cube);
+        if (i < plan.blockingCubes)
+            blockingCubes.append(cube);
+        else
+            availableSources.append(cube);
+    }
+
+    // Replace the cube tasks with the corrective tasks after the task in progress
+    for (int i = 0; i < cubeTasks.size(); ++i)
+    {
+        if (cubeTasks[i] != currentTask)
+            delete cubeTasks[i];
+    }
+    cubeTasks.clear();
+    if (currentTask != Q_NULLPTR)
+        cubeTasks.append(currentTask);
+    cubeTasks.append(plan.tasks);
+
+    for (int i = 0; i < buildTasks.size(); ++i)
+    {
+        if (!plan.tasks.contains(buildTasks[i]))
+            delete buildTasks[i];
+    }
+
+    // The blocking cubes are removed by the first corrective tasks and the other source cubes are assigned optimally
+    int firstAssignedTask = cubeTasks.size() - plan.tasks.size();
+    RobotPosition robotPosition = { robot->getXPosition(), robot->getYPosition(), robot->getZPosition(), robot->getRPosition() };
+    RobotPosition startPosition = robotPosition;
+    for (int i = 0; i < blockingCubes.size(); ++i)
+    {
+        cubeTasks[firstAssignedTask]->setSourceCube(blockingCubes[i]);
+        startPosition = cubeTasks[firstAssignedTask]->getDestinationPosition();
+        startPosition.z = ROBOT_VISION_POS.z;
+        firstAssignedTask++;
+    }
+
+    sourceAssigner->clearCache();
+    sourceAssigner->assign(cubeTasks.mid(firstAssignedTask), availableSources, startPosition, ROBOT_VISION_POS.z);
+    rotationPlanner.plan(cubeTasks, robotPosition.r);
+    sourceAssignmentStale = false;
+
+    // Every detected cube is now accounted for
+    missingCubes = 0;
+    externalCubes = 0;
+    clearancePlanner.setObstacles(sourceCubes + structCubes);
+    verificationPolicy.recordFailure();
+    journalConstruction();
+
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Recovery replaces " + QString::number(plan.lostTasks.size())
+        + " displaced cubes, accepts " + QString::number(plan.occupiedTasks.size()) + " cubes as placed and removes "
+        + QString::number(plan.blockingCubes) + " blocking cubes with " + QString::number(plan.tasks.size()) + " cube tasks"));
+    return true;
+}
+
+void ConstructionView::handleConstructVerifyState()
+{
+    // Check if there are any cube tasks to be performed
+    if (cubeTasks.isEmpty())
+        return;
+
+    // Raise the end-effector from the placed cube so that the top face is visible
+    if (robot->getZPosition() != ROBOT_VISION_POS.z)
+    {
+        robot->setPosition(robot->getXPosition(), robot->getYPosition(), ROBOT_VISION_POS.z, robot->getRPosition());
+        return;
+    }
+
+    // Process the full scene if the robot still occludes the placed cube
+    cv::Point3d faceMin(placementPose.position.x - 32, placementPose.position.y - 32, -placementPose.position.z);
+    cv::Point3d faceMax(placementPose.position.x + 32, placementPose.position.y + 32, -placementPose.position.z);
+    cv::Point3i robotPosition(robot->getXPosition(), robot->getYPosition(), robot->getZPosition());
+    std::vector<cv::Mat> images;
+    if (!isCaptureOccluded(robotPosition, { vision.projectWorldPolygon(faceMin, faceMax) }))
+        images = multiCameraVision->captureImages(discardFrames);
+
+    if (images.empty() || images[0].empty())
+    {
+        robotCommandState = RobotCommandState::CONSTRUCT_VISION;
+        handleRobotCommand();
+        return;
+    }
+
+    // Verify the placed cube using the system camera
+    PlacementVerification verification = vision.verifyPlacement(images[0], placementPose, PLACEMENT_POSITION_TOLERANCE,
+        PLACEMENT_ROTATION_TOLERANCE);
+
+    if (verification.status != PlacementStatus::VERIFIED)
+    {
+        // Fall back to processing the full scene
+        QString reason = "Placement could not be verified";
+        if (verification.status == PlacementStatus::MISPLACED && std::isfinite(verification.positionError))
+            reason = "Cube misplaced by " + QString::number(verification.positionError, 'f', 1) + " steps and "
+                + QString::number(glm::degrees(verification.rotationError), 'f', 1) + " degrees";
+        else if (verification.status == PlacementStatus::MISPLACED)
+            reason = "Placed cube not found at its destination";
+
+        emit log(Message(MessageType::WARNING_LOG, "Construction", reason + ", processing image..."));
+        verificationPolicy.recordFailure();
+        robotCommandState = RobotCommandState::CONSTRUCT_VISION;
+        handleRobotCommand();
+        return;
+    }
+
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Placement verified in " + QString::number(verification.duration, 'f', 1) + " ms"));
+
+    // Update the position of the placed cube in the cube world model and the clearance map with the observed position
+    glm::vec3 placedPos(round(verification.pose.position.x), round(placementPose.position.z) - 32, round(verification.pose.position.y));
+    structCubes.last()->setPosition(placedPos);
+    clearancePlanner.setObstacles(sourceCubes + structCubes);
+
+    // The rest of the workspace is monitored for disturbances so the full scene does not need to be processed again
+    monitorWorkspace(images[0]);
+
+    // Activate the cube task execution phase of the construction state to place the next cube
+    robotCommandState = RobotCommandState::CONSTRUCT_TASK;
+    handleRobotCommand();
+}
+
+void ConstructionView::continueMonitoring(const Cube* placedCube)
+{
+    // The placed cube left its source position and occludes the top faces of the structure cubes below its destination
+    for (int i = 0; i < monitoredCubes.size(); ++i)
+    {
+        if (monitoredCubes[i] == Q_NULLPTR)
+            continue;
+
+        glm::vec3 cubePos = monitoredCubes[i]->getPosition();
+        bool covered = std::abs(cubePos.x - placementPose.position.x) < 64 && std::abs(cubePos.z - placementPose.position.y) < 64
+            && cubePos.y + 32 < placementPose.position.z;
+        if (monitoredCubes[i] == placedCube || covered)
+            monitoredCubes[i] = Q_NULLPTR;
+    }
+}
+
+void ConstructionView::monitorWorkspace(const cv::Mat& image)
+{
+    if (!vision.isCalibrated() || image.empty())
+        return;
+
+    std::vector<cv::Rect> regions;
+    monitoredCubes.clear();
+    for (Cube* cube : sourceCubes + structCubes)
+    {
+        // Monitor the centre of the top face which remains inside the top face for any cube rotation
+        glm::vec3 cubePos = cube->getPosition();
+        cv::Point3d faceMin(cubePos.x - MONITORED_FACE_RADIUS, cubePos.z - MONITORED_FACE_RADIUS, -(cubePos.y + 32));
+        cv::Point3d faceMax(cubePos.x + MONITORED_FACE_RADIUS, cubePos.z + MONITORED_FACE_RADIUS, -(cubePos.y + 32));
+        regions.push_back(vision.projectWorldBox(faceMin, faceMax));
+        monitoredCubes.append(cube);
+    }
+
+    workspaceMonitor->setOccludedRegions({});
+    workspaceMonitor->setReference(image, regions);
+}
+
+bool ConstructionView::isSceneAcceptable(QString& reason) const
+{
+    SceneQuality quality = multiCameraVision->getSceneQuality();
+
+    // The extrinsic calibration determines the world position of every detection
+    if (quality.reprojectionError > MAX_REPROJECTION_ERROR)
+    {
+        reason = quality.fiducialCount < 4 ? "Too few fiducials found for calibration" :
+            "Fiducial reprojection error of " + QString::number(quality.reprojectionError, 'f', 1) + " pixels";
+        return false;
+    }
+
+    // Independent cubes are used to decide if a cube is missing or the construction has failed
+    for (double shapeScore : quality.cubeShapeScores)
+    {
+        if (shapeScore < MIN_SHAPE_SCORE)
+        {
+            reason = "Cube contour shape score of " + QString::number(shapeScore, 'f', 2);
+            return false;
+        }
+    }
+
+    for (double residual : quality.cubeResiduals)
+    {
+        if (residual > MAX_POSE_RESIDUAL)
+        {
+            reason = "Cube pose residual of " + QString::number(residual, 'f', 1);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ConstructionView::workspaceDisturbanceDetected(int region)
+{
+    if (region < 0 || region >= monitoredCubes.size() || cubeTasks.isEmpty())
+        return;
+
+    // The source cube of the current task is expected to move
+    Cube* cube = monitoredCubes[region];
+    if (cube == Q_NULLPTR || cube == cubeTasks.first()->getSourceCube())
+        return;
+
+    QString cubeType = structCubes.contains(cube) ? "Structure" : "Source";
+    emit log(Message(MessageType::WARNING_LOG, "Construction", cubeType + " cube disturbed while the robot was moving"));
+    workspaceDisturbed = true;
+}
+
+cv::Point3i ConstructionView::getCapturePosition() const
+{
+    // The whole workspace must be visible to find a missing cube and occlusions can only be predicted once calibrated
+    if (missingCubes > 0 || !vision.isCalibrated())
+        return ROBOT_VISION_POS;
+
+    // The fiducials are required for calibration and the known cubes are required to classify the detected cubes
+    // The whole workspace floor is required to detect a displaced or unexpected cube
+    std::vector<std::vector<cv::Point>> regions = { vision.getRegionOfInterest() };
+    QMap<int, cv::Point3i> fiducialWorldPoints = vision.getFiducialWorldPoints();
+    for (const cv::Point3i& fiducial : fiducialWorldPoints)
+    {
+        cv::Point3d fiducialMin(fiducial.x - FIDUCIAL_RADIUS, fiducial.y - FIDUCIAL_RADIUS, fiducial.z);
+        cv::Point3d fiducialMax(fiducial.x + FIDUCIAL_RADIUS, fiducial.y + FIDUCIAL_RADIUS, fiducial.z);
+        regions.push_back(vision.projectWorldPolygon(fiducialMin, fiducialMax));
+    }
+
+    for (Cube* cube : sourceCubes + structCubes)
+    {
+        // Convert position to the top face in the world frame
+        glm::vec3 cubePos = cube->getPosition();
+        cv::Point3d faceMin(cubePos.x - 32, cubePos.z - 32, -(cubePos.y + 32));
+        cv::Point3d faceMax(cubePos.x + 32, cubePos.z + 32, -(cubePos.y + 32));
+        regions.push_back(vision.projectWorldPolygon(faceMin, faceMax));
+    }
+
+    // Capture without moving if possible, otherwise raise the robot and move it towards the vision position
+    cv::Point3i currentPosition(robot->getXPosition(), robot->getYPosition(), robot->getZPosition());
+    if (!isCaptureOccluded(currentPosition, regions))
+        return currentPosition;
+
+    cv::Point3i raisedPosition(currentPosition.x, currentPosition.y, ROBOT_VISION_POS.z);
+    for (int i = 0; i < CAPTURE_PATH_SAMPLES; ++i)
+    {
+        double t = (double) i / CAPTURE_PATH_SAMPLES;
+        cv::Point3i position(round(raisedPosition.x + t * (ROBOT_VISION_POS.x - raisedPosition.x)),
+            round(raisedPosition.y + t * (ROBOT_VISION_POS.y - raisedPosition.y)), ROBOT_VISION_POS.z);
+        if (!isCaptureOccluded(position, regions))
+            return position;
+    }
+
+    return ROBOT_VISION_POS;
+}
+
+bool ConstructionView::isCaptureOccluded(const cv::Point3i& robotPosition, const std::vector<std::vector<cv::Point>>& regions) const
+{
+    // Convert the robot position to the world frame
+    cv::Point3d endEffector(robotPosition.x, robotPosition.y, -robotPosition.z * 64.0 / 318);
+    for (const std::vector<cv::Point>& occludedRegion : vision.getRobotOccludedRegions(endEffector))
+    {
+        for (const std::vector<cv::Point>& region : regions)
+        {
+            std::vector<cv::Point> intersection;
+            if (cv::intersectConvexConvex(occludedRegion, region, intersection) > 0)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void ConstructionView::setVisionOccludedRegions()
+{
+    // The robot does not occlude the workspace at the vision position, so no cube contours are ignored there
+    // Otherwise cube contours in the image regions occluded by the robot are ignored
+    if (robot->getXPosition() == ROBOT_VISION_POS.x && robot->getYPosition() == ROBOT_VISION_POS.y && robot->getZPosition() == ROBOT_VISION_POS.z)
+    {
+        vision.setOccludedRegions({});
+        return;
+    }
+
+    cv::Point3d endEffectorPosition(robot->getXPosition(), robot->getYPosition(), -robot->getZPosition() * 64.0 / 318);
+    vision.setOccludedRegions(vision.getRobotOccludedRegions(endEffectorPosition));
+}
+
 void ConstructionView::handleProcessSceneState()
 {
     // Verify robot is in the correct position to ensure there are no occlusions
@@ -818,6 +1931,8 @@ void ConstructionView::handleProcessSceneState()
 
     emit log(Message(MessageType::INFO_LOG, "Construction", "Processing image..."));
 
+    setVisionOccludedRegions();
+
     // Create list of source cube top face centroids excluding source cube being processed by current task
     std::vector<cv::Point3i> sourceCentroids;
     for (int i = 0; i < sourceCubes.size(); ++i)
@@ -842,13 +1957,13 @@ void ConstructionView::handleProcessSceneState()
         structCentroids.push_back(centroid);
     }
 
-    // Capture frame from camera
-    cv::Mat input;
-    for (int i = 0; i < discardFrames; i++)
-        *camera >> input;
+    // Capture frame from each camera
+    workspaceMonitor->clearReference();
+    multiCameraVision->setOccluders({});
+    std::vector<cv::Mat> images = multiCameraVision->captureImages(discardFrames);
 
-    // Process image
-    vision.processScene(input, true, &sourceCentroids);
+    // Process images
+    processVisionScene(images, true, &sourceCentroids);
 
     robotCommandState = RobotCommandState::IDLE;
 }
@@ -856,6 +1971,20 @@ void ConstructionView::handleProcessSceneState()
 void ConstructionView::setCamera(cv::VideoCapture* camera)
 {
     this->camera = camera;
+
+    // The system camera is processed by the computer vision system shown in the vision view
+    multiCameraVision->addCamera(camera, &vision);
+
+    // Frames captured on the capture thread of a frame grabber are checked for disturbances on that thread
+    FrameGrabber* frameGrabber = dynamic_cast<FrameGrabber*>(camera);
+    if (frameGrabber != Q_NULLPTR)
+        connect(frameGrabber, &FrameGrabber::frameCaptured, workspaceMonitor, &WorkspaceMonitor::processFrame, Qt::DirectConnection);
+}
+
+void ConstructionView::addCamera(cv::VideoCapture* camera)
+{
+    multiCameraVision->addCamera(camera);
+    emit log(Message(MessageType::INFO_LOG, "Construction", "Added camera " + QString::number(multiCameraVision->getCameraCount())));
 }
 
 void ConstructionView::processSceneClicked()
@@ -868,6 +1997,42 @@ void ConstructionView::processSceneClicked()
     handleRobotCommand();
 }
 
+void ConstructionView::recordSessionToggled(bool checked)
+{
+    if (checked)
+    {
+        // Select session file to record to
+        QString fileName = QFileDialog::getSaveFileName(this, "Record Vision Session", "", "Vision Session Files (*.session)");
+
+        // Revert the toggle if no file was selected or the file could not be created
+        if (fileName.isNull() || !sessionRecorder->open(fileName))
+        {
+            recordSession->setChecked(false);
+            return;
+        }
+
+        recordSession->setText("Stop Recording");
+    }
+    else
+    {
+        sessionRecorder->close();
+        recordSession->setText("Record Session");
+    }
+}
+
+void ConstructionView::processVisionScene(const std::vector<cv::Mat>& images, bool calibrate, std::vector<cv::Point3i>* sourceCentroids,
+    std::vector<cv::Point3i>* structCentroids)
+{
+    // Record the scene inputs before processing so that the scene can be reproduced if processing fails
+    if (sessionRecorder->isRecording() && !images.empty())
+    {
+        cv::Vec4i robotPosition(robot->getXPosition(), robot->getYPosition(), robot->getZPosition(), robot->getRPosition());
+        sessionRecorder->recordFrame(images[0], calibrate, sourceCentroids, structCentroids, robotPosition);
+    }
+
+    multiCameraVision->processScene(images, calibrate, sourceCentroids, structCentroids);
+}
+
 void ConstructionView::sleepRobotClicked()
 {
     robot->sleep();
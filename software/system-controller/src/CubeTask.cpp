@@ -22,6 +22,88 @@ Cube* CubeTask::getDestinationCube()
 	return destinationCube;
 }
 
+void CubeTask::setPlacement(const StructurePlacement& placement)
+{
+	this->placement = placement;
+}
+
+glm::vec3 CubeTask::getDestinationTopFace()
+{
+	// The OpenGL coordinates of the cube are converted to the robot coordinate system here
+	glm::vec3 destinationCubePos = destinationCube->getPosition();
+	glm::vec2 position = placement.getPosition(glm::round(destinationCubePos));
+	return glm::vec3(position.x, position.y, destinationCubePos.y + 32);
+}
+
+RobotPosition CubeTask::getDestinationPosition() const
+{
+	return getTopFacePosition(destinationCube, placement, placeRotation);
+}
+
+double CubeTask::estimateDuration(const MotionModel& motionModel, const RobotPosition& start, const Cube* sourceCube,
+	RobotPosition* end) const
+{
+	return estimateTiming(motionModel, start, sourceCube, end).getDuration();
+}
+
+CubeTaskTiming CubeTask::estimateTiming(const MotionModel& motionModel, const RobotPosition& start, const Cube* sourceCube,
+	RobotPosition* end) const
+{
+	if (sourceCube == Q_NULLPTR)
+		sourceCube = this->sourceCube;
+
+	RobotPosition srcPos = getTopFacePosition(sourceCube, sourcePlacement, pickRotation);
+	RobotPosition destPos = getTopFacePosition(destinationCube, placement, placeRotation);
+
+	// Pick up cube at source
+	CubeTaskTiming timing;
+	RobotPosition position = start;
+	for (const RobotPosition& waypoint : getPickPath(start, srcPos))
+	{
+		timing.pick += motionModel.getMoveTime(position, waypoint);
+		position = waypoint;
+	}
+	timing.grip = motionModel.getGripperTime() + motionModel.getDelayTime();
+
+	// Place cube at destination
+	for (const RobotPosition& waypoint : getPlacePath(position, destPos))
+	{
+		timing.place += motionModel.getMoveTime(position, waypoint);
+		position = waypoint;
+	}
+	timing.release = motionModel.getGripperTime() + motionModel.getDelayTime();
+	timing.raise = motionModel.getMoveTime(position, destPos) + motionModel.getGripperTime();
+
+	if (end != Q_NULLPTR)
+		*end = destPos;
+
+	return timing;
+}
+
+void CubeTask::setPreferredRotations(int pickRotation, int placeRotation)
+{
+	this->pickRotation = pickRotation;
+	this->placeRotation = placeRotation;
+}
+
+std::vector<int> CubeTask::getPickRotations() const
+{
+	if (sourceCube == Q_NULLPTR)
+		return std::vector<int>();
+
+	return MotionModel::getEquivalentRotations(round(glm::degrees(sourceCube->getPitch()) / 1.8));
+}
+
+std::vector<int> CubeTask::getPlaceRotations() const
+{
+	return MotionModel::getEquivalentRotations(round(glm::degrees(destinationCube->getPitch()) / 1.8));
+}
+
+void CubeTask::setClearancePlanner(const ClearancePlanner* clearancePlanner)
+{
+	this->clearancePlanner = clearancePlanner;
+}
+
 bool CubeTask::isComplete()
 {
 	return taskComplete;
@@ -41,58 +123,49 @@ void CubeTask::performNextStep(Robot* robot)
 		return;
 	}
 
-	// Initialize the position where the cube is picked up from (x, y, z)
-	// The OpenGL coordinates of the cube are converted to the robot coordinate system here
-	glm::vec3 sourceCubePos = sourceCube->getPosition();
-	int srcRot = round(glm::degrees(sourceCube->getPitch()) / 1.8);
-	int srcPos[3] = {round(sourceCubePos.x),
-		round(sourceCubePos.z), 
-		round((sourceCubePos.y + 32) * cubeLengthVSteps / cubeLengthHSteps)};
+	// Move to the next position of the transfer in progress
+	if (!transferPath.isEmpty())
+	{
+		RobotPosition waypoint = transferPath.takeFirst();
+		transferWaypoint = waypoint;
+		robot->setPosition(waypoint.x, waypoint.y, waypoint.z, waypoint.r);
+		return;
+	}
 
-	// Initialize the position where the cube is placed (x, y, z)
-	// The OpenGL coordinates of the cube are converted to the robot coordinate system here
-	glm::vec3 destinationCubePos = destinationCube->getPosition();
-	int destRot = round(glm::degrees(destinationCube->getPitch()) / 1.8);
-	int destPos[3] = { round(destinationCubePos.x) + xOffset, 
-		round(destinationCubePos.z) + yOffset,
-		round((destinationCubePos.y + 32) * cubeLengthVSteps / cubeLengthHSteps)};
+	// Initialize the positions where the cube is picked up and placed
+	RobotPosition srcPos = getTopFacePosition(sourceCube, sourcePlacement, pickRotation);
+	RobotPosition destPos = getTopFacePosition(destinationCube, placement, placeRotation);
+	RobotPosition robotPos = { robot->getXPosition(), robot->getYPosition(), robot->getZPosition(), robot->getRPosition() };
 
 	// Instruct robot to perform next step
 	switch (++step)
 	{
 	// Pick up cube at source
 	case 1:
-		robot->setPosition(srcPos[0], srcPos[1], robot->getZPosition(), srcRot);
+		transferPath = getPickPath(robotPos, srcPos);
+		performNextStep(robot);
 		break;
 	case 2:
-		robot->setPosition(srcPos[0], srcPos[1], srcPos[2] - bufferAction, srcRot);
+		robot->actuateGripper();
 		break;
 	case 3:
-		robot->actuateGripper();
+		robot->delay();
 		break;
+	// Place cube at destination
 	case 4:
-		robot->delay();
+		transferPath = getPlacePath(robotPos, destPos);
+		performNextStep(robot);
 		break;
 	case 5:
-		robot->setPosition(srcPos[0], srcPos[1], destPos[2] + cubeLengthVSteps, srcRot);
+		robot->releaseGripper();
 		break;
-	// Place cube at destination
 	case 6:
-		robot->setPosition(destPos[0], destPos[1], destPos[2] + cubeLengthVSteps, destRot);
+		robot->delay();
 		break;
 	case 7:
-		robot->setPosition(destPos[0], destPos[1], destPos[2] - bufferAction, destRot);
+		robot->setPosition(destPos.x, destPos.y, destPos.z, destPos.r);
 		break;
 	case 8:
-		robot->releaseGripper();
-		break;
-	case 9:
-		robot->delay();
-		break;
-	case 10:
-		robot->setPosition(destPos[0], destPos[1], destPos[2], destRot);
-		break;
-	case 11:
 		robot->resetGripper();
 		taskComplete = true;
 		break;
@@ -103,15 +176,71 @@ void CubeTask::resetSteps(Robot* robot)
 {
 	step = 0;
 	taskComplete = false;
+	transferPath.clear();
 	robot->resetGripper();
 }
 
 bool CubeTask::expectGrippedCube()
 {
-	return step == 5 || step == 6 || step == 7;
+	return step == 4;
+}
+
+bool CubeTask::isCubeReleased()
+{
+	return step >= 5;
+}
+
+void CubeTask::replanTransfer(Robot* robot)
+{
+	// The remaining moves are only valid from the most recent target position of the transfer
+	// A completed transfer is also replanned since the next step grips or releases the cube at its end
+	RobotPosition robotPos = { robot->getXPosition(), robot->getYPosition(), robot->getZPosition(), robot->getRPosition() };
+	if ((step != 1 && step != 4) || robotPos == transferWaypoint)
+		return;
+
+	if (step == 1)
+		transferPath = getPickPath(robotPos, getTopFacePosition(sourceCube, sourcePlacement, pickRotation));
+	else if (step == 4)
+		transferPath = getPlacePath(robotPos, getTopFacePosition(destinationCube, placement, placeRotation));
 }
 
 bool CubeTask::isStarted()
 {
 	return step > 0;
+}
+
+QList<RobotPosition> CubeTask::getPickPath(const RobotPosition& start, const RobotPosition& srcPos) const
+{
+	RobotPosition grip = { srcPos.x, srcPos.y, srcPos.z - bufferAction, srcPos.r };
+	if (clearancePlanner != Q_NULLPTR)
+		return clearancePlanner->planTransfer(start, grip, false);
+
+	// Move above the source at the current height and descend
+	RobotPosition above = { srcPos.x, srcPos.y, start.z, srcPos.r };
+	return { above, grip };
+}
+
+QList<RobotPosition> CubeTask::getPlacePath(const RobotPosition& start, const RobotPosition& destPos) const
+{
+	RobotPosition release = { destPos.x, destPos.y, destPos.z - bufferAction, destPos.r };
+	if (clearancePlanner != Q_NULLPTR)
+		return clearancePlanner->planTransfer(start, release, true);
+
+	// Lift one cube length above the destination height, traverse and descend
+	RobotPosition lift = { start.x, start.y, destPos.z + cubeLengthVSteps, start.r };
+	RobotPosition above = { destPos.x, destPos.y, destPos.z + cubeLengthVSteps, destPos.r };
+	return { lift, above, release };
+}
+
+RobotPosition CubeTask::getTopFacePosition(const Cube* cube, const StructurePlacement& placement, int rotation) const
+{
+	glm::vec3 cubePos = cube->getPosition();
+	glm::vec2 horizontalPos = placement.getPosition(glm::round(cubePos));
+
+	RobotPosition position;
+	position.x = horizontalPos.x;
+	position.y = horizontalPos.y;
+	position.z = round((cubePos.y + 32) * cubeLengthVSteps / cubeLengthHSteps);
+	position.r = MotionModel::getEquivalentRotation(round(glm::degrees(cube->getPitch()) / 1.8), rotation);
+	return position;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "CubeWorldModel.h"
+#include <algorithm>
 
 CubeWorldModel::CubeWorldModel(unsigned int cubeSideLength, unsigned int cubeMargin, QObject* parent) : QObject(parent) 
 {
@@ -95,6 +96,12 @@ void CubeWorldModel::clearCubes()
 	lastCubeID = 0;
 }
 
+void CubeWorldModel::reserveCubeIDs()
+{
+	for (int i = 0; i < cubes.size(); ++i)
+		lastCubeID = std::max(lastCubeID, cubes[i]->getCubeID());
+}
+
 void CubeWorldModel::selectCube(const Cube* cube)
 {
 	// Unselect currently selected cube
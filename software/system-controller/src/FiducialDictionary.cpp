@@ -0,0 +1,54 @@
+#include "FiducialDictionary.h"
+
+FiducialDecoding FiducialDictionary::decode(const int cells[CELL_COUNT])
+{
+	// Pack the classified cells into a codeword and mask out the unclassified cells
+	int observed = 0;
+	int classifiedMask = 0;
+	int erasures = 0;
+	for (int i = 0; i < CELL_COUNT; ++i)
+	{
+		if (cells[i] < 0)
+		{
+			erasures++;
+			continue;
+		}
+
+		observed |= (cells[i] & 1) << i;
+		classifiedMask |= 1 << i;
+	}
+
+	// Find the closest table entry over the classified cells
+	int closest = 0;
+	int closestDistance = CELL_COUNT + 1;
+	bool ambiguous = false;
+	for (int i = 0; i < 4 * FIDUCIAL_COUNT; ++i)
+	{
+		int distance = countCellDifferences(observed, TABLE[i].codeword & classifiedMask);
+		if (distance < closestDistance)
+		{
+			closest = i;
+			closestDistance = distance;
+			ambiguous = false;
+		}
+		else if (distance == closestDistance)
+		{
+			// Another fiducial or orientation is equally close
+			ambiguous = true;
+		}
+	}
+
+	// Each error consumes twice the distance of an erasure
+	// The closest entry is rejected if it is not unique, which the error bound rules out for a dictionary of the minimum distance
+	FiducialDecoding decoding;
+	decoding.errors = closestDistance;
+	decoding.erasures = erasures;
+	if (2 * closestDistance + erasures >= MIN_DISTANCE || ambiguous)
+		return decoding;
+
+	decoding.id = TABLE[closest].id;
+	decoding.rotation = TABLE[closest].rotation;
+	decoding.confidence = 1 - (double) (2 * closestDistance + erasures) / MIN_DISTANCE;
+
+	return decoding;
+}
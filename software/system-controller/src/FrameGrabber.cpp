@@ -0,0 +1,173 @@
+#include "FrameGrabber.h"
+#include <QMutexLocker>
+#include <QDeadlineTimer>
+
+FrameGrabber::FrameGrabber(cv::VideoCapture* camera, int capacity, QObject* parent) : QThread(parent)
+{
+	this->camera = camera;
+	frames.resize(std::max(1, capacity));
+	captureTimer.start();
+
+	// Messages logged on the capture thread are queued to the logger
+	qRegisterMetaType<Message>();
+}
+
+FrameGrabber::~FrameGrabber()
+{
+	stop();
+}
+
+void FrameGrabber::stop()
+{
+	requestInterruption();
+	wait();
+}
+
+void FrameGrabber::setFrameInterval(int interval)
+{
+	frameInterval = std::max(0, interval);
+}
+
+std::vector<cv::Mat> FrameGrabber::getRecentFrames(int count) const
+{
+	QMutexLocker locker(&frameMutex);
+
+	std::vector<cv::Mat> recentFrames;
+	int available = (int) std::min<qint64>(frameCount, frames.size());
+	for (int i = 0; i < std::min(count, available); ++i)
+		recentFrames.push_back(frames[(frameCount - 1 - i) % frames.size()]);
+
+	return recentFrames;
+}
+
+void FrameGrabber::run()
+{
+	bool captureFailed = false;
+	while (!isInterruptionRequested())
+	{
+		qint64 captureStart = captureTimer.elapsed();
+
+		// Capture frame
+		cv::Mat frame;
+		bool captured;
+		{
+			QMutexLocker locker(&cameraMutex);
+			captured = camera->isOpened() && camera->read(frame) && !frame.empty();
+		}
+
+		if (!captured)
+		{
+			// Report the failure once until a frame is captured again
+			if (!captureFailed)
+				emit log(Message(MessageType::WARNING_LOG, "Frame Grabber", "Failed to capture frame"));
+			captureFailed = true;
+
+			// Wait before retrying so that an unavailable camera does not occupy the thread
+			msleep(100);
+			continue;
+		}
+		captureFailed = false;
+
+		// Add frame to the ring buffer and wake any readers waiting for it
+		qint64 timestamp = captureTimer.elapsed();
+		{
+			QMutexLocker locker(&frameMutex);
+			frames[frameCount % frames.size()] = frame;
+			frameCount++;
+		}
+		frameAvailable.wakeAll();
+
+		emit frameCaptured(frame, timestamp);
+
+		// Limit the capture rate
+		qint64 captureTime = captureTimer.elapsed() - captureStart;
+		int interval = frameInterval;
+		if (captureTime < interval)
+			msleep(interval - captureTime);
+	}
+}
+
+bool FrameGrabber::isOpened() const
+{
+	QMutexLocker locker(&cameraMutex);
+	return camera->isOpened();
+}
+
+void FrameGrabber::release()
+{
+	stop();
+
+	QMutexLocker locker(&frameMutex);
+	for (cv::Mat& frame : frames)
+		frame.release();
+	frameCount = 0;
+	grabbedFrame = -1;
+}
+
+bool FrameGrabber::grab()
+{
+	QMutexLocker locker(&frameMutex);
+
+	// Wait for a frame newer than the previously grabbed frame
+	QDeadlineTimer deadline(FRAME_TIMEOUT);
+	while (frameCount - 1 <= grabbedFrame)
+	{
+		if (!frameAvailable.wait(&frameMutex, deadline))
+			return false;
+	}
+
+	grabbedFrame = frameCount - 1;
+	return true;
+}
+
+bool FrameGrabber::retrieve(cv::OutputArray image, int flag)
+{
+	Q_UNUSED(flag);
+
+	QMutexLocker locker(&frameMutex);
+
+	// Check that the grabbed frame has not been overwritten in the ring buffer
+	if (grabbedFrame < 0 || frameCount - grabbedFrame > (qint64) frames.size())
+	{
+		image.release();
+		return false;
+	}
+
+	frames[grabbedFrame % frames.size()].copyTo(image);
+	return true;
+}
+
+bool FrameGrabber::read(cv::OutputArray image)
+{
+	if (grab())
+		return retrieve(image);
+
+	image.release();
+	return false;
+}
+
+bool FrameGrabber::tryRead(cv::OutputArray image) const
+{
+	QMutexLocker locker(&frameMutex);
+
+	if (frameCount == 0)
+	{
+		image.release();
+		return false;
+	}
+
+	frames[(frameCount - 1) % frames.size()].copyTo(image);
+	return true;
+}
+
+bool FrameGrabber::set(int propId, double value)
+{
+	QMutexLocker locker(&cameraMutex);
+	return camera->set(propId, value);
+}
+
+double FrameGrabber::get(int propId) const
+{
+	QMutexLocker locker(&cameraMutex);
+	return camera->get(propId);
+}
@@ -1,6 +1,7 @@
 #include "HomeView.h"
 #include "iostream"
 #include "Packet.h"
+#include "FrameGrabber.h"
 #include <QSerialPort>
 #include <QList>
 
@@ -108,8 +109,18 @@ void HomeView::refreshAvailablePorts()
 void HomeView::updateCameraFeed()
 {
     // Capture frame from camera
+    // The most recent frame of a frame grabber is displayed so that the user interface does not wait for the camera
     cv::Mat frame;
-    *camera >> frame;
+    FrameGrabber* frameGrabber = dynamic_cast<FrameGrabber*>(camera);
+    if (frameGrabber != Q_NULLPTR)
+    {
+        if (!frameGrabber->tryRead(frame))
+            return;
+    }
+    else
+    {
+        *camera >> frame;
+    }
 
     // Display image in camera feed
     cv::resize(frame, frame, cv::Size(), 0.4, 0.4);
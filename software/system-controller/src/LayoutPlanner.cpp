@@ -0,0 +1,253 @@
+#include "LayoutPlanner.h"
+#include <algorithm>
+#include <cmath>
+
+LayoutPlanner::LayoutPlanner(QObject* parent) : QObject(parent)
+{
+	taskSequencer = new TaskSequencer(this);
+	sourceAssigner = new SourceAssigner(this);
+	connect(taskSequencer, &TaskSequencer::log, this, &LayoutPlanner::log);
+	connect(sourceAssigner, &SourceAssigner::log, this, &LayoutPlanner::log);
+}
+
+void LayoutPlanner::setMotionModel(const MotionModel& motionModel)
+{
+	this->motionModel = motionModel;
+	clearancePlanner.setMotionModel(motionModel);
+	taskSequencer->setMotionModel(motionModel);
+	sourceAssigner->setMotionModel(motionModel);
+	buildSimulator.setMotionModel(motionModel);
+}
+
+void LayoutPlanner::setVisionPosition(const RobotPosition& position)
+{
+	visionPosition = position;
+	buildSimulator.setVisionPosition(position);
+}
+
+void LayoutPlanner::setVerificationInterval(int interval)
+{
+	buildSimulator.setVerificationInterval(interval);
+}
+
+bool LayoutPlanner::plan(const ConstructionPlanner* planner, LayoutPlan& plan)
+{
+	QList<Cube*> buildOrder = planner->getBuildOrder();
+	int capacity = MAGAZINE_ROWS * MAGAZINE_SLOTS;
+	if (buildOrder.isEmpty())
+		return false;
+	if (buildOrder.size() > capacity)
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Layout Planner", "The model has more cubes than the " + QString::number(capacity)
+			+ " slots of the source magazine"));
+		return false;
+	}
+	int count = std::min((int) buildOrder.size() + spareCubes, capacity);
+
+	// Find the destination positions relative to the build model origin for each orientation
+	std::vector<glm::vec2> destinations[4];
+	for (int orientation = 0; orientation < 4; ++orientation)
+	{
+		StructurePlacement turned = { 0, 0, orientation };
+		for (const Cube* cube : buildOrder)
+			destinations[orientation].push_back(turned.getPosition(glm::round(cube->getPosition())));
+	}
+
+	// Screen the placements on the coarse grid for every orientation and magazine layout
+	// The best placement of each orientation and magazine layout is refined on the fine grid
+	QList<Candidate> candidates;
+	for (int orientation = 0; orientation < 4; ++orientation)
+	{
+		glm::vec2 minPos = destinations[orientation][0];
+		glm::vec2 maxPos = destinations[orientation][0];
+		for (const glm::vec2& destination : destinations[orientation])
+		{
+			minPos = glm::min(minPos, destination);
+			maxPos = glm::max(maxPos, destination);
+		}
+
+		for (int rows = 1; rows <= MAGAZINE_ROWS; ++rows)
+		{
+			int slotCount = (count + rows - 1) / rows;
+			if (slotCount > MAGAZINE_SLOTS)
+				continue;
+
+			for (int firstRow = 0; firstRow + rows <= MAGAZINE_ROWS; ++firstRow)
+			{
+				for (int firstSlot = 0; firstSlot + slotCount <= MAGAZINE_SLOTS; ++firstSlot)
+				{
+					Candidate best;
+					best.plan.sourceLayout = getSourceLayout(firstRow, rows, firstSlot, slotCount, count);
+					for (int x = ceil(-minPos.x); x <= RobotLimits::X_MAX - maxPos.x; x += coarseStep)
+					{
+						for (int y = ceil(-minPos.y); y <= RobotLimits::Y_MAX - maxPos.y; y += coarseStep)
+						{
+							StructurePlacement placement = { x, y, orientation };
+							double cost = screen(destinations[orientation], placement, best.plan.sourceLayout);
+							if (cost >= 0 && (best.cost < 0 || cost < best.cost))
+							{
+								best.plan.placement = placement;
+								best.cost = cost;
+							}
+						}
+					}
+
+					if (best.cost < 0)
+						continue;
+
+					StructurePlacement coarse = best.plan.placement;
+					for (int dx = fineStep - coarseStep; dx < coarseStep; dx += fineStep)
+					{
+						for (int dy = fineStep - coarseStep; dy < coarseStep; dy += fineStep)
+						{
+							StructurePlacement placement = { coarse.x + dx, coarse.y + dy, orientation };
+							double cost = screen(destinations[orientation], placement, best.plan.sourceLayout);
+							if (cost >= 0 && cost < best.cost)
+							{
+								best.plan.placement = placement;
+								best.cost = cost;
+							}
+						}
+					}
+
+					candidates.append(best);
+				}
+			}
+		}
+	}
+
+	if (candidates.isEmpty())
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Layout Planner", "The model does not fit in the robot workspace with the source magazine"));
+		return false;
+	}
+
+	// Plan and simulate the construction of the best screened candidates
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+	double bestDuration = -1;
+	for (int i = 0; i < candidates.size() && i < plannedCandidates; ++i)
+	{
+		const SourceLayout& layout = candidates[i].plan.sourceLayout;
+		QVector<Cube*> sources;
+		for (int j = 0; j < layout.positions.size(); ++j)
+		{
+			Cube* source = new Cube(j, cubeLength, Q_NULLPTR);
+			source->setPosition(layout.positions[j]);
+			sources.append(source);
+		}
+
+		double duration = estimate(planner, candidates[i].plan.placement, sources);
+		if (duration >= 0 && (bestDuration < 0 || duration < bestDuration))
+		{
+			bestDuration = duration;
+			plan = candidates[i].plan;
+			plan.duration = duration;
+		}
+
+		for (Cube* source : sources)
+			delete source;
+	}
+
+	return bestDuration >= 0;
+}
+
+double LayoutPlanner::estimate(const ConstructionPlanner* planner, const StructurePlacement& placement, const QVector<Cube*>& sources)
+{
+	QList<Cube*> buildOrder = planner->getBuildOrder();
+	if (buildOrder.isEmpty() || sources.size() < buildOrder.size())
+		return -1;
+
+	// Plan the construction as the construction view does, starting at the vision position
+	// The simulation maps the structure as it is built, as the construction view does after each placement
+	clearancePlanner.setObstacles(sources);
+	QList<CubeTask*> tasks;
+	for (Cube* cube : buildOrder)
+	{
+		CubeTask* task = new CubeTask();
+		task->setDestinationCube(cube);
+		task->setPlacement(placement);
+		task->setClearancePlanner(&clearancePlanner);
+		tasks.append(task);
+	}
+
+	tasks = taskSequencer->sequence(tasks, sources, visionPosition, planner);
+	sourceAssigner->clearCache();
+	sourceAssigner->assign(tasks, sources, visionPosition, visionPosition.z);
+	rotationPlanner.plan(tasks, visionPosition.r);
+	BuildEstimate estimate = buildSimulator.simulate(tasks, visionPosition, &clearancePlanner, sources);
+
+	for (CubeTask* task : tasks)
+		delete task;
+
+	return estimate.total;
+}
+
+SourceLayout LayoutPlanner::getSourceLayout(int firstRow, int rows, int firstSlot, int slotCount, int count) const
+{
+	SourceLayout layout;
+	layout.firstRow = firstRow;
+	layout.rows = rows;
+	layout.firstSlot = firstSlot;
+	layout.slotCount = slotCount;
+
+	// Fill the rows from the row furthest from the near edge, which is the row nearest the structure
+	float slotStep = ((float) (MAGAZINE_X_MAX - MAGAZINE_X_MIN)) / (MAGAZINE_SLOTS - 1);
+	for (int row = firstRow + rows - 1; row >= firstRow; --row)
+	{
+		for (int slot = firstSlot; slot < firstSlot + slotCount && layout.positions.size() < count; ++slot)
+		{
+			int xPos = std::round(MAGAZINE_X_MIN + slotStep * slot);
+			layout.positions.append(glm::vec3(xPos, cubeLength / 2, row * MAGAZINE_ROW_PITCH));
+		}
+	}
+
+	return layout;
+}
+
+double LayoutPlanner::screen(const std::vector<glm::vec2>& destinations, const StructurePlacement& placement, const SourceLayout& layout) const
+{
+	// Find the extent of the magazine block
+	glm::vec2 magazineMin(layout.positions[0].x, layout.positions[0].z);
+	glm::vec2 magazineMax = magazineMin;
+	for (const glm::vec3& position : layout.positions)
+	{
+		magazineMin = glm::min(magazineMin, glm::vec2(position.x, position.z));
+		magazineMax = glm::max(magazineMax, glm::vec2(position.x, position.z));
+	}
+
+	// Every destination must be within reach and clear of the magazine
+	float separation = cubeLength + magazineClearance;
+	std::vector<glm::vec2> positions;
+	for (const glm::vec2& destination : destinations)
+	{
+		glm::vec2 position(destination.x + placement.x, destination.y + placement.y);
+		if (position.x < 0 || position.x > RobotLimits::X_MAX || position.y < 0 || position.y > RobotLimits::Y_MAX)
+			return -1;
+		if (position.x > magazineMin.x - separation && position.x < magazineMax.x + separation
+			&& position.y > magazineMin.y - separation && position.y < magazineMax.y + separation)
+		{
+			return -1;
+		}
+
+		positions.push_back(position);
+	}
+
+	// Each source and destination pair costs a return trip at a constant height
+	std::vector<std::vector<double>> costs(positions.size(), std::vector<double>(layout.positions.size()));
+	for (int i = 0; i < positions.size(); ++i)
+	{
+		RobotPosition destination = { (int) round(positions[i].x), (int) round(positions[i].y), 0, 0 };
+		for (int j = 0; j < layout.positions.size(); ++j)
+		{
+			RobotPosition source = { (int) round(layout.positions[j].x), (int) round(layout.positions[j].z), 0, 0 };
+			costs[i][j] = 2 * motionModel.getMoveTime(source, destination);
+		}
+	}
+
+	std::vector<int> assignment = SourceAssigner::solveAssignment(costs);
+	double cost = 0;
+	for (int i = 0; i < positions.size(); ++i)
+		cost += costs[i][assignment[i]];
+
+	return cost;
+}
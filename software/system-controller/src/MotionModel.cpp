@@ -0,0 +1,148 @@
+#include "MotionModel.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+MotionModel::MotionModel()
+{
+	// Acceleration parameters of the firmware motor module
+	axes[(int) MotionAxis::X] = createProfile(32, 49, 50, 32);
+	axes[(int) MotionAxis::Y] = createProfile(16, 99, 50, 16);
+	axes[(int) MotionAxis::Z] = createProfile(32, 29, 50, 32);
+	axes[(int) MotionAxis::R] = createProfile(32, 199, 0, 32);
+}
+
+double MotionModel::getAxisTime(MotionAxis axis, int steps) const
+{
+	const AxisProfile& profile = axes[(int) axis];
+	int blocks = std::abs(steps) * profile.stepMode / profile.updatePeriod;
+	return getElapsedTime(profile, blocks, blocks) / 1000;
+}
+
+double MotionModel::getAxisProgress(MotionAxis axis, int steps, double time) const
+{
+	const AxisProfile& profile = axes[(int) axis];
+	int blocks = std::abs(steps) * profile.stepMode / profile.updatePeriod;
+	double elapsed = time * 1000;
+	if (blocks == 0 || elapsed >= getElapsedTime(profile, blocks, blocks))
+		return 1;
+
+	// Find the number of completed blocks by a binary search of the elapsed time, which increases with each block
+	int low = 0;
+	int high = blocks;
+	while (high - low > 1)
+	{
+		int mid = (low + high) / 2;
+		if (getElapsedTime(profile, blocks, mid) <= elapsed)
+			low = mid;
+		else
+			high = mid;
+	}
+
+	// Interpolate within the current block
+	double blockStart = getElapsedTime(profile, blocks, low);
+	double blockEnd = getElapsedTime(profile, blocks, low + 1);
+	return (low + (elapsed - blockStart) / (blockEnd - blockStart)) / blocks;
+}
+
+RobotPosition MotionModel::getMovePosition(const RobotPosition& start, const RobotPosition& end, double time) const
+{
+	RobotPosition position;
+	position.x = round(start.x + (end.x - start.x) * getAxisProgress(MotionAxis::X, end.x - start.x, time));
+	position.y = round(start.y + (end.y - start.y) * getAxisProgress(MotionAxis::Y, end.y - start.y, time));
+	position.z = round(start.z + (end.z - start.z) * getAxisProgress(MotionAxis::Z, end.z - start.z, time));
+	position.r = round(start.r + (end.r - start.r) * getAxisProgress(MotionAxis::R, end.r - start.r, time));
+	return position;
+}
+
+double MotionModel::getMoveTime(const RobotPosition& start, const RobotPosition& end) const
+{
+	double time = getAxisTime(MotionAxis::X, end.x - start.x);
+	time = std::max(time, getAxisTime(MotionAxis::Y, end.y - start.y));
+	time = std::max(time, getAxisTime(MotionAxis::Z, end.z - start.z));
+	time = std::max(time, getAxisTime(MotionAxis::R, end.r - start.r));
+
+	return time + commandTime;
+}
+
+std::vector<int> MotionModel::getEquivalentRotations(int rotation)
+{
+	// Find the smallest equivalent rotation within the limits
+	int first = MIN_ROTATION + ((rotation - MIN_ROTATION) % QUARTER_TURN + QUARTER_TURN) % QUARTER_TURN;
+
+	std::vector<int> rotations;
+	for (int equivalent = first; equivalent <= MAX_ROTATION; equivalent += QUARTER_TURN)
+		rotations.push_back(equivalent);
+
+	return rotations;
+}
+
+int MotionModel::getEquivalentRotation(int rotation, int reference)
+{
+	std::vector<int> rotations = getEquivalentRotations(rotation);
+	int closest = rotations[0];
+	for (int equivalent : rotations)
+	{
+		if (std::abs(equivalent - reference) < std::abs(closest - reference))
+			closest = equivalent;
+	}
+
+	return closest;
+}
+
+double MotionModel::getGripperTime() const
+{
+	return commandTime;
+}
+
+double MotionModel::getDelayTime() const
+{
+	return delayTime + commandTime;
+}
+
+double MotionModel::getRampTime(const AxisProfile& profile, int count)
+{
+	if (count <= profile.rampBlocks + 1)
+		return profile.rampTimes[count];
+	return profile.rampTimes[profile.rampBlocks + 1] + (count - profile.rampBlocks - 1) * profile.cruiseTime;
+}
+
+double MotionModel::getElapsedTime(const AxisProfile& profile, int blocks, int count)
+{
+	int accelerationBlocks = (blocks + 1) / 2;
+	int decelerationBlocks = blocks / 2;
+	if (count <= accelerationBlocks)
+		return getRampTime(profile, count);
+
+	// The remaining blocks of the completed deceleration blocks run from the deceleration block count down
+	return getRampTime(profile, accelerationBlocks) + getRampTime(profile, decelerationBlocks + 1)
+		- getRampTime(profile, blocks - count + 1);
+}
+
+MotionModel::AxisProfile MotionModel::createProfile(int stepMode, int minPeriod, int rampFullSteps, int updatePeriod)
+{
+	AxisProfile profile;
+	profile.stepMode = stepMode;
+	profile.updatePeriod = updatePeriod;
+	profile.rampBlocks = rampFullSteps * stepMode / updatePeriod;
+
+	// Compute the table of timer periods as the firmware does and accumulate the duration of each block of microsteps
+	// Each microstep takes two timer periods of one microsecond per count
+	const double minVelocityFraction = 0.1;
+	profile.rampTimes.push_back(0);
+	for (int i = 0; i <= profile.rampBlocks; ++i)
+	{
+		int period = minPeriod;
+		if (profile.rampBlocks > 0)
+		{
+			float velocity = ((float) i / profile.rampBlocks + minVelocityFraction) / minPeriod / (1 + minVelocityFraction);
+			period = (int) (1 / velocity);
+		}
+
+		double blockTime = 2.0 * (period + 1) * updatePeriod;
+		profile.rampTimes.push_back(profile.rampTimes.back() + blockTime);
+		profile.cruiseTime = blockTime;
+	}
+
+	return profile;
+}
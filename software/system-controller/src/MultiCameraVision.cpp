@@ -0,0 +1,314 @@
+#include "MultiCameraVision.h"
+#include <future>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+MultiCameraVision::MultiCameraVision(QObject* parent) : QObject(parent)
+{
+	// Messages logged by the computer vision systems are passed from the worker threads to the logger
+	qRegisterMetaType<Message>();
+}
+
+int MultiCameraVision::addCamera(cv::VideoCapture* camera, Vision* vision)
+{
+	if (vision == Q_NULLPTR)
+		vision = new Vision(this);
+
+	connect(vision, &Vision::log, this, &MultiCameraVision::log);
+
+	cameras.append(camera);
+	visions.append(vision);
+	imageSizes.append(cv::Size());
+
+	return cameras.size() - 1;
+}
+
+int MultiCameraVision::getCameraCount() const
+{
+	return cameras.size();
+}
+
+Vision* MultiCameraVision::getVision(int camera) const
+{
+	return visions[camera];
+}
+
+void MultiCameraVision::setOccluders(const std::vector<VisionOccluder>& occluders)
+{
+	this->occluders = occluders;
+}
+
+std::vector<cv::Mat> MultiCameraVision::captureImages(int discardFrames)
+{
+	// Read from each camera on its own worker so that the buffered frames of all cameras are discarded concurrently
+	std::vector<std::future<cv::Mat>> captures;
+	for (int i = 0; i < cameras.size(); ++i)
+	{
+		cv::VideoCapture* camera = cameras[i];
+		captures.push_back(std::async(std::launch::async, [camera, discardFrames]() {
+			cv::Mat image;
+			for (int j = 0; j < std::max(1, discardFrames); ++j)
+				*camera >> image;
+			return image;
+		}));
+	}
+
+	std::vector<cv::Mat> images;
+	for (int i = 0; i < captures.size(); ++i)
+		images.push_back(captures[i].get());
+
+	return images;
+}
+
+void MultiCameraVision::processScene(const std::vector<cv::Mat>& images, bool calibrate, std::vector<cv::Point3i>* sourceCentroids,
+	std::vector<cv::Point3i>* structCentroids)
+{
+	// Process the scene of each camera on its own worker
+	// The computer vision systems share no state so no synchronization is required
+	std::vector<std::future<void>> workers;
+	for (int i = 0; i < visions.size() && i < images.size(); ++i)
+	{
+		if (images[i].empty())
+		{
+			emit log(Message(MessageType::WARNING_LOG, "Multi-Camera Vision", "No image captured by camera " + QString::number(i)));
+			imageSizes[i] = cv::Size();
+			continue;
+		}
+
+		Vision* vision = visions[i];
+		const cv::Mat& image = images[i];
+		imageSizes[i] = image.size();
+		workers.push_back(std::async(std::launch::async, [vision, &image, calibrate, sourceCentroids, structCentroids]() {
+			vision->processScene(image, calibrate, sourceCentroids, structCentroids);
+		}));
+	}
+
+	for (int i = 0; i < workers.size(); ++i)
+		workers[i].get();
+
+	// Known cubes occlude the line of sight to the cubes behind them
+	sceneOccluders = occluders;
+	for (std::vector<cv::Point3i>* centroids : { sourceCentroids, structCentroids })
+	{
+		if (centroids == Q_NULLPTR)
+			continue;
+
+		for (const cv::Point3i& centroid : *centroids)
+		{
+			VisionOccluder occluder;
+			occluder.min = cv::Point3d(centroid.x - cubeLength / 2, centroid.y - cubeLength / 2, -centroid.z);
+			occluder.max = cv::Point3d(centroid.x + cubeLength / 2, centroid.y + cubeLength / 2, 0);
+			sceneOccluders.push_back(occluder);
+		}
+	}
+}
+
+bool MultiCameraVision::isCalibrated() const
+{
+	for (int i = 0; i < visions.size(); ++i)
+	{
+		if (visions[i]->isCalibrated())
+			return true;
+	}
+
+	return false;
+}
+
+SceneQuality MultiCameraVision::getSceneQuality() const
+{
+	SceneQuality quality;
+	bool first = true;
+	for (int i = 0; i < visions.size(); ++i)
+	{
+		// Only cameras that captured the most recent scene are considered
+		if (imageSizes[i].empty())
+			continue;
+
+		SceneQuality cameraQuality = visions[i]->getSceneQuality();
+		quality.fiducialCount = first ? cameraQuality.fiducialCount : std::min(quality.fiducialCount, cameraQuality.fiducialCount);
+		quality.reprojectionError = std::max(quality.reprojectionError, cameraQuality.reprojectionError);
+		quality.cubeResiduals.insert(quality.cubeResiduals.end(), cameraQuality.cubeResiduals.begin(), cameraQuality.cubeResiduals.end());
+		quality.cubeShapeScores.insert(quality.cubeShapeScores.end(), cameraQuality.cubeShapeScores.begin(), cameraQuality.cubeShapeScores.end());
+		first = false;
+	}
+
+	// A scene without any captured images has no calibration
+	if (first)
+		quality.reprojectionError = std::numeric_limits<double>::infinity();
+
+	return quality;
+}
+
+std::vector<cv::Point3i> MultiCameraVision::getCubeCentroids(const int z) const
+{
+	std::vector<cv::Point3i> centroids;
+	for (const CubePose& pose : getCubePoses(z))
+		centroids.push_back(cv::Point3i(std::round(pose.position.x), std::round(pose.position.y), z));
+
+	return centroids;
+}
+
+std::vector<float> MultiCameraVision::getCubeRotations(const int z) const
+{
+	std::vector<float> rotations;
+	for (const CubePose& pose : getCubePoses(z))
+		rotations.push_back(pose.rotation);
+
+	return rotations;
+}
+
+std::vector<CubePose> MultiCameraVision::getCubePoses(const int z) const
+{
+	return getClusterPoses(fuseDetections(z));
+}
+
+std::vector<CubePose> MultiCameraVision::getLayeredCubePoses() const
+{
+	return getClusterPoses(fuseDetections(0));
+}
+
+std::vector<CubePose> MultiCameraVision::getClusterPoses(const std::vector<CubeCluster>& clusters) const
+{
+	std::vector<CubePose> poses;
+	for (const CubeCluster& cluster : clusters)
+	{
+		// Snap the mean height of the detections to the closest layer
+		double height = std::max(1.0, std::round(-cluster.position.z / cubeLength)) * cubeLength;
+
+		// Cube rotations are only defined up to a quarter turn so the mean is taken at four times the rotation
+		CubePose pose;
+		pose.position = cv::Point3d(cluster.position.x, cluster.position.y, height);
+		pose.rotation = std::atan2(cluster.rotation.y, cluster.rotation.x) / 4;
+		pose.residual = cluster.residual / cluster.cameras.size();
+		poses.push_back(pose);
+	}
+
+	return poses;
+}
+
+std::vector<MultiCameraVision::CubeCluster> MultiCameraVision::fuseDetections(int z) const
+{
+	// Cluster the detections of each calibrated camera
+	// A cluster contains at most one detection from each camera
+	std::vector<CubeCluster> clusters;
+	for (int i = 0; i < visions.size(); ++i)
+	{
+		if (!visions[i]->isCalibrated() || imageSizes[i].empty())
+			continue;
+
+		std::vector<CubePose> poses = z > 0 ? visions[i]->getCubePoses(z) : visions[i]->getLayeredCubePoses();
+		for (int j = 0; j < poses.size(); ++j)
+		{
+			cv::Point3d position(poses[j].position.x, poses[j].position.y, -poses[j].position.z);
+
+			// Find the closest cluster that has not been detected by this camera
+			int closest = -1;
+			double closestDistance = clusterDistance;
+			for (int k = 0; k < clusters.size(); ++k)
+			{
+				double distance = std::hypot(clusters[k].position.x - position.x, clusters[k].position.y - position.y);
+				if (distance <= closestDistance && !clusters[k].cameras.contains(i))
+				{
+					closest = k;
+					closestDistance = distance;
+				}
+			}
+
+			cv::Point2d rotation(std::cos(4 * poses[j].rotation), std::sin(4 * poses[j].rotation));
+			if (closest < 0)
+			{
+				CubeCluster cluster;
+				cluster.position = position;
+				cluster.rotation = rotation;
+				cluster.residual = poses[j].residual;
+				cluster.cameras.append(i);
+				clusters.push_back(cluster);
+			}
+			else
+			{
+				// Update the running mean of the cluster position
+				CubeCluster& cluster = clusters[closest];
+				cluster.position = (cluster.position * cluster.cameras.size() + position) / (cluster.cameras.size() + 1.0);
+				cluster.rotation += rotation;
+				cluster.residual += poses[j].residual;
+				cluster.cameras.append(i);
+			}
+		}
+	}
+
+	// Accept the clusters detected by at least half of the cameras with an unobstructed view of the cube
+	std::vector<CubeCluster> accepted;
+	for (const CubeCluster& cluster : clusters)
+	{
+		int visibleCameras = 0;
+		for (int i = 0; i < visions.size(); ++i)
+		{
+			if (cluster.cameras.contains(i) || isVisible(i, cluster.position))
+				++visibleCameras;
+		}
+
+		if (2 * cluster.cameras.size() >= visibleCameras)
+			accepted.push_back(cluster);
+	}
+
+	return accepted;
+}
+
+bool MultiCameraVision::isVisible(int camera, const cv::Point3d& worldPoint) const
+{
+	Vision* vision = visions[camera];
+	if (!vision->isCalibrated() || imageSizes[camera].empty())
+		return false;
+
+	// Check that the point is in the camera image
+	cv::Point imagePoint = vision->projectWorldPoint(worldPoint);
+	if (!cv::Rect(cv::Point(0, 0), imageSizes[camera]).contains(imagePoint))
+		return false;
+
+	// Check that the line of sight to the point is not occluded
+	cv::Point3d cameraPosition = vision->getCameraPosition();
+	for (const VisionOccluder& occluder : sceneOccluders)
+	{
+		if (intersects(cameraPosition, worldPoint, occluder))
+			return false;
+	}
+
+	return true;
+}
+
+bool MultiCameraVision::intersects(const cv::Point3d& start, const cv::Point3d& end, const VisionOccluder& occluder) const
+{
+	// Ignore occluders containing the end point with a tolerance for the estimated cube position
+	const double tolerance = 1;
+	if (end.x >= occluder.min.x - tolerance && end.x <= occluder.max.x + tolerance && end.y >= occluder.min.y - tolerance
+		&& end.y <= occluder.max.y + tolerance && end.z >= occluder.min.z - tolerance && end.z <= occluder.max.z + tolerance)
+		return false;
+
+	// Clip the segment against each pair of parallel box planes
+	double tMin = 0;
+	double tMax = 1;
+	double origin[3] = { start.x, start.y, start.z };
+	double direction[3] = { end.x - start.x, end.y - start.y, end.z - start.z };
+	double boxMin[3] = { occluder.min.x, occluder.min.y, occluder.min.z };
+	double boxMax[3] = { occluder.max.x, occluder.max.y, occluder.max.z };
+	for (int i = 0; i < 3; ++i)
+	{
+		if (std::abs(direction[i]) < 1e-9)
+		{
+			// Segment is parallel to the planes and must lie between them
+			if (origin[i] < boxMin[i] || origin[i] > boxMax[i])
+				return false;
+			continue;
+		}
+
+		double t1 = (boxMin[i] - origin[i]) / direction[i];
+		double t2 = (boxMax[i] - origin[i]) / direction[i];
+		tMin = std::max(tMin, std::min(t1, t2));
+		tMax = std::min(tMax, std::max(t1, t2));
+		if (tMin > tMax)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,161 @@
+#include "RecoveryPlanner.h"
+#include <algorithm>
+#include <cmath>
+
+RecoveryPlanner::RecoveryPlanner(QObject* parent) : QObject(parent) {}
+
+void RecoveryPlanner::setTolerances(double positionTolerance, double rotationTolerance)
+{
+	this->positionTolerance = positionTolerance;
+	this->rotationTolerance = rotationTolerance;
+}
+
+bool RecoveryPlanner::plan(const QList<CubeTask*>& buildTasks, const QList<DestinationState>& states,
+	const std::vector<CubePose>& detectedCubes, RecoveryPlan& plan)
+{
+	plan = RecoveryPlan();
+	QList<DestinationState> finalStates = states;
+	std::vector<glm::vec3> topFaces;
+	for (CubeTask* task : buildTasks)
+		topFaces.push_back(task->getDestinationTopFace());
+
+	// A placed destination is lost if a destination supporting it is lost
+	// The build order places the supporting destinations first
+	for (int i = 0; i < buildTasks.size(); ++i)
+	{
+		if (finalStates[i] != DestinationState::PLACED)
+			continue;
+
+		for (int j = 0; j < i; ++j)
+		{
+			if (finalStates[j] == DestinationState::DISPLACED && isAbove(topFaces[i], topFaces[j]))
+			{
+				finalStates[i] = DestinationState::DISPLACED;
+				break;
+			}
+		}
+	}
+
+	for (int i = 0; i < buildTasks.size(); ++i)
+	{
+		if (finalStates[i] == DestinationState::DISPLACED)
+			plan.lostTasks.append(buildTasks[i]);
+	}
+
+	// Accept a detected cube as placed at a destination to be placed if it is within the tolerances and fully supported
+	std::vector<bool> detectedUsed(detectedCubes.size(), false);
+	for (int i = 0; i < buildTasks.size(); ++i)
+	{
+		if (finalStates[i] != DestinationState::PENDING && finalStates[i] != DestinationState::DISPLACED)
+			continue;
+
+		bool supported = true;
+		for (int j = 0; j < i && supported; ++j)
+		{
+			if (isAbove(topFaces[i], topFaces[j]) && finalStates[j] != DestinationState::PLACED)
+				supported = false;
+		}
+		if (!supported)
+			continue;
+
+		float destinationRotation = buildTasks[i]->getDestinationCube()->getPitch();
+		for (int k = 0; k < detectedCubes.size(); ++k)
+		{
+			const CubePose& pose = detectedCubes[k];
+			double positionError = std::hypot(pose.position.x - topFaces[i].x, pose.position.y - topFaces[i].y);
+			double heightError = std::abs(pose.position.z - topFaces[i].z);
+
+			// Rotations are compared modulo a quarter turn since the top face is symmetric
+			double rotationError = std::remainder(pose.rotation - destinationRotation, M_PI / 2);
+			if (!detectedUsed[k] && positionError <= positionTolerance && heightError < CUBE_LENGTH / 2
+				&& std::abs(rotationError) <= rotationTolerance)
+			{
+				detectedUsed[k] = true;
+				finalStates[i] = DestinationState::PLACED;
+				plan.occupiedTasks.append(buildTasks[i]);
+				plan.occupyingCubes.append(k);
+				break;
+			}
+		}
+	}
+
+	// The cube task in progress places its cube on the support of its destination, so that support must remain complete
+	for (int i = 0; i < buildTasks.size(); ++i)
+	{
+		if (finalStates[i] != DestinationState::IN_PROGRESS)
+			continue;
+
+		for (int j = 0; j < i; ++j)
+		{
+			if (isAbove(topFaces[i], topFaces[j]) && finalStates[j] != DestinationState::PLACED)
+			{
+				emit log(Message(MessageType::ERROR_LOG, "Recovery Planner", "Support of the destination of the cube task in progress is missing"));
+				return false;
+			}
+		}
+	}
+
+	// The remaining destinations are placed in build order
+	for (int i = 0; i < buildTasks.size(); ++i)
+	{
+		if (finalStates[i] == DestinationState::PENDING || finalStates[i] == DestinationState::DISPLACED)
+			plan.tasks.append(buildTasks[i]);
+	}
+
+	// Find the first task to place a destination in the space occupied by each remaining detected cube
+	std::vector<std::pair<int, int>> blockingCubes;
+	for (int k = 0; k < detectedCubes.size(); ++k)
+	{
+		if (detectedUsed[k])
+			continue;
+
+		const CubePose& pose = detectedCubes[k];
+		int blockedTask = -1;
+		for (int i = 0; i < buildTasks.size() && blockedTask < 0; ++i)
+		{
+			if (finalStates[i] == DestinationState::PLACED)
+				continue;
+
+			double distance = std::hypot(pose.position.x - topFaces[i].x, pose.position.y - topFaces[i].y);
+			bool occupied = distance < FOOTPRINT_DISTANCE && pose.position.z > topFaces[i].z - CUBE_LENGTH / 2;
+			if (!occupied)
+				continue;
+
+			// The destination of the task in progress cannot be cleared before its cube is placed
+			if (finalStates[i] == DestinationState::IN_PROGRESS)
+			{
+				emit log(Message(MessageType::ERROR_LOG, "Recovery Planner", "Destination of the cube task in progress is blocked"));
+				return false;
+			}
+
+			blockedTask = plan.tasks.indexOf(buildTasks[i]);
+		}
+
+		if (blockedTask >= 0)
+			blockingCubes.push_back(std::make_pair(blockedTask, k));
+		else
+			plan.sourceCubes.append(k);
+	}
+
+	// Pick the blocking cubes with the first tasks in the order of the destinations they block
+	// Each blocking cube must be picked no later than the task of the destination it blocks
+	std::sort(blockingCubes.begin(), blockingCubes.end());
+	for (int i = 0; i < blockingCubes.size(); ++i)
+	{
+		if (blockingCubes[i].first < i)
+		{
+			emit log(Message(MessageType::ERROR_LOG, "Recovery Planner", "Too many detected cubes block the destinations to be placed"));
+			return false;
+		}
+
+		plan.sourceCubes.insert(i, blockingCubes[i].second);
+	}
+	plan.blockingCubes = blockingCubes.size();
+
+	return true;
+}
+
+bool RecoveryPlanner::isAbove(const glm::vec3& upper, const glm::vec3& lower) const
+{
+	return std::hypot(upper.x - lower.x, upper.y - lower.y) < CUBE_LENGTH && upper.z > lower.z;
+}
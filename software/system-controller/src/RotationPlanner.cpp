@@ -0,0 +1,78 @@
+#include "RotationPlanner.h"
+#include <cstdlib>
+
+RotationPlanner::RotationPlanner() {}
+
+int RotationPlanner::plan(const QList<CubeTask*>& tasks, int startRotation) const
+{
+	// Each task which has not been started has a pick up stage followed by a placement stage
+	// A task in progress keeps its rotations and the sequence starts from its placement rotation
+	QList<CubeTask*> pendingTasks;
+	std::vector<std::vector<int>> stages;
+	for (CubeTask* task : tasks)
+	{
+		if (task->isStarted())
+		{
+			startRotation = task->getDestinationPosition().r;
+			continue;
+		}
+
+		std::vector<int> pickRotations = task->getPickRotations();
+		std::vector<int> placeRotations = task->getPlaceRotations();
+		pendingTasks.append(task);
+		stages.push_back(pickRotations.empty() ? placeRotations : pickRotations);
+		stages.push_back(placeRotations);
+	}
+
+	if (stages.empty())
+		return 0;
+
+	// Find the minimum total rotation to reach each rotation of each stage and the rotation of the previous stage it is reached from
+	std::vector<std::vector<int>> travel(stages.size());
+	std::vector<std::vector<int>> previous(stages.size());
+	for (int i = 0; i < stages.size(); ++i)
+	{
+		travel[i].assign(stages[i].size(), 0);
+		previous[i].assign(stages[i].size(), 0);
+		for (int j = 0; j < stages[i].size(); ++j)
+		{
+			if (i == 0)
+			{
+				travel[i][j] = std::abs(stages[i][j] - startRotation);
+				continue;
+			}
+
+			for (int k = 0; k < stages[i - 1].size(); ++k)
+			{
+				int candidate = travel[i - 1][k] + std::abs(stages[i][j] - stages[i - 1][k]);
+				if (k == 0 || candidate < travel[i][j])
+				{
+					travel[i][j] = candidate;
+					previous[i][j] = k;
+				}
+			}
+		}
+	}
+
+	// Trace the rotations back from the rotation of the last stage with the minimum total rotation
+	int last = stages.size() - 1;
+	int choice = 0;
+	for (int j = 1; j < stages[last].size(); ++j)
+	{
+		if (travel[last][j] < travel[last][choice])
+			choice = j;
+	}
+	int totalTravel = travel[last][choice];
+
+	std::vector<int> rotations(stages.size());
+	for (int i = last; i >= 0; --i)
+	{
+		rotations[i] = stages[i][choice];
+		choice = previous[i][choice];
+	}
+
+	for (int i = 0; i < pendingTasks.size(); ++i)
+		pendingTasks[i]->setPreferredRotations(rotations[2 * i], rotations[2 * i + 1]);
+
+	return totalTravel;
+}
@@ -0,0 +1,393 @@
+#include "SceneRenderer.h"
+#include "CubeWorldModel.h"
+#include "Vision.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <algorithm>
+
+SceneRenderer::SceneRenderer(QObject* parent) : QObject(parent)
+{
+	// Initialize camera intrinsics and fiducial layout from the computer vision system
+	Vision vision;
+	cameraMatrix = vision.getCameraMatrix();
+	distCoeffs = vision.getDistCoeffs();
+	fiducialWorldPoints = vision.getFiducialWorldPoints();
+
+	// Initialize camera above the centre of the fiducial layout looking straight down onto the workspace
+	cv::Mat rotation = cv::Mat::zeros(3, 1, CV_64F);
+	cv::Mat translation = (cv::Mat_<double>(3, 1) << -460, -463, 2300);
+	setCameraPose(rotation, translation);
+}
+
+void SceneRenderer::setImageSize(const cv::Size& imageSize)
+{
+	this->imageSize = imageSize;
+}
+
+void SceneRenderer::setCameraIntrinsics(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs)
+{
+	cameraMatrix.copyTo(this->cameraMatrix);
+	distCoeffs.copyTo(this->distCoeffs);
+}
+
+void SceneRenderer::setCameraPose(const cv::Mat& rotationVector, const cv::Mat& translationVector)
+{
+	rotationVector.convertTo(this->rotationVector, CV_64F);
+	translationVector.convertTo(this->translationVector, CV_64F);
+	cv::Rodrigues(this->rotationVector, rotationMatrix);
+}
+
+void SceneRenderer::setFiducials(const QMap<int, cv::Point3i>& fiducialWorldPoints)
+{
+	this->fiducialWorldPoints = fiducialWorldPoints;
+}
+
+void SceneRenderer::setImageEffects(double noise, double illumination)
+{
+	this->noise = noise;
+	this->illumination = illumination;
+}
+
+void SceneRenderer::clearCubes()
+{
+	cubes.clear();
+}
+
+void SceneRenderer::addCube(const SceneCube& cube)
+{
+	cubes.push_back(cube);
+}
+
+void SceneRenderer::addCubes(const QList<Cube*>* cubes, SceneCubeRole role, const cv::Point& origin)
+{
+	for (int i = 0; i < cubes->size(); ++i)
+	{
+		// Convert the OpenGL cube centre to the top face centroid in the robot coordinate system
+		glm::vec3 position = cubes->at(i)->getPosition();
+		SceneCube cube;
+		cube.position = cv::Point3d(position.x + origin.x, position.z + origin.y, position.y + cubeLength / 2);
+		cube.rotation = cubes->at(i)->getPitch();
+		cube.role = role;
+		addCube(cube);
+	}
+}
+
+void SceneRenderer::addSourceMagazine()
+{
+	// Three rows of evenly spaced cubes matching the source cubes initialized by the construction view
+	int numCubes = 15;
+	int xStart = 134;
+	int xStop = 1015;
+	float xStep = ((float) (xStop - xStart)) / (numCubes - 1);
+	int rows[3] = { 126, 63, 0 };
+
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int i = numCubes - 1; i >= 0; i--)
+		{
+			SceneCube cube;
+			cube.position = cv::Point3d(std::round(xStart + xStep * i), rows[row], cubeLength);
+			cube.rotation = 0;
+			cube.role = SceneCubeRole::SOURCE;
+			addCube(cube);
+		}
+	}
+}
+
+int SceneRenderer::addRandomCubes(int count, cv::RNG& rng)
+{
+	// Cubes with centres further apart than the cube diagonal cannot overlap for any rotation
+	double minSeparation = cubeLength * 1.5;
+
+	int added = 0;
+	for (int attempt = 0; attempt < count * 100 && added < count; ++attempt)
+	{
+		cv::Point3d position(rng.uniform(0.0, (double) RobotLimits::X_MAX), rng.uniform(0.0, (double) RobotLimits::Y_MAX), cubeLength);
+
+		// Reject positions that overlap existing cubes
+		bool overlap = false;
+		for (int i = 0; i < cubes.size(); ++i)
+		{
+			double dx = cubes[i].position.x - position.x;
+			double dy = cubes[i].position.y - position.y;
+			if (sqrt(dx * dx + dy * dy) < minSeparation)
+			{
+				overlap = true;
+				break;
+			}
+		}
+
+		if (overlap)
+			continue;
+
+		SceneCube cube;
+		cube.position = position;
+		cube.rotation = rng.uniform(-M_PI / 4, M_PI / 4);
+		cube.role = SceneCubeRole::INDEPENDENT;
+		addCube(cube);
+		added++;
+	}
+
+	if (added < count)
+		emit log(Message(MessageType::WARNING_LOG, "Scene Renderer", "Only " + QString::number(added) + " of " + QString::number(count) + " independent cubes could be placed"));
+
+	return added;
+}
+
+const std::vector<SceneCube>& SceneRenderer::getCubes() const
+{
+	return cubes;
+}
+
+cv::Mat SceneRenderer::render(cv::RNG& rng)
+{
+	cv::Mat image(imageSize, CV_8UC3, cv::Scalar::all(backgroundIntensity));
+
+	// Draw fiducials on the base plane with a light border surrounding a 3x3 grid of cells
+	// The border is an eighth of the fiducial length to match the cell sampling grid of the computer vision system
+	double cellLength = fiducialLength / 4.0;
+	for (QMap<int, cv::Point3i>::const_iterator iter = fiducialWorldPoints.constBegin(); iter != fiducialWorldPoints.constEnd(); ++iter)
+	{
+		cv::Point3d centre = iter.value();
+		fillWorldPolygon(image, getSquare(centre, fiducialLength, 0), fiducialLightIntensity);
+
+		int cells[9];
+		getFiducialPattern(iter.key(), cells);
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int col = 0; col < 3; ++col)
+			{
+				if (cells[row * 3 + col] == 0)
+				{
+					cv::Point3d cellCentre = centre + cv::Point3d((col - 1) * cellLength, (row - 1) * cellLength, 0);
+					fillWorldPolygon(image, getSquare(cellCentre, cellLength, 0), fiducialDarkIntensity);
+				}
+			}
+		}
+	}
+
+	// Order cubes from furthest to nearest to the camera so that nearer cubes are drawn over those behind them
+	std::vector<int> order(cubes.size());
+	for (int i = 0; i < order.size(); ++i)
+		order[i] = i;
+
+	std::sort(order.begin(), order.end(), [this](int a, int b) {
+		cv::Point3d centreA(cubes[a].position.x, cubes[a].position.y, -cubes[a].position.z + cubeLength / 2);
+		cv::Point3d centreB(cubes[b].position.x, cubes[b].position.y, -cubes[b].position.z + cubeLength / 2);
+		return getDepth(centreA) > getDepth(centreB);
+	});
+
+	// Camera centre in the world frame used to determine which cube sides face the camera
+	cv::Mat cameraCentreMat = -rotationMatrix.t() * translationVector;
+	cv::Point3d cameraCentre(cameraCentreMat.at<double>(0), cameraCentreMat.at<double>(1), cameraCentreMat.at<double>(2));
+
+	for (int i = 0; i < order.size(); ++i)
+	{
+		const SceneCube& cube = cubes[order[i]];
+
+		// The world frame z-axis points down so the top face is at the negative cube height
+		// The cube rotation is negated to convert to an anti-clockwise rotation in the world xy plane
+		cv::Point3d topCentre(cube.position.x, cube.position.y, -cube.position.z);
+		cv::Point3d bottomCentre = topCentre + cv::Point3d(0, 0, cubeLength);
+		std::vector<cv::Point3d> top = getSquare(topCentre, cubeLength, -cube.rotation);
+		std::vector<cv::Point3d> bottom = getSquare(bottomCentre, cubeLength, -cube.rotation);
+
+		// Draw the sides facing the camera
+		for (int j = 0; j < 4; ++j)
+		{
+			int k = (j + 1) % 4;
+			cv::Point3d sideCentre = (top[j] + top[k] + bottom[j] + bottom[k]) * 0.25;
+			cv::Point3d normal(sideCentre.x - topCentre.x, sideCentre.y - topCentre.y, 0);
+			if (normal.dot(cameraCentre - sideCentre) > 0)
+				fillWorldPolygon(image, { top[j], top[k], bottom[k], bottom[j] }, cubeSideIntensity);
+		}
+
+		// Draw top face with a darker bevel which keeps adjacent cubes separated in the thresholded image
+		fillWorldPolygon(image, top, cubeSideIntensity);
+		fillWorldPolygon(image, getSquare(topCentre, cubeLength - 2 * cubeBevel, -cube.rotation), cubeTopIntensity);
+	}
+
+	// Apply radial illumination falloff
+	if (illumination > 0)
+	{
+		cv::Mat falloff(image.size(), CV_32FC1);
+		double maxRadius2 = pow(image.cols / 2.0, 2) + pow(image.rows / 2.0, 2);
+		for (int v = 0; v < falloff.rows; ++v)
+		{
+			float* row = falloff.ptr<float>(v);
+			for (int u = 0; u < falloff.cols; ++u)
+			{
+				double radius2 = pow(u - image.cols / 2.0, 2) + pow(v - image.rows / 2.0, 2);
+				row[u] = 1 - illumination * radius2 / maxRadius2;
+			}
+		}
+
+		cv::Mat falloff3;
+		cv::cvtColor(falloff, falloff3, cv::COLOR_GRAY2BGR);
+		image.convertTo(image, CV_32FC3);
+		cv::multiply(image, falloff3, image);
+		image.convertTo(image, CV_8UC3);
+	}
+
+	// Apply Gaussian pixel noise
+	if (noise > 0)
+	{
+		cv::Mat noiseImage(image.size(), CV_16SC3);
+		rng.fill(noiseImage, cv::RNG::NORMAL, 0, noise);
+		cv::Mat noisyImage;
+		image.convertTo(noisyImage, CV_16SC3);
+		noisyImage += noiseImage;
+		noisyImage.convertTo(image, CV_8UC3);
+	}
+
+	return image;
+}
+
+void SceneRenderer::renderFrame(cv::RNG& rng, SessionFrame& frame)
+{
+	frame.image = render(rng);
+	frame.calibrate = true;
+	frame.hasSourceCentroids = true;
+	frame.hasStructCentroids = true;
+	frame.hasGroundTruth = true;
+	frame.sourceCentroids.clear();
+	frame.structCentroids.clear();
+	frame.truthCubeCentroids.clear();
+	frame.truthCubeRotations.clear();
+	frame.truthFiducialIds.clear();
+	frame.truthFiducialCentroids.clear();
+
+	// Report the cube centroids in the same form as the construction view
+	for (int i = 0; i < cubes.size(); ++i)
+	{
+		cv::Point3i centroid(std::round(cubes[i].position.x), std::round(cubes[i].position.y), std::round(cubes[i].position.z));
+		switch (cubes[i].role)
+		{
+		case SceneCubeRole::SOURCE:
+			frame.sourceCentroids.push_back(centroid);
+			break;
+		case SceneCubeRole::STRUCTURE:
+			frame.structCentroids.push_back(centroid);
+			break;
+		case SceneCubeRole::INDEPENDENT:
+		{
+			// Map rotation to (-PI / 4, PI / 4] since the cube is symmetric about every quarter turn
+			float rotation = cubes[i].rotation;
+			while (rotation > M_PI / 4)
+				rotation -= M_PI / 2;
+			while (rotation <= -M_PI / 4)
+				rotation += M_PI / 2;
+
+			frame.truthCubeCentroids.push_back(centroid);
+			frame.truthCubeRotations.push_back(rotation);
+			break;
+		}
+		}
+	}
+
+	// Report the fiducials that fall within the image
+	for (QMap<int, cv::Point3i>::const_iterator iter = fiducialWorldPoints.constBegin(); iter != fiducialWorldPoints.constEnd(); ++iter)
+	{
+		std::vector<cv::Point3d> worldPoints = { cv::Point3d(iter.value()) };
+		std::vector<cv::Point2d> imagePoints;
+		cv::projectPoints(worldPoints, rotationVector, translationVector, cameraMatrix, distCoeffs, imagePoints);
+
+		if (imagePoints[0].x >= 0 && imagePoints[0].x < imageSize.width && imagePoints[0].y >= 0 && imagePoints[0].y < imageSize.height)
+		{
+			frame.truthFiducialIds.push_back(iter.key());
+			frame.truthFiducialCentroids.push_back(imagePoints[0]);
+		}
+	}
+}
+
+bool SceneRenderer::renderSession(const QString& modelFileName, const QString& sessionFileName, int frameCount,
+	int independentCubes, unsigned int seed)
+{
+	// Read JSON cube world model from file
+	QFile jsonFile(modelFileName);
+	if (!jsonFile.open(QIODevice::ReadOnly))
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Scene Renderer", "Failed to open cube world model file " + modelFileName));
+		return false;
+	}
+
+	QJsonParseError jsonError;
+	QJsonDocument document = QJsonDocument::fromJson(jsonFile.readAll(), &jsonError);
+	jsonFile.close();
+	if (jsonError.error != QJsonParseError::NoError)
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Scene Renderer", "Failed to read from JSON cube world model file: " + jsonError.errorString()));
+		return false;
+	}
+
+	CubeWorldModel model(64, 10, Q_NULLPTR);
+	connect(&model, &CubeWorldModel::log, this, &SceneRenderer::log);
+	model.read(document.object());
+
+	// Create session file
+	SessionRecorder recorder;
+	connect(&recorder, &SessionRecorder::log, this, &SceneRenderer::log);
+	if (!recorder.open(sessionFileName))
+		return false;
+
+	// Render frames with the structure, source magazine and a random set of independent cubes
+	cv::RNG rng(seed);
+	for (int i = 0; i < frameCount; ++i)
+	{
+		clearCubes();
+		addSourceMagazine();
+		addCubes(model.getCubes(), SceneCubeRole::STRUCTURE, STRUCTURE_ORIGIN);
+		addRandomCubes(independentCubes, rng);
+
+		SessionFrame frame;
+		renderFrame(rng, frame);
+		frame.timestamp = i * 1000;
+		recorder.writeFrame(frame);
+	}
+
+	recorder.close();
+	return true;
+}
+
+void SceneRenderer::getFiducialPattern(int id, int cells[9]) const
+{
+	// Fiducials outside the dictionary are drawn without any light cells
+	int codeword = std::max(0, FiducialDictionary::getCodeword(id));
+	for (int i = 0; i < FiducialDictionary::CELL_COUNT; ++i)
+		cells[i] = (codeword >> i) & 1;
+}
+
+void SceneRenderer::fillWorldPolygon(cv::Mat& image, const std::vector<cv::Point3d>& polygon, int intensity) const
+{
+	// Project polygon to the image frame
+	std::vector<cv::Point2d> imagePoints;
+	cv::projectPoints(polygon, rotationVector, translationVector, cameraMatrix, distCoeffs, imagePoints);
+
+	// Draw with sub-pixel vertex precision
+	const int shift = 4;
+	std::vector<cv::Point> vertices(imagePoints.size());
+	for (int i = 0; i < imagePoints.size(); ++i)
+		vertices[i] = cv::Point(std::round(imagePoints[i].x * (1 << shift)), std::round(imagePoints[i].y * (1 << shift)));
+
+	cv::fillConvexPoly(image, vertices, cv::Scalar::all(intensity), cv::LINE_AA, shift);
+}
+
+std::vector<cv::Point3d> SceneRenderer::getSquare(const cv::Point3d& centre, double length, double rotation) const
+{
+	// Corners are ordered by increasing angle from the positive x-axis starting with the corner at 45 degrees
+	std::vector<cv::Point3d> corners(4);
+	double radius = length / sqrt(2);
+	for (int i = 0; i < 4; ++i)
+	{
+		double angle = rotation + M_PI / 4 + i * M_PI / 2;
+		corners[i] = centre + cv::Point3d(radius * cos(angle), radius * sin(angle), 0);
+	}
+
+	return corners;
+}
+
+double SceneRenderer::getDepth(const cv::Point3d& worldPoint) const
+{
+	cv::Mat cameraPoint = rotationMatrix * cv::Mat(worldPoint, false) + translationVector;
+	return cameraPoint.at<double>(2);
+}
@@ -0,0 +1,278 @@
+#include "SessionPlayer.h"
+#include <QDataStream>
+#include <algorithm>
+
+SessionPlayer::SessionPlayer(QObject* parent) : QObject(parent)
+{
+
+}
+
+SessionPlayer::~SessionPlayer()
+{
+	release();
+}
+
+bool SessionPlayer::openSession(const QString& fileName)
+{
+	// Close any session that is currently being replayed
+	release();
+
+	file.setFileName(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Session Player", "Failed to open session file: " + file.errorString()));
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_6_2);
+
+	// Read and validate header
+	quint32 magic;
+	qint64 indexOffset;
+	stream >> magic >> version >> indexOffset;
+	if (stream.status() != QDataStream::Ok || magic != SessionRecorder::SESSION_MAGIC)
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Session Player", "File is not a valid session file"));
+		file.close();
+		return false;
+	}
+
+	if (version == 0 || version > SessionRecorder::SESSION_VERSION)
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Session Player", "Unsupported session file version " + QString::number(version)));
+		file.close();
+		return false;
+	}
+
+	// Read index from the end of the file or rebuild it if the session was not closed cleanly
+	if (indexOffset > 0 && file.seek(indexOffset))
+	{
+		quint32 count;
+		stream >> count;
+		index.resize(count);
+		for (quint32 i = 0; i < count; ++i)
+			stream >> index[i].offset >> index[i].timestamp;
+
+		if (stream.status() != QDataStream::Ok)
+			rebuildIndex();
+	}
+	else
+	{
+		emit log(Message(MessageType::WARNING_LOG, "Session Player", "Session file has no index, rebuilding from frame records"));
+		rebuildIndex();
+	}
+
+	emit log(Message(MessageType::INFO_LOG, "Session Player", "Loaded session with " + QString::number(index.size()) + " frames"));
+	return true;
+}
+
+void SessionPlayer::rebuildIndex()
+{
+	index.clear();
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_6_2);
+	file.seek(SessionRecorder::SESSION_HEADER_SIZE);
+
+	// Step through the length-prefixed frame records until the end of the file or a truncated record is found
+	while (!file.atEnd())
+	{
+		qint64 offset = file.pos();
+		quint32 length;
+		stream >> length;
+		if (stream.status() != QDataStream::Ok || length == 0xFFFFFFFF || offset + 4 + length > file.size())
+			break;
+
+		// Only the timestamp at the start of the record is decoded
+		qint64 timestamp;
+		stream >> timestamp;
+		if (stream.status() != QDataStream::Ok)
+			break;
+
+		SessionIndexEntry entry;
+		entry.offset = offset;
+		entry.timestamp = timestamp;
+		index.append(entry);
+		file.seek(offset + 4 + length);
+	}
+}
+
+int SessionPlayer::getFrameCount() const
+{
+	return index.size();
+}
+
+bool SessionPlayer::readFrame(int frameIndex, SessionFrame& frame)
+{
+	if (!file.isOpen() || frameIndex < 0 || frameIndex >= index.size())
+		return false;
+
+	// Read frame record
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_6_2);
+	file.seek(index[frameIndex].offset);
+
+	QByteArray record;
+	stream >> record;
+	if (stream.status() != QDataStream::Ok)
+		return false;
+
+	return SessionRecorder::decodeFrame(record, version, frame);
+}
+
+void SessionPlayer::seek(int frameIndex)
+{
+	nextFrame = std::max(0, std::min(frameIndex, (int) index.size()));
+	playbackTimer.invalidate();
+}
+
+void SessionPlayer::setPlaybackMode(SessionPlaybackMode mode)
+{
+	this->mode = mode;
+	playbackTimer.invalidate();
+}
+
+void SessionPlayer::setPlaybackSpeed(double speed)
+{
+	// Restart the playback clock from the current frame so that the speed change does not cause a jump
+	if (grabbedFrame >= 0)
+		nextFrame = grabbedFrame;
+	this->speed = speed > 0 ? speed : 1;
+	playbackTimer.invalidate();
+}
+
+void SessionPlayer::setLooping(bool loop)
+{
+	this->loop = loop;
+}
+
+bool SessionPlayer::isOpened() const
+{
+	return file.isOpen();
+}
+
+void SessionPlayer::release()
+{
+	if (file.isOpen())
+		file.close();
+
+	index.clear();
+	version = 0;
+	nextFrame = 0;
+	grabbedFrame = -1;
+	decodedFrame = -1;
+	decoded = SessionFrame();
+	playbackTimer.invalidate();
+}
+
+bool SessionPlayer::grab()
+{
+	if (!file.isOpen() || index.isEmpty())
+		return false;
+
+	if (mode == SessionPlaybackMode::SEQUENTIAL)
+	{
+		// Advance by a single frame for each grab
+		if (nextFrame >= index.size())
+		{
+			if (!loop)
+				return false;
+			nextFrame = 0;
+		}
+
+		grabbedFrame = nextFrame++;
+		return true;
+	}
+
+	// Start the playback clock from the next frame on the first grab
+	if (!playbackTimer.isValid())
+	{
+		if (nextFrame >= index.size())
+			nextFrame = loop ? 0 : index.size() - 1;
+		playbackStart = index[nextFrame].timestamp;
+		playbackTimer.start();
+	}
+
+	// Select the most recent frame recorded at or before the scaled playback time
+	qint64 playbackTime = playbackStart + (qint64) (playbackTimer.elapsed() * speed);
+	if (loop && playbackTime > index.last().timestamp)
+	{
+		nextFrame = 0;
+		playbackStart = index.first().timestamp;
+		playbackTimer.start();
+		playbackTime = playbackStart;
+	}
+
+	auto frameEntry = std::upper_bound(index.begin(), index.end(), playbackTime,
+		[](qint64 time, const SessionIndexEntry& entry) { return time < entry.timestamp; });
+	grabbedFrame = std::max(0, (int) (frameEntry - index.begin()) - 1);
+	nextFrame = grabbedFrame + 1;
+
+	return true;
+}
+
+bool SessionPlayer::retrieve(cv::OutputArray image, int flag)
+{
+	Q_UNUSED(flag);
+
+	if (grabbedFrame < 0)
+	{
+		image.release();
+		return false;
+	}
+
+	// Decode grabbed frame unless it is already cached
+	// Timed playback often grabs the same frame several times in quick succession
+	if (decodedFrame != grabbedFrame)
+	{
+		if (!readFrame(grabbedFrame, decoded))
+		{
+			emit log(Message(MessageType::ERROR_LOG, "Session Player", "Failed to read frame " + QString::number(grabbedFrame)));
+			decodedFrame = -1;
+			image.release();
+			return false;
+		}
+		decodedFrame = grabbedFrame;
+	}
+
+	decoded.image.copyTo(image);
+	return true;
+}
+
+bool SessionPlayer::read(cv::OutputArray image)
+{
+	if (grab())
+		return retrieve(image);
+
+	image.release();
+	return false;
+}
+
+bool SessionPlayer::set(int propId, double value)
+{
+	if (propId == cv::CAP_PROP_POS_FRAMES)
+	{
+		seek((int) value);
+		return true;
+	}
+
+	return false;
+}
+
+double SessionPlayer::get(int propId) const
+{
+	switch (propId)
+	{
+	case cv::CAP_PROP_POS_FRAMES:
+		return nextFrame;
+	case cv::CAP_PROP_FRAME_COUNT:
+		return index.size();
+	case cv::CAP_PROP_FRAME_WIDTH:
+		return decoded.image.cols;
+	case cv::CAP_PROP_FRAME_HEIGHT:
+		return decoded.image.rows;
+	default:
+		return 0;
+	}
+}
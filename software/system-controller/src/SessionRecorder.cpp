@@ -0,0 +1,228 @@
+#include "SessionRecorder.h"
+
+SessionRecorder::SessionRecorder(QObject* parent) : QObject(parent)
+{
+
+}
+
+SessionRecorder::~SessionRecorder()
+{
+	close();
+}
+
+bool SessionRecorder::open(const QString& fileName)
+{
+	// Close any session that is currently being recorded
+	close();
+
+	// Create session file
+	file.setFileName(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Session Recorder", "Failed to create session file: " + file.errorString()));
+		return false;
+	}
+
+	stream.setDevice(&file);
+	stream.setVersion(QDataStream::Qt_6_2);
+
+	// Write header with a placeholder index offset which is updated when the session is closed
+	stream << SESSION_MAGIC << SESSION_VERSION << (qint64) 0;
+
+	index.clear();
+	sessionTimer.start();
+
+	emit log(Message(MessageType::INFO_LOG, "Session Recorder", "Recording session to " + fileName));
+	return true;
+}
+
+void SessionRecorder::close()
+{
+	if (!file.isOpen())
+		return;
+
+	// Write index to the end of the session file
+	qint64 indexOffset = file.pos();
+	stream << (quint32) index.size();
+	for (int i = 0; i < index.size(); ++i)
+		stream << index[i].offset << index[i].timestamp;
+
+	// Update the index offset in the header
+	file.seek(8);
+	stream << indexOffset;
+
+	stream.setDevice(Q_NULLPTR);
+	file.close();
+
+	emit log(Message(MessageType::INFO_LOG, "Session Recorder", "Session closed with " + QString::number(index.size()) + " frames"));
+}
+
+bool SessionRecorder::isRecording() const
+{
+	return file.isOpen();
+}
+
+int SessionRecorder::getFrameCount() const
+{
+	return index.size();
+}
+
+void SessionRecorder::recordFrame(const cv::Mat& image, bool calibrate, const std::vector<cv::Point3i>* sourceCentroids,
+	const std::vector<cv::Point3i>* structCentroids, const cv::Vec4i& robotPosition)
+{
+	if (!file.isOpen())
+		return;
+
+	// Initialize session frame from the computer vision inputs
+	SessionFrame frame;
+	frame.timestamp = sessionTimer.elapsed();
+	frame.image = image;
+	frame.calibrate = calibrate;
+	frame.hasSourceCentroids = sourceCentroids != Q_NULLPTR;
+	frame.hasStructCentroids = structCentroids != Q_NULLPTR;
+	if (frame.hasSourceCentroids)
+		frame.sourceCentroids = *sourceCentroids;
+	if (frame.hasStructCentroids)
+		frame.structCentroids = *structCentroids;
+	frame.robotPosition = robotPosition;
+
+	writeFrame(frame);
+}
+
+void SessionRecorder::writeFrame(const SessionFrame& frame)
+{
+	if (!file.isOpen())
+		return;
+
+	// Append frame record to the session file
+	SessionIndexEntry entry;
+	entry.offset = file.pos();
+	entry.timestamp = frame.timestamp;
+	stream << encodeFrame(frame);
+	index.append(entry);
+
+	// Flush so that the frames recorded so far survive an unexpected termination
+	file.flush();
+}
+
+QByteArray SessionRecorder::encodeFrame(const SessionFrame& frame)
+{
+	QByteArray record;
+	QDataStream recordStream(&record, QIODevice::WriteOnly);
+	recordStream.setVersion(QDataStream::Qt_6_2);
+
+	// Write scalar frame properties
+	recordStream << frame.timestamp << frame.calibrate;
+	for (int i = 0; i < 4; ++i)
+		recordStream << (qint32) frame.robotPosition[i];
+
+	// Write centroid lists
+	recordStream << frame.hasSourceCentroids << (quint32) frame.sourceCentroids.size();
+	for (const cv::Point3i& centroid : frame.sourceCentroids)
+		recordStream << (qint32) centroid.x << (qint32) centroid.y << (qint32) centroid.z;
+
+	recordStream << frame.hasStructCentroids << (quint32) frame.structCentroids.size();
+	for (const cv::Point3i& centroid : frame.structCentroids)
+		recordStream << (qint32) centroid.x << (qint32) centroid.y << (qint32) centroid.z;
+
+	// Write image with lossless compression
+	// A low compression level is used to keep the recording overhead small
+	std::vector<uchar> imageBytes;
+	if (!frame.image.empty())
+		cv::imencode(".png", frame.image, imageBytes, { cv::IMWRITE_PNG_COMPRESSION, 1 });
+	recordStream << QByteArray((const char*) imageBytes.data(), imageBytes.size());
+
+	// Write ground truth scene description
+	recordStream << frame.hasGroundTruth << (quint32) frame.truthCubeCentroids.size();
+	for (int i = 0; i < frame.truthCubeCentroids.size(); ++i)
+	{
+		const cv::Point3i& centroid = frame.truthCubeCentroids[i];
+		recordStream << (qint32) centroid.x << (qint32) centroid.y << (qint32) centroid.z << frame.truthCubeRotations[i];
+	}
+
+	recordStream << (quint32) frame.truthFiducialIds.size();
+	for (int i = 0; i < frame.truthFiducialIds.size(); ++i)
+		recordStream << (qint32) frame.truthFiducialIds[i] << frame.truthFiducialCentroids[i].x << frame.truthFiducialCentroids[i].y;
+
+	return record;
+}
+
+bool SessionRecorder::decodeFrame(const QByteArray& record, quint32 version, SessionFrame& frame)
+{
+	if (version == 0 || version > SESSION_VERSION)
+		return false;
+
+	QDataStream recordStream(record);
+	recordStream.setVersion(QDataStream::Qt_6_2);
+
+	// Read scalar frame properties
+	recordStream >> frame.timestamp >> frame.calibrate;
+	for (int i = 0; i < 4; ++i)
+	{
+		qint32 value;
+		recordStream >> value;
+		frame.robotPosition[i] = value;
+	}
+
+	// Read centroid lists
+	quint32 count;
+	recordStream >> frame.hasSourceCentroids >> count;
+	frame.sourceCentroids.resize(count);
+	for (quint32 i = 0; i < count; ++i)
+	{
+		qint32 x, y, z;
+		recordStream >> x >> y >> z;
+		frame.sourceCentroids[i] = cv::Point3i(x, y, z);
+	}
+
+	recordStream >> frame.hasStructCentroids >> count;
+	frame.structCentroids.resize(count);
+	for (quint32 i = 0; i < count; ++i)
+	{
+		qint32 x, y, z;
+		recordStream >> x >> y >> z;
+		frame.structCentroids[i] = cv::Point3i(x, y, z);
+	}
+
+	// Read image
+	QByteArray imageBytes;
+	recordStream >> imageBytes;
+	if (recordStream.status() != QDataStream::Ok)
+		return false;
+
+	if (imageBytes.isEmpty())
+		frame.image = cv::Mat();
+	else
+		frame.image = cv::imdecode(cv::Mat(1, imageBytes.size(), CV_8UC1, imageBytes.data()), cv::IMREAD_COLOR);
+
+	// Read ground truth scene description if supported by the format version
+	frame.hasGroundTruth = false;
+	frame.truthCubeCentroids.clear();
+	frame.truthCubeRotations.clear();
+	frame.truthFiducialIds.clear();
+	frame.truthFiducialCentroids.clear();
+	if (version < 2)
+		return true;
+
+	recordStream >> frame.hasGroundTruth >> count;
+	for (quint32 i = 0; i < count; ++i)
+	{
+		qint32 x, y, z;
+		float rotation;
+		recordStream >> x >> y >> z >> rotation;
+		frame.truthCubeCentroids.push_back(cv::Point3i(x, y, z));
+		frame.truthCubeRotations.push_back(rotation);
+	}
+
+	recordStream >> count;
+	for (quint32 i = 0; i < count; ++i)
+	{
+		qint32 id;
+		double u, v;
+		recordStream >> id >> u >> v;
+		frame.truthFiducialIds.push_back(id);
+		frame.truthFiducialCentroids.push_back(cv::Point2d(u, v));
+	}
+
+	return recordStream.status() == QDataStream::Ok;
+}
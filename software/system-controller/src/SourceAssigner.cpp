@@ -0,0 +1,178 @@
+#include "SourceAssigner.h"
+#include <limits>
+
+SourceAssigner::SourceAssigner(QObject* parent) : QObject(parent) {}
+
+void SourceAssigner::setMotionModel(const MotionModel& motionModel)
+{
+	this->motionModel = motionModel;
+	clearCache();
+}
+
+double SourceAssigner::assign(const QList<CubeTask*>& tasks, const QVector<Cube*>& sources, const RobotPosition& position, int raisedHeight)
+{
+	// Find the pending tasks which can be assigned a source cube and the position of the robot at the start of each
+	QList<CubeTask*> pendingTasks;
+	std::vector<RobotPosition> startPositions;
+	std::vector<RobotPosition> raisedPositions;
+	RobotPosition start = position;
+	int unassignedTasks = 0;
+	for (CubeTask* task : tasks)
+	{
+		RobotPosition raisedPosition = task->getDestinationPosition();
+		raisedPosition.z = raisedHeight;
+
+		if (!task->isStarted())
+		{
+			if (pendingTasks.size() < sources.size())
+			{
+				pendingTasks.append(task);
+				startPositions.push_back(start);
+				raisedPositions.push_back(raisedPosition);
+			}
+			else
+			{
+				task->setSourceCube(Q_NULLPTR);
+				unassignedTasks++;
+			}
+		}
+
+		start = raisedPosition;
+	}
+
+	if (pendingTasks.isEmpty())
+		return 0;
+
+	if (unassignedTasks > 0)
+	{
+		emit log(Message(MessageType::WARNING_LOG, "Source Assigner", "No source cubes remain for "
+			+ QString::number(unassignedTasks) + " cube tasks"));
+	}
+
+	// Estimate the duration of each task with each source cube
+	std::vector<std::vector<double>> costs(pendingTasks.size(), std::vector<double>(sources.size()));
+	for (int i = 0; i < pendingTasks.size(); ++i)
+	{
+		for (int j = 0; j < sources.size(); ++j)
+			costs[i][j] = getDuration(pendingTasks[i], sources[j], startPositions[i], raisedPositions[i]);
+	}
+
+	// Assign the source cubes
+	std::vector<int> assignment = solveAssignment(costs);
+	double duration = 0;
+	for (int i = 0; i < pendingTasks.size(); ++i)
+	{
+		pendingTasks[i]->setSourceCube(sources[assignment[i]]);
+		duration += costs[i][assignment[i]];
+	}
+
+	return duration;
+}
+
+void SourceAssigner::clearCache()
+{
+	durations.clear();
+}
+
+double SourceAssigner::getDuration(const CubeTask* task, const Cube* source, const RobotPosition& start, const RobotPosition& raisedPosition)
+{
+	// Use the cached duration if the source cube and the start position are unchanged
+	std::pair<const CubeTask*, const Cube*> key(task, source);
+	auto cached = durations.find(key);
+	if (cached != durations.end() && cached->second.sourcePosition == source->getPosition()
+		&& cached->second.sourcePitch == source->getPitch() && cached->second.start == start)
+	{
+		return cached->second.duration;
+	}
+
+	RobotPosition end;
+	CachedDuration duration;
+	duration.sourcePosition = source->getPosition();
+	duration.sourcePitch = source->getPitch();
+	duration.start = start;
+	duration.duration = task->estimateDuration(motionModel, start, source, &end) + motionModel.getMoveTime(end, raisedPosition);
+	durations[key] = duration;
+
+	return duration.duration;
+}
+
+std::vector<int> SourceAssigner::solveAssignment(const std::vector<std::vector<double>>& costs)
+{
+	// Rows and columns are indexed from one, with column zero used as the root of each augmenting path
+	const double infinity = std::numeric_limits<double>::infinity();
+	int rows = costs.size();
+	int cols = costs.empty() ? 0 : costs[0].size();
+	std::vector<double> u(rows + 1, 0); // Row potentials
+	std::vector<double> v(cols + 1, 0); // Column potentials
+	std::vector<int> rowOfCol(cols + 1, 0); // Row assigned to each column. Zero if the column is unassigned
+	std::vector<int> way(cols + 1, 0); // Previous column on the shortest augmenting path to each column
+
+	// Add the rows one at a time and augment the assignment along the shortest path in the reduced costs
+	for (int row = 1; row <= rows; ++row)
+	{
+		rowOfCol[0] = row;
+		int col = 0;
+		std::vector<double> minReduced(cols + 1, infinity);
+		std::vector<bool> used(cols + 1, false);
+
+		do
+		{
+			used[col] = true;
+			int pathRow = rowOfCol[col];
+			double delta = infinity;
+			int nextCol = 0;
+
+			for (int j = 1; j <= cols; ++j)
+			{
+				if (used[j])
+					continue;
+
+				double reduced = costs[pathRow - 1][j - 1] - u[pathRow] - v[j];
+				if (reduced < minReduced[j])
+				{
+					minReduced[j] = reduced;
+					way[j] = col;
+				}
+
+				if (minReduced[j] < delta)
+				{
+					delta = minReduced[j];
+					nextCol = j;
+				}
+			}
+
+			// Update the potentials so that the reduced cost of the path to the next column is zero
+			for (int j = 0; j <= cols; ++j)
+			{
+				if (used[j])
+				{
+					u[rowOfCol[j]] += delta;
+					v[j] -= delta;
+				}
+				else
+				{
+					minReduced[j] -= delta;
+				}
+			}
+
+			col = nextCol;
+		} while (rowOfCol[col] != 0);
+
+		// Reverse the assignment along the augmenting path
+		do
+		{
+			int previousCol = way[col];
+			rowOfCol[col] = rowOfCol[previousCol];
+			col = previousCol;
+		} while (col != 0);
+	}
+
+	std::vector<int> assignment(rows, -1);
+	for (int j = 1; j <= cols; ++j)
+	{
+		if (rowOfCol[j] != 0)
+			assignment[rowOfCol[j] - 1] = j - 1;
+	}
+
+	return assignment;
+}
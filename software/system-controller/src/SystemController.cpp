@@ -1,4 +1,5 @@
 #include "SystemController.h"
+#include <QCoreApplication>
 
 SystemController::SystemController(QWidget *parent): QWidget(parent)
 {
@@ -6,14 +7,36 @@ SystemController::SystemController(QWidget *parent): QWidget(parent)
 	robot = new Robot(this);
 
 	// Initialize camera
-	camera = new cv::VideoCapture(0);
-	camera->set(cv::CAP_PROP_FRAME_WIDTH, 1920);
-	camera->set(cv::CAP_PROP_FRAME_HEIGHT,1080);
-	camera->set(cv::CAP_PROP_EXPOSURE, CAMERA_EXPOSURE);
-	//camera->set(cv::CAP_PROP_FOCUS, CAMERA_FOCUS);
+	// A recorded vision session is replayed in place of the live camera if the --replay <file> argument is provided
+	QStringList arguments = QCoreApplication::arguments();
+	int replayArgument = arguments.indexOf("--replay");
+	if (replayArgument >= 0 && replayArgument + 1 < arguments.size())
+	{
+		sessionPlayer = new SessionPlayer();
+		camera = sessionPlayer;
 
-	if (!camera->isOpened())
-		messageLog->log(Message(MessageType::ERROR_LOG, "System Controller", "No camera found"));
+		// Optional playback speed multiplier to replay faster than real time
+		int speedArgument = arguments.indexOf("--replay-speed");
+		if (speedArgument >= 0 && speedArgument + 1 < arguments.size())
+			sessionPlayer->setPlaybackSpeed(arguments[speedArgument + 1].toDouble());
+	}
+	else
+	{
+		camera = new cv::VideoCapture(0);
+		camera->set(cv::CAP_PROP_FRAME_WIDTH, 1920);
+		camera->set(cv::CAP_PROP_FRAME_HEIGHT,1080);
+		camera->set(cv::CAP_PROP_EXPOSURE, CAMERA_EXPOSURE);
+		//camera->set(cv::CAP_PROP_FOCUS, CAMERA_FOCUS);
+
+		if (!camera->isOpened())
+			messageLog->log(Message(MessageType::ERROR_LOG, "System Controller", "No camera found"));
+
+		// Capture live frames on a dedicated thread so that the workspace can be monitored while the robot moves
+		// Recorded sessions are read directly to preserve the order in which their frames are played back
+		frameGrabber = new FrameGrabber(camera);
+	}
+
+	cv::VideoCapture* systemCamera = frameGrabber != Q_NULLPTR ? frameGrabber : camera;
 
 	// Initialize views
 	homeView = new HomeView();
@@ -21,9 +44,9 @@ SystemController::SystemController(QWidget *parent): QWidget(parent)
 	constructionView = new ConstructionView();
 
 	homeView->setRobot(robot);
-	homeView->setCamera(camera);
+	homeView->setCamera(systemCamera);
 	constructionView->setRobot(robot);
-	constructionView->setCamera(camera);
+	constructionView->setCamera(systemCamera);
 
 	connect(homeView, &HomeView::robotConnected, this, &SystemController::robotConnected);
 
@@ -66,6 +89,50 @@ SystemController::SystemController(QWidget *parent): QWidget(parent)
 	connect(constructionView, &ConstructionView::log, messageLog, &Logger::log);
 	connect(robot, &Robot::log, messageLog, &Logger::log);
 
+	// Open the replayed session once its messages can be logged
+	if (sessionPlayer != Q_NULLPTR)
+	{
+		connect(sessionPlayer, &SessionPlayer::log, messageLog, &Logger::log);
+		sessionPlayer->openSession(arguments[replayArgument + 1]);
+	}
+
+	// Start capturing live frames once capture failures can be logged
+	if (frameGrabber != Q_NULLPTR)
+	{
+		connect(frameGrabber, &FrameGrabber::log, messageLog, &Logger::log);
+		frameGrabber->start();
+	}
+
+	// Add the additional cameras provided with --camera <device index or session file> arguments
+	for (int i = arguments.indexOf("--camera"); i >= 0 && i + 1 < arguments.size(); i = arguments.indexOf("--camera", i + 1))
+	{
+		bool isDevice;
+		int device = arguments[i + 1].toInt(&isDevice);
+
+		cv::VideoCapture* extraCamera;
+		if (isDevice)
+		{
+			extraCamera = new cv::VideoCapture(device);
+			extraCamera->set(cv::CAP_PROP_FRAME_WIDTH, 1920);
+			extraCamera->set(cv::CAP_PROP_FRAME_HEIGHT, 1080);
+			extraCamera->set(cv::CAP_PROP_EXPOSURE, CAMERA_EXPOSURE);
+
+			if (!extraCamera->isOpened())
+				messageLog->log(Message(MessageType::ERROR_LOG, "System Controller", "No camera found at device " + arguments[i + 1]));
+		}
+		else
+		{
+			// A recorded session stands in for the camera
+			SessionPlayer* player = new SessionPlayer();
+			connect(player, &SessionPlayer::log, messageLog, &Logger::log);
+			player->openSession(arguments[i + 1]);
+			extraCamera = player;
+		}
+
+		extraCameras.append(extraCamera);
+		constructionView->addCamera(extraCamera);
+	}
+
 	// Initialize primary view container
 	viewLayout = new QStackedLayout();
 	viewLayout->addWidget(homeView);
@@ -90,7 +157,10 @@ SystemController::SystemController(QWidget *parent): QWidget(parent)
 
 SystemController::~SystemController()
 {
+	// Stop the capture thread before the camera it reads from is released
+	delete frameGrabber;
 	delete camera;
+	qDeleteAll(extraCameras);
 }
 
 void SystemController::setView()
@@ -0,0 +1,257 @@
+#include "TaskSequencer.h"
+#include <QElapsedTimer>
+#include <QMap>
+#include <algorithm>
+
+TaskSequencer::TaskSequencer(QObject* parent) : QObject(parent) {}
+
+void TaskSequencer::setMotionModel(const MotionModel& motionModel)
+{
+	this->motionModel = motionModel;
+}
+
+QList<CubeTask*> TaskSequencer::sequence(const QList<CubeTask*>& tasks, const QVector<Cube*>& sources, const RobotPosition& start,
+	const ConstructionPlanner* planner)
+{
+	this->tasks = tasks;
+	this->sources = sources;
+	this->start = start;
+	initialDuration = 0;
+	sequenceDuration = 0;
+
+	if (tasks.isEmpty() || sources.isEmpty())
+	{
+		emit log(Message(MessageType::WARNING_LOG, "Task Sequencer", "Cannot sequence the cube tasks without source cubes"));
+		return tasks;
+	}
+
+	// Find the task indices of the prerequisites of each task
+	QMap<const Cube*, int> taskIndices;
+	for (int i = 0; i < tasks.size(); ++i)
+		taskIndices.insert(tasks[i]->getDestinationCube(), i);
+
+	prerequisites.assign(tasks.size(), std::vector<int>());
+	dependents.assign(tasks.size(), std::vector<int>());
+	for (int i = 0; i < tasks.size(); ++i)
+	{
+		QList<Cube*> cubes = planner->getPrerequisites(tasks[i]->getDestinationCube());
+		for (int j = 0; j < cubes.size(); ++j)
+		{
+			if (!taskIndices.contains(cubes[j]))
+				continue;
+
+			int prerequisite = taskIndices.value(cubes[j]);
+			prerequisites[i].push_back(prerequisite);
+			dependents[prerequisite].push_back(i);
+		}
+	}
+
+	// Find the position the robot is raised to above the destination of each task for the placement verification
+	raisedPositions.resize(tasks.size());
+	for (int i = 0; i < tasks.size(); ++i)
+	{
+		raisedPositions[i] = tasks[i]->getDestinationPosition();
+		raisedPositions[i].z = start.z;
+	}
+
+	// Estimate the duration of the build order of the planner with the source cubes taken in order
+	std::vector<TaskPair> initialPairs;
+	for (int i = 0; i < tasks.size(); ++i)
+		initialPairs.push_back({ i, i < sources.size() ? i : -1 });
+	initialDuration = estimateDuration(initialPairs);
+
+	// Build and improve the sequence
+	std::vector<TaskPair> pairs = buildNearestNeighbour();
+	improveTwoOpt(pairs);
+	sequenceDuration = estimateDuration(pairs);
+
+	// Keep the build order of the planner if the heuristics did not shorten it
+	if (sequenceDuration >= initialDuration)
+	{
+		pairs = initialPairs;
+		sequenceDuration = initialDuration;
+	}
+
+	QList<CubeTask*> sequencedTasks;
+	QList<Cube*> buildOrder;
+	for (const TaskPair& pair : pairs)
+	{
+		CubeTask* task = tasks[pair.task];
+		task->setSourceCube(pair.source >= 0 ? sources[pair.source] : Q_NULLPTR);
+		sequencedTasks.append(task);
+		buildOrder.append(task->getDestinationCube());
+	}
+
+	// The sequence is only used if it satisfies the constraints of the planner
+	if (!planner->isValidOrder(buildOrder))
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Task Sequencer", "Sequenced cube tasks do not satisfy the build constraints"));
+		for (int i = 0; i < tasks.size(); ++i)
+			tasks[i]->setSourceCube(Q_NULLPTR);
+		sequenceDuration = initialDuration;
+		return tasks;
+	}
+
+	emit log(Message(MessageType::INFO_LOG, "Task Sequencer", "Estimated cube task duration reduced from "
+		+ QString::number(initialDuration / 1000, 'f', 1) + " s to " + QString::number(sequenceDuration / 1000, 'f', 1) + " s"));
+
+	return sequencedTasks;
+}
+
+double TaskSequencer::getInitialDuration() const
+{
+	return initialDuration;
+}
+
+double TaskSequencer::getSequenceDuration() const
+{
+	return sequenceDuration;
+}
+
+double TaskSequencer::getPairDuration(const TaskPair* previous, const TaskPair& pair) const
+{
+	RobotPosition position = previous == Q_NULLPTR ? start : raisedPositions[previous->task];
+
+	// Tasks without a source cube are estimated with a cube from the source cubes
+	const Cube* source = pair.source >= 0 ? sources[pair.source] : sources[0];
+
+	RobotPosition end;
+	double duration = tasks[pair.task]->estimateDuration(motionModel, position, source, &end);
+	return duration + motionModel.getMoveTime(end, raisedPositions[pair.task]);
+}
+
+double TaskSequencer::estimateDuration(const std::vector<TaskPair>& pairs) const
+{
+	double duration = 0;
+	for (int i = 0; i < pairs.size(); ++i)
+		duration += getPairDuration(i > 0 ? &pairs[i - 1] : Q_NULLPTR, pairs[i]);
+
+	return duration;
+}
+
+std::vector<TaskSequencer::TaskPair> TaskSequencer::buildNearestNeighbour() const
+{
+	// Count the unplaced prerequisites of each task and find the tasks without prerequisites
+	std::vector<int> remaining(tasks.size());
+	std::vector<int> ready;
+	for (int i = 0; i < tasks.size(); ++i)
+	{
+		remaining[i] = prerequisites[i].size();
+		if (remaining[i] == 0)
+			ready.push_back(i);
+	}
+
+	std::vector<bool> used(sources.size(), false);
+	int unusedSources = sources.size();
+
+	// Repeatedly choose the quickest pair of a ready task and an unused source cube
+	std::vector<TaskPair> pairs;
+	while (!ready.empty())
+	{
+		const TaskPair* previous = pairs.empty() ? Q_NULLPTR : &pairs.back();
+		int bestReady = 0;
+		TaskPair bestPair = { ready[0], -1 };
+		double bestDuration = -1;
+
+		for (int i = 0; i < ready.size(); ++i)
+		{
+			for (int source = unusedSources > 0 ? 0 : -1; source < (int) sources.size(); ++source)
+			{
+				if (source >= 0 && used[source])
+					continue;
+
+				TaskPair pair = { ready[i], source };
+				double duration = getPairDuration(previous, pair);
+				if (bestDuration < 0 || duration < bestDuration)
+				{
+					bestDuration = duration;
+					bestPair = pair;
+					bestReady = i;
+				}
+
+				// Every pair of a task without a source cube is estimated with the same cube
+				if (source < 0)
+					break;
+			}
+		}
+
+		ready[bestReady] = ready.back();
+		ready.pop_back();
+
+		if (bestPair.source >= 0)
+		{
+			used[bestPair.source] = true;
+			unusedSources--;
+		}
+		pairs.push_back(bestPair);
+
+		for (int dependent : dependents[bestPair.task])
+		{
+			if (--remaining[dependent] == 0)
+				ready.push_back(dependent);
+		}
+	}
+
+	return pairs;
+}
+
+void TaskSequencer::improveTwoOpt(std::vector<TaskPair>& pairs) const
+{
+	int n = pairs.size();
+	QElapsedTimer timer;
+	timer.start();
+
+	// Position of each task in the sequence
+	std::vector<int> positions(tasks.size());
+
+	// Cumulative durations of the sequence in the forward direction and with each pair preceded by the next pair
+	std::vector<double> forward(n + 1);
+	std::vector<double> reverse(n + 1);
+
+	auto update = [&]() {
+		forward[0] = 0;
+		reverse[0] = 0;
+		reverse[1] = 0;
+		for (int i = 0; i < n; ++i)
+		{
+			positions[pairs[i].task] = i;
+			forward[i + 1] = forward[i] + getPairDuration(i > 0 ? &pairs[i - 1] : Q_NULLPTR, pairs[i]);
+			if (i > 0)
+				reverse[i + 1] = reverse[i] + getPairDuration(&pairs[i], pairs[i - 1]);
+		}
+	};
+	update();
+
+	bool improved = true;
+	while (improved && timer.elapsed() < maxOptimizationTime)
+	{
+		improved = false;
+		for (int i = 0; i < n - 1 && timer.elapsed() < maxOptimizationTime; ++i)
+		{
+			for (int j = i + 1; j < n; ++j)
+			{
+				// The segment cannot be reversed if the last task depends on a task in the segment
+				// Every longer segment contains the same dependency
+				bool dependent = false;
+				for (int prerequisite : prerequisites[pairs[j].task])
+					dependent = dependent || (positions[prerequisite] >= i && positions[prerequisite] < j);
+				if (dependent)
+					break;
+
+				// Duration of the segment and the pair after it before and after the reversal
+				int last = std::min(j + 2, n);
+				double currentDuration = forward[last] - forward[i];
+				double reversedDuration = getPairDuration(i > 0 ? &pairs[i - 1] : Q_NULLPTR, pairs[j]) + reverse[j + 1] - reverse[i + 1];
+				if (j + 1 < n)
+					reversedDuration += getPairDuration(&pairs[i], pairs[j + 1]);
+
+				if (reversedDuration < currentDuration - 1e-6)
+				{
+					std::reverse(pairs.begin() + i, pairs.begin() + j + 1);
+					update();
+					improved = true;
+				}
+			}
+		}
+	}
+}
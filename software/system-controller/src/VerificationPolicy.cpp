@@ -0,0 +1,78 @@
+#include "VerificationPolicy.h"
+#include <algorithm>
+
+VerificationPolicy::VerificationPolicy() {}
+
+void VerificationPolicy::reset()
+{
+	unverifiedPlacements = 0;
+	failureScore = 0;
+	startTask();
+}
+
+void VerificationPolicy::setSamplingInterval(int interval)
+{
+	samplingInterval = std::max(interval, 1);
+}
+
+void VerificationPolicy::setPressureThreshold(int threshold)
+{
+	pressureThreshold = threshold;
+}
+
+void VerificationPolicy::startTask()
+{
+	minPressure = 0;
+	maxPressure = 0;
+	pressureSamples = 0;
+}
+
+void VerificationPolicy::addPressureSample(int pressure)
+{
+	minPressure = pressureSamples == 0 ? pressure : std::min(minPressure, pressure);
+	maxPressure = pressureSamples == 0 ? pressure : std::max(maxPressure, pressure);
+	pressureSamples++;
+}
+
+void VerificationPolicy::recordFailure()
+{
+	failureScore += 1;
+}
+
+VerificationLevel VerificationPolicy::decide(int layer, QString& reason)
+{
+	VerificationLevel level = VerificationLevel::NONE;
+	int interval = std::max(samplingInterval - std::max(layer, 0), 1);
+
+	if (failureScore >= SCENE_FAILURE_SCORE)
+	{
+		level = VerificationLevel::SCENE;
+		reason = "Repeated construction failures";
+	}
+	else if (pressureSamples > 0 && minPressure < pressureThreshold + PRESSURE_MARGIN)
+	{
+		level = VerificationLevel::PLACEMENT;
+		reason = "Grip pressure fell to " + QString::number(minPressure) + " while the cube was carried";
+	}
+	else if (pressureSamples > 0 && maxPressure - minPressure > PRESSURE_DROP)
+	{
+		level = VerificationLevel::PLACEMENT;
+		reason = "Grip pressure dropped by " + QString::number(maxPressure - minPressure) + " while the cube was carried";
+	}
+	else if (failureScore >= PLACEMENT_FAILURE_SCORE)
+	{
+		level = VerificationLevel::PLACEMENT;
+		reason = "Recent construction failure";
+	}
+	else if (unverifiedPlacements + 1 >= interval)
+	{
+		level = VerificationLevel::PLACEMENT;
+		reason = "Sampled placement";
+	}
+
+	// The weight of each failure decays with every placement
+	failureScore *= FAILURE_DECAY;
+	unverifiedPlacements = level == VerificationLevel::NONE ? unverifiedPlacements + 1 : 0;
+
+	return level;
+}
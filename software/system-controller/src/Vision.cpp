@@ -1,21 +1,9 @@
 #include "Vision.h"
 #include <iostream>
 #include <string>
-
-// Threshold parameters
-int thresh = 120;
-int maxThresh = 255;
-int blurSize = 0;
-int maxBlurSize = 20;
-
-// Fiducials
-float fiducialThresh = 0.7f;
-int fiducialWidth = 128;
-int fiducialHeight = 128;
-
-// Bounding box parameters
-bool showCoords = true;
-double areaThreshold = 1000;
+#include <limits>
+#include <cstring>
+#include <cmath>
 
 Vision::Vision(QObject* parent) : QObject(parent)
 {
@@ -31,156 +19,181 @@ Vision::Vision(QObject* parent) : QObject(parent)
 
     // Initialize camera matrix and distortion coefficients
     cameraMatrix = (cv::Mat_<double>(3, 3) << fx, 0, cx, 0, fy, cy, 0, 0, 1);
-    distCoeffs = cv::Mat::zeros(4, 1, cv::DataType<double>::type);
-    //distCoeffs = cv::Mat::zeros(5, 1, cv::DataType<double>::type);
-    //distCoeffs.at<double>(0, 0) = 0.09892315624807735;
-    //distCoeffs.at<double>(1, 0) = -0.1682965898621485;
-    //distCoeffs.at<double>(2, 0) = 0.001369242773772446;
-    //distCoeffs.at<double>(3, 0) = -0.0005313360380761699;
-    //distCoeffs.at<double>(4, 0) = -0.01936020510633366;
+    distCoeffs = cv::Mat::zeros(5, 1, cv::DataType<double>::type);
+    distCoeffs.at<double>(0, 0) = 0.09892315624807735;
+    distCoeffs.at<double>(1, 0) = -0.1682965898621485;
+    distCoeffs.at<double>(2, 0) = 0.001369242773772446;
+    distCoeffs.at<double>(3, 0) = -0.0005313360380761699;
+    distCoeffs.at<double>(4, 0) = -0.01936020510633366;
 
     // Initialize coordinates of bounding box for computer vision region of interest in world coordinates
-    visionBoundBox[0] = ROBOT_X_MIN - 340;
-    visionBoundBox[1] = ROBOT_X_MAX + 240;
-    visionBoundBox[2] = ROBOT_Y_MIN - 100;
-    visionBoundBox[3] = ROBOT_Y_MAX + 260;
+    visionBoundBox[0] = RobotLimits::X_MIN - 340;
+    visionBoundBox[1] = RobotLimits::X_MAX + 240;
+    visionBoundBox[2] = RobotLimits::Y_MIN - 100;
+    visionBoundBox[3] = RobotLimits::Y_MAX + 260;
 }
 
 void Vision::processScene(const cv::Mat& image, bool calibrate, std::vector<cv::Point3i>* sourceCentroids, 
     std::vector<cv::Point3i>* structCentroids)
 {
-    // Reset vision system to uncalibrated state
-    if (calibrate)
-        calibrated = false;
+    // A new scene invalidates the cached output of every stage
+    sceneId++;
+    sceneImage = image;
+    sceneCalibrate = calibrate;
+    hasSceneSourceCentroids = sourceCentroids != Q_NULLPTR;
+    hasSceneStructCentroids = structCentroids != Q_NULLPTR;
+    sceneSourceCentroids = hasSceneSourceCentroids ? *sourceCentroids : std::vector<cv::Point3i>();
+    sceneStructCentroids = hasSceneStructCentroids ? *structCentroids : std::vector<cv::Point3i>();
+
+    runStages();
+}
+
+void Vision::reprocessScene()
+{
+    if (sceneImage.empty())
+        return;
+
+    runStages();
+}
+
+void Vision::setParameters(const VisionParameters& parameters)
+{
+    this->parameters = parameters;
+}
+
+VisionParameters Vision::getParameters() const
+{
+    return parameters;
+}
+
+void Vision::runStages()
+{
+    // Initialize stage timers
+    QElapsedTimer totalTimer;
+    QElapsedTimer stageTimer;
+    totalTimer.start();
+    stageTimer.start();
+    timings = VisionTimings();
+
+    // Reset cached results of the previous scene
+    cubePoses.clear();
+    layeredCubePosesValid = false;
 
     // Reset image contour containers
-    fiducialContours.clear();
     cubeContours.clear();
     sourceCubeContours.clear();
     structCubeContours.clear();
 
-    // Reset fiducial stage images
-    fiducialImages.clear();
-    annotatedFiducialImages.clear();
+    // Compute undistortion maps for the image size if the size or the intrinsic parameters have changed
+    if (undistortMap.empty() || undistortMapSize != sceneImage.size())
+        initUndistortMaps(sceneImage.size());
 
-    // Process image
-    cv::Mat processImage;
+    // Each stage is only run if the key of its input and parameters differs from the key of its cached output
 
     // Convert to grayscale and blur
-    cv::cvtColor(image, processImage, cv::COLOR_BGR2GRAY);
-    cv::blur(processImage, processImage, cv::Size(blurSize + 1, blurSize + 1));
-    processImage.copyTo(blurredImage);
+    quint64 stageKey = combineKey(sceneId, parameters.blurSize);
+    if (stageKey != blurKey)
+    {
+        cv::cvtColor(sceneImage, blurredImage, cv::COLOR_BGR2GRAY);
+        cv::blur(blurredImage, blurredImage, cv::Size(parameters.blurSize + 1, parameters.blurSize + 1));
+        blurKey = stageKey;
+        timings.blur = stageTimer.nsecsElapsed() / 1e6;
+    }
+    stageTimer.restart();
 
     // Apply binary threshold to image
-    cv::threshold(processImage, processImage, thresh, maxThresh, cv::THRESH_BINARY);
-    processImage.copyTo(thresholdImage);
+    stageKey = combineKey(combineKey(blurKey, parameters.threshold), parameters.adaptiveThreshold);
+    if (stageKey != thresholdKey)
+    {
+        if (parameters.adaptiveThreshold)
+            computeAdaptiveThreshold(blurredImage, thresholdImage);
+        else
+            cv::threshold(blurredImage, thresholdImage, parameters.threshold, 255, cv::THRESH_BINARY);
+        thresholdKey = stageKey;
+        timings.threshold = stageTimer.nsecsElapsed() / 1e6;
+    }
+    stageTimer.restart();
 
     // Apply contour detection
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(processImage, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-    // Plot contours for contour image
-    cv::cvtColor(processImage, contourImage, cv::COLOR_GRAY2BGR);
-    cv::drawContours(contourImage, contours, -1, cv::Scalar(0, 255, 0), 4);
-
-    // Process contours for cubes and fiducials
-    for (int i = 0; i < contours.size(); i++)
+    stageKey = thresholdKey;
+    if (stageKey != contourKey)
     {
-        // Get contour
-        std::vector<cv::Point> contour = contours[i];
-
-        // Get contour centroid and area
-        cv::Point2d centroid = getCentroid(contour);
-        double area = cv::contourArea(contours[i]);
-
-        // Process contours of significant size in bounding box 
-        if (area > areaThreshold)
+        // Retrieve the holes of each outer contour with a two level hierarchy
+        std::vector<std::vector<cv::Point>> allContours;
+        std::vector<cv::Vec4i> hierarchy;
+        cv::findContours(thresholdImage, allContours, hierarchy, cv::RETR_CCOMP, cv::CHAIN_APPROX_SIMPLE);
+
+        // Separate the outer contours and sum the area of the holes in each outer contour
+        contours.clear();
+        contourHoleAreas.clear();
+        for (int i = 0; i < allContours.size(); ++i)
         {
-            // Find corners
-            std::vector<cv::Point> corners = findSquareCorners(contour);
-
-            // Check if corners could be found and check for fiducial if found
-            bool fiducialFound = false;
-            if (corners.size() == 4)
-            {
+            if (hierarchy[i][3] >= 0)
+                continue;
 
-                // Isolate rectangle
-                cv::Mat isolatedImage(fiducialWidth, fiducialHeight, CV_8UC1);
-                cv::Mat annotatedFiducialImage(fiducialWidth, fiducialHeight, CV_8UC1);
-                cv::Mat homographyMatrix;
-                isolateRectangle(corners, processImage, isolatedImage, homographyMatrix);
-                cv::threshold(isolatedImage, isolatedImage, thresh, maxThresh, cv::THRESH_BINARY);
+            double holeArea = 0;
+            for (int hole = hierarchy[i][2]; hole >= 0; hole = hierarchy[hole][0])
+                holeArea += cv::contourArea(allContours[hole]);
 
-                // Process fiducial
-                int fiducialId = identifyFiducial(isolatedImage, isolatedImage, annotatedFiducialImage);
+            contours.push_back(allContours[i]);
+            contourHoleAreas.push_back(holeArea);
+        }
 
-                // Add to fiducial contour list if fiducial
-                if (fiducialId >= 0)
-                {
-                    fiducialFound = true;
-
-                    FiducialContour fiducial;
-                    fiducial.id = fiducialId;
-                    fiducial.centroid = centroid;
-                    fiducial.contour = contour;
-                    fiducial.corners = corners;
-                    fiducial.homographyMatrix = homographyMatrix;
-                    fiducialContours.push_back(fiducial);
-
-                    fiducialImages.push_back(isolatedImage);
-                    annotatedFiducialImages.push_back(annotatedFiducialImage);
-                }
-            }
+        // Plot contours for contour image
+        cv::cvtColor(thresholdImage, contourImage, cv::COLOR_GRAY2BGR);
+        cv::drawContours(contourImage, contours, -1, cv::Scalar(0, 255, 0), 4);
+        contourKey = stageKey;
+        timings.contours = stageTimer.nsecsElapsed() / 1e6;
+    }
+    stageTimer.restart();
 
-            // Assume contour is cube and add to cube contour list
-            if (!fiducialFound)
-            {
-                CubeContour cube;
-                cube.centroid = centroid;
-                cube.contour = contour;
-                cube.corners = corners;
-                cubeContours.push_back(cube);
-            }
-        }
+    // Process contours for cubes and fiducials
+    // Fiducial candidates are compared to the expected fiducial area once calibrated, so the calibration is part of the key
+    stageKey = combineKey(combineKey(contourKey, parameters.areaThreshold), parameters.cellThreshold);
+    stageKey = combineKey(stageKey, calibrationGeneration);
+    if (stageKey != fiducialKey)
+    {
+        processContours();
+        fiducialKey = stageKey;
+        timings.fiducials = stageTimer.nsecsElapsed() / 1e6;
     }
+    stageTimer.restart();
 
     // Use fiducials to calibrate for rotation and translation matrices
-    if (calibrate)
+    stageKey = fiducialKey;
+    if (sceneCalibrate && stageKey != calibrationKey)
     {
-        // Get world points and corresponding image points from fiducial set
-        std::vector<cv::Point3d> worldPoints;
-        std::vector<cv::Point2d> imagePoints;
-        for (int i = 0; i < fiducialContours.size(); ++i)
-        {
-            FiducialContour f = fiducialContours[i];
-
-            // Check if world point is defined for fiducial
-            if (fiducialWorldPoints.contains(f.id))
-            {
-                worldPoints.push_back(fiducialWorldPoints.value(f.id)); // Get known world point of fiducial
-                imagePoints.push_back(f.centroid); // Use centroid of fiducial contour as image point
-            }
-        }
-
-        // Compute pose of world frame with respect to the fixed camera frame
-        // At least four point correspondences are required to solve for the extrinsic parameters
-        if (worldPoints.size() >= 4)
-        {
-            // Solve for pose
-            cv::Mat rotationVector;
-            cv::solvePnP(worldPoints, imagePoints, cameraMatrix, distCoeffs, rotationVector, translationVector);
-
-            // Convert rotation vector to rotation matrix
-            cv::Rodrigues(rotationVector, rotationMatrix);
-
-            // Transition system to calibrated state
-            calibrated = true;
-        }
+        calibrateExtrinsics();
+        calibrationKey = stageKey;
+        timings.calibration = stageTimer.nsecsElapsed() / 1e6;
     }
+    stageTimer.restart();
 
     // The following image processing requires a calibrated system
     if (!calibrated)
+    {
+        timings.total = totalTimer.nsecsElapsed() / 1e6;
         return;
+    }
+
+    // Cube classification is always run since it is cheap and depends on the calibration and the known cube positions
+    // Contours overlapping the robot are discarded since they may belong to the robot rather than to a cube
+    for (const CubeContour& candidate : candidateCubeContours)
+    {
+        std::vector<cv::Point> hull;
+        cv::convexHull(candidate.contour, hull);
+        bool occluded = false;
+        for (const std::vector<cv::Point>& region : occludedRegions)
+        {
+            std::vector<cv::Point> intersection;
+            occluded = occluded || cv::intersectConvexConvex(hull, region, intersection) > 0;
+        }
+
+        if (!occluded)
+            cubeContours.push_back(candidate);
+    }
+    std::vector<cv::Point3i>* sourceCentroids = hasSceneSourceCentroids ? &sceneSourceCentroids : Q_NULLPTR;
+    std::vector<cv::Point3i>* structCentroids = hasSceneStructCentroids ? &sceneStructCentroids : Q_NULLPTR;
 
     // Remove centroids that do not fall within the computer vision region of interest
     // The computer vision region of interest bounding box is defined on the base plane so all centroids are projected to
@@ -267,7 +280,174 @@ void Vision::processScene(const cv::Mat& image, bool calibrate, std::vector<cv::
                 ++iter;
         }
     }
-    
+
+    timings.classification = stageTimer.nsecsElapsed() / 1e6;
+    timings.total = totalTimer.nsecsElapsed() / 1e6;
+}
+
+void Vision::processContours()
+{
+    // Reset fiducial stage outputs
+    fiducialContours.clear();
+    candidateCubeContours.clear();
+    fiducialImages.clear();
+    annotatedFiducialImages.clear();
+
+    // Process contours of significant size
+    std::vector<int> candidates;
+    for (int i = 0; i < contours.size(); i++)
+    {
+        if (cv::contourArea(contours[i]) > parameters.areaThreshold)
+            candidates.push_back(i);
+    }
+
+    // Isolate and identify the candidates in parallel since each candidate is processed independently
+    std::vector<FiducialContour> candidateFiducials(candidates.size());
+    std::vector<CubeContour> candidateCubes(candidates.size());
+    std::vector<cv::Mat> isolatedImages(candidates.size());
+    std::vector<cv::Mat> annotatedImages(candidates.size());
+    cv::parallel_for_(cv::Range(0, candidates.size()), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i)
+        {
+            // Get contour, centroid and corners
+            const std::vector<cv::Point>& contour = contours[candidates[i]];
+            cv::Point centroid = getCentroid(contour);
+            double area = cv::contourArea(contour);
+            std::vector<cv::Point> corners = findSquareCorners(contour);
+
+            // Check if corners could be found and check for fiducial if found
+            // Contours that cannot be fiducials, such as cube top faces, are rejected before the costly isolation and decoding
+            candidateFiducials[i].id = -1;
+            if (corners.size() == 4 && isFiducialCandidate(contour, corners, contourHoleAreas[candidates[i]]))
+            {
+                // Isolate rectangle
+                cv::Mat isolatedImage(FIDUCIAL_IMAGE_SIZE, FIDUCIAL_IMAGE_SIZE, CV_8UC1);
+                cv::Mat homographyMatrix;
+                isolateRectangle(corners, thresholdImage, isolatedImage, homographyMatrix);
+                cv::threshold(isolatedImage, isolatedImage, parameters.threshold, 255, cv::THRESH_BINARY);
+
+                // Process fiducial
+                double fiducialConfidence;
+                int fiducialId = identifyFiducial(isolatedImage, isolatedImages[i], annotatedImages[i], fiducialConfidence);
+
+                FiducialContour& fiducial = candidateFiducials[i];
+                fiducial.id = fiducialId;
+                fiducial.centroid = centroid;
+                fiducial.contour = contour;
+                fiducial.corners = corners;
+                fiducial.homographyMatrix = homographyMatrix;
+                fiducial.confidence = fiducialConfidence;
+            }
+
+            // Assume contour is cube if it is not a fiducial
+            if (candidateFiducials[i].id < 0)
+            {
+                CubeContour& cube = candidateCubes[i];
+                cube.centroid = centroid;
+                cube.contour = contour;
+                cube.corners = corners;
+
+                // Score how well the contour is described by its corners
+                cube.shapeScore = 0;
+                if (corners.size() == 4)
+                {
+                    double cornerArea = cv::contourArea(corners);
+                    if (cornerArea > 0)
+                        cube.shapeScore = std::min(area, cornerArea) / std::max(area, cornerArea);
+                }
+            }
+        }
+    });
+
+    // Collect the results in contour order so that they do not depend on the scheduling of the workers
+    for (int i = 0; i < candidates.size(); ++i)
+    {
+        if (candidateFiducials[i].id >= 0)
+        {
+            fiducialContours.push_back(candidateFiducials[i]);
+            fiducialImages.push_back(isolatedImages[i]);
+            annotatedFiducialImages.push_back(annotatedImages[i]);
+        }
+        else
+        {
+            candidateCubeContours.push_back(candidateCubes[i]);
+        }
+    }
+}
+
+void Vision::calibrateExtrinsics()
+{
+    bool wasCalibrated = calibrated;
+    cv::Mat previousRotation = rotationVector.clone();
+    cv::Mat previousTranslation = translationVector.clone();
+
+    // Reset vision system to uncalibrated state
+    calibrated = false;
+    calibrationFiducials = 0;
+    reprojectionError = std::numeric_limits<double>::infinity();
+    layerHomographies.clear();
+
+    // Get world points and corresponding image points from fiducial set
+    std::vector<cv::Point3d> worldPoints;
+    std::vector<cv::Point2d> imagePoints;
+    for (int i = 0; i < fiducialContours.size(); ++i)
+    {
+        FiducialContour f = fiducialContours[i];
+
+        // Check if world point is defined for fiducial
+        if (fiducialWorldPoints.contains(f.id))
+        {
+            worldPoints.push_back(fiducialWorldPoints.value(f.id)); // Get known world point of fiducial
+            imagePoints.push_back(f.centroid); // Use centroid of fiducial contour as image point
+        }
+    }
+
+    // Compute pose of world frame with respect to the fixed camera frame
+    // At least four point correspondences are required to solve for the extrinsic parameters
+    if (worldPoints.size() < 4)
+    {
+        if (wasCalibrated)
+            calibrationGeneration++;
+        return;
+    }
+
+    // Solve for pose
+    cv::solvePnP(worldPoints, imagePoints, cameraMatrix, distCoeffs, rotationVector, translationVector);
+
+    // Convert rotation vector to rotation matrix
+    cv::Rodrigues(rotationVector, rotationMatrix);
+
+    // Measure how well the pose explains the fiducial centroids
+    std::vector<cv::Point2d> projectedPoints;
+    cv::projectPoints(worldPoints, rotationVector, translationVector, cameraMatrix, distCoeffs, projectedPoints);
+    double squaredError = 0;
+    for (int i = 0; i < imagePoints.size(); ++i)
+    {
+        cv::Point2d error = projectedPoints[i] - imagePoints[i];
+        squaredError += error.dot(error);
+    }
+    reprojectionError = std::sqrt(squaredError / imagePoints.size());
+    calibrationFiducials = worldPoints.size();
+
+    // Transition system to calibrated state
+    // The generation only changes with the pose so that processing the same scene again reaches the cached stages
+    calibrated = true;
+    if (!wasCalibrated || cv::norm(rotationVector, previousRotation) > 0 || cv::norm(translationVector, previousTranslation) > 0)
+        calibrationGeneration++;
+}
+
+quint64 Vision::combineKey(quint64 key, double value)
+{
+    // Mix the bit pattern of the value into the key with the 64-bit FNV-1a hash
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; ++i)
+    {
+        key ^= (bits >> (8 * i)) & 0xff;
+        key *= 1099511628211ULL;
+    }
+
+    return key;
 }
 
 void Vision::plotFiducialInfo(cv::Mat& image)
@@ -302,7 +482,12 @@ void Vision::plotFiducialInfo(cv::Mat& image)
 
 void Vision::plotCubeInfo(cv::Mat& image)
 {
+    // Cube poses are only available if the system is calibrated
+    if (!calibrated)
+        return;
+
     // Plot independent cube information
+    std::vector<CubePose> poses = getLayeredCubePoses();
     for (int i = 0; i < cubeContours.size(); ++i)
     {
         // Get contour
@@ -313,20 +498,20 @@ void Vision::plotCubeInfo(cv::Mat& image)
         //cv::drawContours(image, contours, 0, cv::Scalar(0, 255, 0), 4);
 
         // Plot world coordinate text
-        cv::Point3i worldPoint = projectImagePoint(c.centroid, -64); // Project image point to world 
+        cv::Point3i worldPoint(round(poses[i].position.x), round(poses[i].position.y), -round(poses[i].position.z));
         QString coordinateText = "(" + QString::number(worldPoint.x) + ", " + QString::number(worldPoint.y) + ")";
         cv::Point coordinateTextPoint(c.centroid.x - 60, c.centroid.y + 40);
         cv::putText(image, coordinateText.toStdString(), coordinateTextPoint, cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(255, 255, 255), 2);
 
         // Plot orientation text
-        float angle = computeCubeZRotation(c.corners, c.centroid, -64);
+        float angle = poses[i].rotation;
         QString angleText = QString::number(round(angle / M_PI * 180 *100) / 100) + " deg";
         cv::Point angleTextPoint(c.centroid.x - 50, c.centroid.y + 70);
         cv::putText(image, angleText.toStdString(), angleTextPoint, cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(255, 255, 255), 2);
 
         // Plot orientation reference line
         int lineLength = 64;
-        cv::Point3i worldCentroid = projectImagePoint(c.centroid, -64);
+        cv::Point3i worldCentroid = worldPoint;
         cv::Point3i xRefPoint = worldCentroid + cv::Point3i(lineLength, 0, 0);
         cv::Point3i angleRefPoint = worldCentroid + cv::Point3i(lineLength * cos(angle), lineLength * sin(angle), 0);
         cv::line(image, projectWorldPoint(worldCentroid), projectWorldPoint(xRefPoint), cv::Scalar(0, 255, 0), 3, cv::LINE_8);
@@ -381,15 +566,15 @@ void Vision::plotWorkspaceBoundBox(cv::Mat& image)
     cv::Point imageCoordinatesL[4]; // Lower bounding box
     cv::Point imageCoordinatesH[4]; // Upper bounding box
 
-    imageCoordinatesL[0] = projectWorldPoint(cv::Point3i(ROBOT_X_MIN, ROBOT_Y_MIN, 0));
-    imageCoordinatesL[1] = projectWorldPoint(cv::Point3i(ROBOT_X_MIN, ROBOT_Y_MAX, 0));
-    imageCoordinatesL[2] = projectWorldPoint(cv::Point3i(ROBOT_X_MAX, ROBOT_Y_MAX, 0));
-    imageCoordinatesL[3] = projectWorldPoint(cv::Point3i(ROBOT_X_MAX, ROBOT_Y_MIN, 0));
+    imageCoordinatesL[0] = projectWorldPoint(cv::Point3i(RobotLimits::X_MIN, RobotLimits::Y_MIN, 0));
+    imageCoordinatesL[1] = projectWorldPoint(cv::Point3i(RobotLimits::X_MIN, RobotLimits::Y_MAX, 0));
+    imageCoordinatesL[2] = projectWorldPoint(cv::Point3i(RobotLimits::X_MAX, RobotLimits::Y_MAX, 0));
+    imageCoordinatesL[3] = projectWorldPoint(cv::Point3i(RobotLimits::X_MAX, RobotLimits::Y_MIN, 0));
 
-    imageCoordinatesH[0] = projectWorldPoint(cv::Point3i(ROBOT_X_MIN, ROBOT_Y_MIN, 6 * -64));
-    imageCoordinatesH[1] = projectWorldPoint(cv::Point3i(ROBOT_X_MIN, ROBOT_Y_MAX, 6 * -64));
-    imageCoordinatesH[2] = projectWorldPoint(cv::Point3i(ROBOT_X_MAX, ROBOT_Y_MAX, 6 * -64));
-    imageCoordinatesH[3] = projectWorldPoint(cv::Point3i(ROBOT_X_MAX, ROBOT_Y_MIN, 6 * -64));
+    imageCoordinatesH[0] = projectWorldPoint(cv::Point3i(RobotLimits::X_MIN, RobotLimits::Y_MIN, MAX_LAYERS * -CUBE_LENGTH));
+    imageCoordinatesH[1] = projectWorldPoint(cv::Point3i(RobotLimits::X_MIN, RobotLimits::Y_MAX, MAX_LAYERS * -CUBE_LENGTH));
+    imageCoordinatesH[2] = projectWorldPoint(cv::Point3i(RobotLimits::X_MAX, RobotLimits::Y_MAX, MAX_LAYERS * -CUBE_LENGTH));
+    imageCoordinatesH[3] = projectWorldPoint(cv::Point3i(RobotLimits::X_MAX, RobotLimits::Y_MIN, MAX_LAYERS * -CUBE_LENGTH));
 
     // Plot bounding box
     for (int i = 0; i < 4; ++i)
@@ -415,6 +600,164 @@ void Vision::plotVisionBoundBox(cv::Mat& image)
         cv::line(image, imageCoordinatesL[i], imageCoordinatesL[(i + 1) % 4], cv::Scalar(255, 0, 128), 3, cv::LINE_8);
 }
 
+void Vision::computeAdaptiveThreshold(const cv::Mat& image, cv::Mat& thresholdedImage) const
+{
+    // Histograms of the tiles in one row of tiles with four interleaved histograms per tile
+    // Consecutive pixels increment different histograms so that repeated increments of the same bin do not stall
+    std::vector<int> histograms(THRESHOLD_TILES * 4 * 256);
+    std::vector<int> tileThresholds(THRESHOLD_TILES * THRESHOLD_TILES);
+    std::vector<int> tileContrasts(THRESHOLD_TILES * THRESHOLD_TILES);
+    int imageHistogram[256] = {};
+
+    for (int tileRow = 0; tileRow < THRESHOLD_TILES; ++tileRow)
+    {
+        // Compute the histograms of the row of tiles in a single pass over its image rows
+        std::fill(histograms.begin(), histograms.end(), 0);
+        int rowEnd = (tileRow + 1) * image.rows / THRESHOLD_TILES;
+        for (int row = tileRow * image.rows / THRESHOLD_TILES; row < rowEnd; ++row)
+        {
+            const uchar* pixels = image.ptr<uchar>(row);
+            for (int tileCol = 0; tileCol < THRESHOLD_TILES; ++tileCol)
+            {
+                int* histogram = &histograms[tileCol * 4 * 256];
+                int col = tileCol * image.cols / THRESHOLD_TILES;
+                int colEnd = (tileCol + 1) * image.cols / THRESHOLD_TILES;
+                for (; col + 4 <= colEnd; col += 4)
+                {
+                    histogram[pixels[col]]++;
+                    histogram[256 + pixels[col + 1]]++;
+                    histogram[512 + pixels[col + 2]]++;
+                    histogram[768 + pixels[col + 3]]++;
+                }
+
+                for (; col < colEnd; ++col)
+                    histogram[pixels[col]]++;
+            }
+        }
+
+        // Merge the interleaved histograms and compute the threshold of each tile
+        for (int tileCol = 0; tileCol < THRESHOLD_TILES; ++tileCol)
+        {
+            const int* histogram = &histograms[tileCol * 4 * 256];
+            int tileHistogram[256];
+            for (int i = 0; i < 256; ++i)
+            {
+                tileHistogram[i] = histogram[i] + histogram[256 + i] + histogram[512 + i] + histogram[768 + i];
+                imageHistogram[i] += tileHistogram[i];
+            }
+
+            int tile = tileRow * THRESHOLD_TILES + tileCol;
+            tileThresholds[tile] = computeOtsuThreshold(tileHistogram, tileContrasts[tile]);
+        }
+    }
+
+    // Tiles without both cubes or fiducials and background, such as tiles of bare workspace, use the image threshold
+    int imageContrast;
+    int imageThreshold = computeOtsuThreshold(imageHistogram, imageContrast);
+    cv::Mat thresholdGrid(THRESHOLD_TILES, THRESHOLD_TILES, CV_8UC1);
+    for (int tile = 0; tile < THRESHOLD_TILES * THRESHOLD_TILES; ++tile)
+    {
+        int threshold = tileContrasts[tile] >= MIN_TILE_CONTRAST ? tileThresholds[tile] : imageThreshold;
+        thresholdGrid.at<uchar>(tile / THRESHOLD_TILES, tile % THRESHOLD_TILES) = threshold;
+    }
+
+    // Bilinear interpolation of the grid maps each tile threshold to the tile centre and blends between tile centres
+    cv::Mat thresholdMap;
+    cv::resize(thresholdGrid, thresholdMap, image.size(), 0, 0, cv::INTER_LINEAR);
+    cv::compare(image, thresholdMap, thresholdedImage, cv::CMP_GT);
+}
+
+int Vision::computeOtsuThreshold(const int histogram[256], int& contrast)
+{
+    // Compute the total pixel count and intensity sum
+    double count = 0;
+    double sum = 0;
+    for (int i = 0; i < 256; ++i)
+    {
+        count += histogram[i];
+        sum += (double) i * histogram[i];
+    }
+
+    // Select the threshold that maximizes the between-class variance of the pixels on either side of it
+    int threshold = 0;
+    int lastThreshold = 0;
+    double maxVariance = -1;
+    double lowerCount = 0;
+    double lowerSum = 0;
+    contrast = 0;
+    for (int i = 0; i < 255; ++i)
+    {
+        lowerCount += histogram[i];
+        lowerSum += (double) i * histogram[i];
+        double upperCount = count - lowerCount;
+        if (lowerCount == 0 || upperCount == 0)
+            continue;
+
+        double lowerMean = lowerSum / lowerCount;
+        double upperMean = (sum - lowerSum) / upperCount;
+        double variance = lowerCount * upperCount * pow(upperMean - lowerMean, 2);
+        if (variance > maxVariance)
+        {
+            maxVariance = variance;
+            threshold = i;
+            lastThreshold = i;
+            contrast = round(upperMean - lowerMean);
+        }
+        else if (variance == maxVariance)
+        {
+            // Empty bins between the classes give the same variance
+            lastThreshold = i;
+        }
+    }
+
+    // Place the threshold in the middle of any gap between the classes
+    return (threshold + lastThreshold) / 2;
+}
+
+bool Vision::isFiducialCandidate(const std::vector<cv::Point>& contour, const std::vector<cv::Point>& corners, double holeArea) const
+{
+    // The dark fiducial cells are holes in the light fiducial square while cube top faces are solid
+    double area = cv::contourArea(contour);
+    if (area <= 0 || holeArea / area < MIN_FIDUCIAL_HOLE_FRACTION)
+        return false;
+
+    // The outline of a fiducial is a convex quadrilateral
+    if (!cv::isContourConvex(corners))
+        return false;
+
+    std::vector<cv::Point> hull;
+    cv::convexHull(contour, hull);
+    if (area / cv::contourArea(hull) < MIN_FIDUCIAL_SOLIDITY)
+        return false;
+
+    // Opposite sides of the quadrilateral have similar lengths under the perspective of the camera
+    for (int i = 0; i < 2; ++i)
+    {
+        double sideA = cv::norm(corners[i + 1] - corners[i]);
+        double sideB = cv::norm(corners[(i + 3) % 4] - corners[i + 2]);
+        if (sideA <= 0 || sideB <= 0 || sideA / sideB > MAX_FIDUCIAL_SIDE_RATIO || sideB / sideA > MAX_FIDUCIAL_SIDE_RATIO)
+            return false;
+    }
+
+    // Compare the area to that of a fiducial at the same location on the base plane once the camera pose is known
+    if (calibrated)
+    {
+        cv::Point3i worldCentroid = projectImagePoint(getCentroid(contour), 0);
+        double halfLength = FIDUCIAL_LENGTH / 2.0;
+        std::vector<cv::Point> expectedCorners;
+        expectedCorners.push_back(projectWorldPoint(cv::Point3d(worldCentroid.x - halfLength, worldCentroid.y - halfLength, 0)));
+        expectedCorners.push_back(projectWorldPoint(cv::Point3d(worldCentroid.x + halfLength, worldCentroid.y - halfLength, 0)));
+        expectedCorners.push_back(projectWorldPoint(cv::Point3d(worldCentroid.x + halfLength, worldCentroid.y + halfLength, 0)));
+        expectedCorners.push_back(projectWorldPoint(cv::Point3d(worldCentroid.x - halfLength, worldCentroid.y + halfLength, 0)));
+
+        double expectedArea = cv::contourArea(expectedCorners);
+        if (expectedArea > 0 && (area < expectedArea * MIN_FIDUCIAL_AREA_RATIO || area > expectedArea * MAX_FIDUCIAL_AREA_RATIO))
+            return false;
+    }
+
+    return true;
+}
+
 cv::Point Vision::getCentroid(const std::vector<cv::Point>& contour) const
 {
     cv::Moments contourMoments = moments(contour, false);
@@ -486,14 +829,19 @@ std::vector<cv::Point> Vision::findSquareCorners(const std::vector<cv::Point>& c
 void Vision::isolateRectangle(const std::vector<cv::Point>& corners, const cv::Mat& sourceImage, cv::Mat& isolatedImage, cv::Mat& homographyMatrix) const
 {
     // Define destination points in isolation image
-    std::vector<cv::Point> isolatedImagePoints;
-    isolatedImagePoints.push_back(cv::Point(0, 0));
-    isolatedImagePoints.push_back(cv::Point(isolatedImage.cols - 1, 0));
-    isolatedImagePoints.push_back(cv::Point(isolatedImage.cols - 1, isolatedImage.rows - 1));
-    isolatedImagePoints.push_back(cv::Point(0, isolatedImage.rows - 1));
+    std::vector<cv::Point2f> isolatedImagePoints;
+    isolatedImagePoints.push_back(cv::Point2f(0, 0));
+    isolatedImagePoints.push_back(cv::Point2f(isolatedImage.cols - 1, 0));
+    isolatedImagePoints.push_back(cv::Point2f(isolatedImage.cols - 1, isolatedImage.rows - 1));
+    isolatedImagePoints.push_back(cv::Point2f(0, isolatedImage.rows - 1));
+
+    // Remove lens distortion from the corners so that the rectangle is isolated from the undistorted image
+    std::vector<cv::Point2f> undistortedCorners;
+    cv::undistortPoints(std::vector<cv::Point2f>(corners.begin(), corners.end()), undistortedCorners, cameraMatrix, distCoeffs,
+        cv::noArray(), cameraMatrix);
 
     // Compute homography matrix and isolate and warp rectangle to isolation image
-    homographyMatrix = cv::findHomography(corners, isolatedImagePoints);
+    homographyMatrix = cv::findHomography(undistortedCorners, isolatedImagePoints);
 
     if (homographyMatrix.dims == 0)
     {
@@ -501,14 +849,44 @@ void Vision::isolateRectangle(const std::vector<cv::Point>& corners, const cv::M
         return;
     }
 
+    // Only the region of the undistorted image containing the rectangle is remapped
+    cv::Rect region = cv::boundingRect(undistortedCorners) & cv::Rect(cv::Point(0, 0), undistortMapSize);
+    if (region.empty())
+    {
+        warpPerspective(sourceImage, isolatedImage, homographyMatrix, isolatedImage.size());
+        return;
+    }
 
-    warpPerspective(sourceImage, isolatedImage, homographyMatrix, isolatedImage.size());
+    cv::Mat undistortedRegion;
+    undistortRegion(sourceImage, region, undistortedRegion);
+
+    // Offset the homography to map from the region to the isolation image
+    cv::Mat regionOffset = (cv::Mat_<double>(3, 3) << 1, 0, region.x, 0, 1, region.y, 0, 0, 1);
+    warpPerspective(undistortedRegion, isolatedImage, homographyMatrix * regionOffset, isolatedImage.size());
 }
 
-int Vision::identifyFiducial(const cv::Mat& inputImage, cv::Mat& outputImage, cv::Mat& annotatedFiducial) const
+void Vision::initUndistortMaps(const cv::Size& imageSize)
 {
+    // Fixed point maps are used since they are faster to remap with than floating point maps
+    cv::initUndistortRectifyMap(cameraMatrix, distCoeffs, cv::Mat(), cameraMatrix, imageSize, CV_16SC2, undistortMap,
+        undistortInterpolationMap);
+    undistortMapSize = imageSize;
+}
+
+void Vision::undistortRegion(const cv::Mat& image, const cv::Rect& region, cv::Mat& undistortedRegion) const
+{
+    // The maps contain the distorted image coordinates of each undistorted pixel so a region of the maps produces the
+    // corresponding region of the undistorted image
+    cv::Rect mapRegion = region & cv::Rect(cv::Point(0, 0), undistortMapSize);
+    cv::remap(image, undistortedRegion, undistortMap(mapRegion), undistortInterpolationMap(mapRegion), cv::INTER_LINEAR);
+}
+
+int Vision::identifyFiducial(const cv::Mat& inputImage, cv::Mat& outputImage, cv::Mat& annotatedFiducial, double& confidence) const
+{
+    confidence = 0;
+
     // Check if image conforms to isolated fiducial specification
-    if (inputImage.rows != fiducialWidth || inputImage.cols != fiducialHeight)
+    if (inputImage.rows != FIDUCIAL_IMAGE_SIZE || inputImage.cols != FIDUCIAL_IMAGE_SIZE)
     {
         emit log(Message(MessageType::ERROR_LOG, "Vision System", "Image does not conform to isolated fiducial specification"));
         return -1;
@@ -527,48 +905,23 @@ int Vision::identifyFiducial(const cv::Mat& inputImage, cv::Mat& outputImage, cv
     //cv::imshow("Fiducial", outputImage);
     //cv::waitKey();
 
-    // Rotate image until correct orientation is found by alignment with 3 orientation reference blocks
-    int rotationCount = 0;
-    int refBlock1 = classifyFiducialSquare(outputImage, 0, 0);
-    int refBlock2 = classifyFiducialSquare(outputImage, 2, 0);
-    int refBlock3 = classifyFiducialSquare(outputImage, 2, 2);
-    while (refBlock1 != 0 || refBlock2 != 0 || refBlock3 != 1)
-    {
-        // Check if all orientations have been tested
-        rotationCount++;
-        if (rotationCount == 4)
-            return -1;
-
-        // Rotate to new orientation
-        cv::rotate(outputImage, outputImage, cv::ROTATE_90_CLOCKWISE);
-
-        // Sample orientation reference blocks
-        refBlock1 = classifyFiducialSquare(outputImage, 0, 0);
-        refBlock2 = classifyFiducialSquare(outputImage, 2, 0);
-        refBlock3 = classifyFiducialSquare(outputImage, 2, 2);
-    }
+    // Classify every cell of the fiducial grid
+    int cells[FiducialDictionary::CELL_COUNT];
+    for (int i = 0; i < FiducialDictionary::CELL_COUNT; ++i)
+        cells[i] = classifyFiducialSquare(outputImage, i / 3, i % 3);
 
-    // Get fiducial identifier by mapping fiducial blocks to binary bits
-    int bits[6];
-    bits[0] = classifyFiducialSquare(outputImage, 0, 1);
-    bits[1] = classifyFiducialSquare(outputImage, 0, 2);
-    bits[2] = classifyFiducialSquare(outputImage, 1, 0);
-    bits[3] = classifyFiducialSquare(outputImage, 1, 1);
-    bits[4] = classifyFiducialSquare(outputImage, 1, 2);
-    bits[5] = classifyFiducialSquare(outputImage, 2, 1);
-
-    int identifier = 0;
-    for (int i = 0; i < 6; ++i)
-    {
-        // Check if bit was successfully classified
-        if (bits[i] == -1)
-            return -1;
+    // Decode the identifier and orientation from all cells with correction of misclassified and unclassified cells
+    FiducialDecoding decoding = FiducialDictionary::decode(cells);
+    confidence = decoding.confidence;
+    if (decoding.id < 0)
+        return -1;
 
-        // Add bit to identifier
-        identifier |= bits[i] << i;
-    }
+    // Rotate image to the reference orientation of the fiducial
+    for (int i = decoding.rotation; i % 4 != 0; ++i)
+        cv::rotate(outputImage, outputImage, cv::ROTATE_90_CLOCKWISE);
 
-    // Annotate fiducial image with grid and binary values
+    // Annotate fiducial image with grid and the decoded cell values
+    // Cells that were corrected or could not be classified are shown in red
     outputImage.copyTo(annotatedFiducial);
     cv::cvtColor(annotatedFiducial, annotatedFiducial, cv::COLOR_GRAY2RGB);
     int gridLinePos[4] = { 16, 48, 79, 111 };
@@ -580,24 +933,26 @@ int Vision::identifyFiducial(const cv::Mat& inputImage, cv::Mat& outputImage, cv
 
     int xOffset = 10;
     int yOffset = 25;
-    cv::putText(annotatedFiducial, "X", cv::Point(gridLinePos[0] + xOffset, gridLinePos[0] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
-    cv::putText(annotatedFiducial, std::to_string(bits[2]), cv::Point(gridLinePos[0] + xOffset, gridLinePos[1] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-    cv::putText(annotatedFiducial, "X", cv::Point(gridLinePos[0] + xOffset, gridLinePos[2] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
-    cv::putText(annotatedFiducial, std::to_string(bits[0]), cv::Point(gridLinePos[1] + xOffset, gridLinePos[0] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-    cv::putText(annotatedFiducial, std::to_string(bits[3]), cv::Point(gridLinePos[1] + xOffset, gridLinePos[1] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-    cv::putText(annotatedFiducial, std::to_string(bits[5]), cv::Point(gridLinePos[1] + xOffset, gridLinePos[2] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-    cv::putText(annotatedFiducial, std::to_string(bits[1]), cv::Point(gridLinePos[2] + xOffset, gridLinePos[0] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-    cv::putText(annotatedFiducial, std::to_string(bits[4]), cv::Point(gridLinePos[2] + xOffset, gridLinePos[1] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
-    cv::putText(annotatedFiducial, "X", cv::Point(gridLinePos[2] + xOffset, gridLinePos[2] + yOffset), cv::FONT_HERSHEY_DUPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
+    int codeword = FiducialDictionary::getCodeword(decoding.id);
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 3; ++col)
+        {
+            int value = (codeword >> (row * 3 + col)) & 1;
+            cv::Scalar colour = classifyFiducialSquare(outputImage, row, col) == value ? cv::Scalar(0, 255, 0) : cv::Scalar(255, 0, 0);
+            cv::Point textPoint(gridLinePos[col] + xOffset, gridLinePos[row] + yOffset);
+            cv::putText(annotatedFiducial, std::to_string(value), textPoint, cv::FONT_HERSHEY_DUPLEX, 0.7, colour, 2);
+        }
+    }
 
-    return identifier;
+    return decoding.id;
 }
 
 int Vision::classifyFiducialSquare(const cv::Mat& fiducialImage, int row, int col) const
 {
     int squareLength = 32; // Side length of gird square in pixels
     int startPixel = 16; // Location of first pixel in first square
-    float threshold = 0.7; // Minimum proportion of square of one type required for classification (0.5, 1]
+    double threshold = parameters.cellThreshold; // Minimum proportion of square of one type required for classification (0.5, 1]
     int padding = 3; // Number of pixels of padding that are not included in square sum
 
 
@@ -646,40 +1001,83 @@ float Vision::mapToCubeAngle(float angle) const
     return angle;
 }
 
-float Vision::computeCubeZRotation(const std::vector<cv::Point>& corners, const cv::Point centroid, const int z) const
+cv::Mat Vision::getLayerHomography(const int z) const
 {
-    // Project centroid point to the world frame
-    cv::Point3i worldCentroid = projectImagePoint(centroid, z);
+    // Use the cached homography if available
+    if (layerHomographies.contains(z))
+        return layerHomographies.value(z);
+
+    // The plane at height z maps to the undistorted image frame with the homography K [r1 r2 (t - z * r3)]
+    // The homography is inverted to map from the image frame to the plane
+    cv::Mat planeMatrix(3, 3, CV_64F);
+    rotationMatrix.col(0).copyTo(planeMatrix.col(0));
+    rotationMatrix.col(1).copyTo(planeMatrix.col(1));
+    cv::Mat planeOffset = translationVector - rotationMatrix.col(2) * z;
+    planeOffset.copyTo(planeMatrix.col(2));
+
+    cv::Mat homography = (cameraMatrix * planeMatrix).inv();
+    layerHomographies.insert(z, homography);
+
+    return homography;
+}
 
-    // Compute cube z rotation estimate using each corner point in the world frame
-    cv::Point3i worldCorners[4];
-    float angles[4];
-    for (int i = 0; i < 4; ++i)
+CubePose Vision::estimateCubePose(const CubeContour& cube, const int z) const
+{
+    CubePose pose;
+    pose.rotation = 0;
+    pose.residual = std::numeric_limits<double>::infinity();
+
+    // Use the contour centroid if the corners of the top face could not be found
+    if (cube.corners.size() != 4)
     {
-        // Project the corners from the image frame to the given xy plane in the world frame
-        worldCorners[i] = projectImagePoint(corners[i], z);
+        cv::Point3i worldCentroid = projectImagePoint(cube.centroid, -z);
+        pose.position = cv::Point3d(worldCentroid.x, worldCentroid.y, z);
+        return pose;
+    }
+
+    // Remove lens distortion from the corners and map them to the plane of the top face
+    std::vector<cv::Point2d> undistortedCorners;
+    std::vector<cv::Point2d> worldCorners;
+    cv::undistortPoints(std::vector<cv::Point2d>(cube.corners.begin(), cube.corners.end()), undistortedCorners, cameraMatrix,
+        distCoeffs, cv::noArray(), cameraMatrix);
+    cv::perspectiveTransform(undistortedCorners, worldCorners, getLayerHomography(z));
 
-        // Compute angle formed by the line from the top cube face centroid to each corner with the x-axis in radians
-        // Rotate 90 degrees clockwise to align with the line formed by the first corner and centroid and map to range(- PI, PI]
-        // This assumes the corners are specified in an anti-clockwise direction
-        angles[i] = atan2(worldCorners[i].y - worldCentroid.y, worldCorners[i].x - worldCentroid.x) - (M_PI * i / 2);
+    // The least squares estimate of the top face centre is the mean of the corners
+    cv::Point2d centre(0, 0);
+    for (int i = 0; i < 4; ++i)
+        centre += worldCorners[i] * 0.25;
 
-        // Covert angle to that between the x-axis and the line from the centroid perpendicular to the side of the cube and map to (- PI, PI]
-        angles[i] = mapAngle(angles[i] + M_PI / 4);
+    // Each corner gives an estimate of the angle between the x-axis and the line from the centre perpendicular to a side
+    // The estimates are averaged at four times the angle where they agree regardless of which side each corner refers to
+    double xSum = 0;
+    double ySum = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        double sideAngle = atan2(worldCorners[i].y - centre.y, worldCorners[i].x - centre.x) - M_PI / 4;
+        xSum += cos(4 * sideAngle);
+        ySum += sin(4 * sideAngle);
     }
 
-    // Compute average of angle estimates using the individual corners, map to (- PI / 4, PI / 4] and return single angle estimate
-    float ySum = 0;
-    float xSum = 0;
+    double angle = atan2(ySum, xSum) / 4;
+
+    // Compute the residual from the distance between each corner and the nearest corner of the fitted top face
+    double halfDiagonal = CUBE_LENGTH / sqrt(2.0);
+    double squaredError = 0;
     for (int i = 0; i < 4; ++i)
     {
-        xSum += cos(angles[i]);
-        ySum += sin(angles[i]);
+        double cornerAngle = atan2(worldCorners[i].y - centre.y, worldCorners[i].x - centre.x);
+        double quarterTurns = round((cornerAngle - angle - M_PI / 4) / (M_PI / 2));
+        double fittedAngle = angle + M_PI / 4 + quarterTurns * M_PI / 2;
+        cv::Point2d fittedCorner = centre + halfDiagonal * cv::Point2d(cos(fittedAngle), sin(fittedAngle));
+        cv::Point2d error = worldCorners[i] - fittedCorner;
+        squaredError += error.dot(error);
     }
 
-    float angle = mapToCubeAngle(atan2(ySum / 4, xSum / 4));
+    pose.position = cv::Point3d(centre.x, centre.y, z);
+    pose.rotation = -mapToCubeAngle(angle);
+    pose.residual = sqrt(squaredError / 4);
 
-    return -angle;
+    return pose;
 }
 
 cv::Point3i Vision::projectImagePoint(const cv::Point2d& imagePoint, double z) const
@@ -688,8 +1086,12 @@ cv::Point3i Vision::projectImagePoint(const cv::Point2d& imagePoint, double z) c
     if (!calibrated)
         return cv::Point3i(0, 0, 0);
 
+	// Remove lens distortion from the image point
+	std::vector<cv::Point2d> undistortedPoints;
+	cv::undistortPoints(std::vector<cv::Point2d>{ imagePoint }, undistortedPoints, cameraMatrix, distCoeffs, cv::noArray(), cameraMatrix);
+
 	// Form homogenous image point
-	cv::Point3d imagePointH(imagePoint.x, imagePoint.y, 1);
+	cv::Point3d imagePointH(undistortedPoints[0].x, undistortedPoints[0].y, 1);
 
 	// Compute left and right components of equation
 	cv::Mat leftMatrix = rotationMatrix.inv() * cameraMatrix.inv() * cv::Mat(imagePointH, false);
@@ -709,14 +1111,166 @@ cv::Point Vision::projectWorldPoint(const cv::Point3d& worldPoint) const
     if (!calibrated)
         return cv::Point(0, 0);
 
-	// Compute homogenous image point
-	cv::Mat imagePointMat = cameraMatrix * (rotationMatrix * cv::Mat(worldPoint, false) + translationVector);
+	// Project world point with the lens distortion applied
+	std::vector<cv::Point2d> imagePoints;
+	cv::projectPoints(std::vector<cv::Point3d>{ worldPoint }, rotationVector, translationVector, cameraMatrix, distCoeffs, imagePoints);
+
+	return imagePoints[0];
+}
+
+PlacementVerification Vision::verifyPlacement(const cv::Mat& image, const CubePose& expectedPose, double positionTolerance,
+    double rotationTolerance) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    PlacementVerification verification;
+
+    // The destination can only be located in the image once calibrated
+    if (!calibrated || image.empty())
+    {
+        verification.duration = timer.nsecsElapsed() / 1e6;
+        return verification;
+    }
+
+    // Bound the projection of the destination top face for any rotation and any position within the tolerance
+    int height = round(expectedPose.position.z);
+    double radius = CUBE_LENGTH / sqrt(2.0) + positionTolerance;
+    cv::Point3d windowMin(expectedPose.position.x - radius, expectedPose.position.y - radius, -height);
+    cv::Point3d windowMax(expectedPose.position.x + radius, expectedPose.position.y + radius, -height);
+    cv::Rect window = projectWorldBox(windowMin, windowMax) & cv::Rect(cv::Point(0, 0), image.size());
+    if (window.area() <= 0)
+    {
+        verification.duration = timer.nsecsElapsed() / 1e6;
+        return verification;
+    }
+
+    // Apply the grayscale, blur, threshold and contour stages to the window only
+    cv::Mat windowImage;
+    cv::cvtColor(image(window), windowImage, cv::COLOR_BGR2GRAY);
+    cv::blur(windowImage, windowImage, cv::Size(parameters.blurSize + 1, parameters.blurSize + 1));
+    if (parameters.adaptiveThreshold)
+        cv::threshold(windowImage, windowImage, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    else
+        cv::threshold(windowImage, windowImage, parameters.threshold, 255, cv::THRESH_BINARY);
+    std::vector<std::vector<cv::Point>> windowContours;
+    cv::findContours(windowImage, windowContours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, window.tl());
+
+    // Select the contour of significant size closest to the projected destination centroid
+    cv::Point expectedCentroid = projectWorldPoint(cv::Point3d(expectedPose.position.x, expectedPose.position.y, -height));
+    int closestContour = -1;
+    double closestDist = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < windowContours.size(); ++i)
+    {
+        if (cv::contourArea(windowContours[i]) <= parameters.areaThreshold)
+            continue;
+
+        cv::Point centroid = getCentroid(windowContours[i]);
+        double dist = sqrt(pow(centroid.x - expectedCentroid.x, 2) + pow(centroid.y - expectedCentroid.y, 2));
+        if (dist < closestDist)
+        {
+            closestDist = dist;
+            closestContour = i;
+        }
+    }
+
+    // The cube is not near its destination if no top face was found in the window
+    if (closestContour < 0)
+    {
+        verification.status = PlacementStatus::MISPLACED;
+        verification.duration = timer.nsecsElapsed() / 1e6;
+        return verification;
+    }
+
+    // A contour that reaches the edge of the window is merged with the top faces of neighbouring cubes
+    CubeContour cube;
+    cube.contour = windowContours[closestContour];
+    cube.centroid = getCentroid(cube.contour);
+    cv::Rect contourRegion = cv::boundingRect(cube.contour);
+    bool clipped = contourRegion.x <= window.x || contourRegion.y <= window.y
+        || contourRegion.br().x >= window.br().x || contourRegion.br().y >= window.br().y;
+    if (!clipped)
+        cube.corners = findSquareCorners(cube.contour);
+
+    if (cube.corners.size() != 4)
+    {
+        verification.duration = timer.nsecsElapsed() / 1e6;
+        return verification;
+    }
+
+    // Compare the estimated pose to the destination
+    verification.pose = estimateCubePose(cube, height);
+    verification.positionError = sqrt(pow(verification.pose.position.x - expectedPose.position.x, 2)
+        + pow(verification.pose.position.y - expectedPose.position.y, 2));
+    verification.rotationError = std::abs(std::remainder(verification.pose.rotation - expectedPose.rotation, M_PI / 2));
+    verification.status = verification.positionError <= positionTolerance && verification.rotationError <= rotationTolerance ?
+        PlacementStatus::VERIFIED : PlacementStatus::MISPLACED;
+    verification.duration = timer.nsecsElapsed() / 1e6;
+
+    return verification;
+}
+
+cv::Rect Vision::projectWorldBox(const cv::Point3d& min, const cv::Point3d& max) const
+{
+    // Bound the projections of the box corners
+    std::vector<cv::Point> imagePoints;
+    for (int i = 0; i < 8; ++i)
+    {
+        cv::Point3d corner(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        imagePoints.push_back(projectWorldPoint(corner));
+    }
+
+    return cv::boundingRect(imagePoints);
+}
+
+std::vector<cv::Point> Vision::projectWorldPolygon(const cv::Point3d& min, const cv::Point3d& max) const
+{
+    // Project the box corners and take their convex hull since the projection of a box is convex
+    std::vector<cv::Point> imagePoints;
+    for (int i = 0; i < 8; ++i)
+    {
+        cv::Point3d corner(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        imagePoints.push_back(projectWorldPoint(corner));
+    }
+
+    std::vector<cv::Point> polygon;
+    cv::convexHull(imagePoints, polygon);
+    return polygon;
+}
+
+std::vector<cv::Point> Vision::getRegionOfInterest() const
+{
+    if (!calibrated)
+        return std::vector<cv::Point>();
+
+    cv::Point3d regionMin(visionBoundBox[0], visionBoundBox[2], 0);
+    cv::Point3d regionMax(visionBoundBox[1], visionBoundBox[3], 0);
+    return projectWorldPolygon(regionMin, regionMax);
+}
+
+std::vector<std::vector<cv::Point>> Vision::getRobotOccludedRegions(const cv::Point3d& endEffectorPosition) const
+{
+    std::vector<std::vector<cv::Point>> regions;
+    if (!calibrated)
+        return regions;
+
+    // End-effector column from the end-effector up to the top of the carriage
+    // Heights are negative z coordinates in the world frame
+    cv::Point3d columnMin(endEffectorPosition.x - END_EFFECTOR_HALF_WIDTH, endEffectorPosition.y - END_EFFECTOR_HALF_WIDTH, -(GANTRY_HEIGHT + GANTRY_DEPTH));
+    cv::Point3d columnMax(endEffectorPosition.x + END_EFFECTOR_HALF_WIDTH, endEffectorPosition.y + END_EFFECTOR_HALF_WIDTH, endEffectorPosition.z);
+    regions.push_back(projectWorldPolygon(columnMin, columnMax));
 
-	// Normalize image point
-	double s = imagePointMat.at<double>(2);
-	cv::Point2d imagePoint = cv::Point2d(imagePointMat.at<double>(0) / s, imagePointMat.at<double>(1) / s);
+    // Gantry beam centred on the x-axis travel at the y position of the end-effector
+    double overhang = (GANTRY_LENGTH - (RobotLimits::X_MAX - RobotLimits::X_MIN)) / 2;
+    cv::Point3d gantryMin(RobotLimits::X_MIN - overhang, endEffectorPosition.y - GANTRY_HALF_WIDTH, -(GANTRY_HEIGHT + GANTRY_DEPTH));
+    cv::Point3d gantryMax(RobotLimits::X_MAX + overhang, endEffectorPosition.y + GANTRY_HALF_WIDTH, -GANTRY_HEIGHT);
+    regions.push_back(projectWorldPolygon(gantryMin, gantryMax));
 
-	return imagePoint;
+    return regions;
+}
+
+void Vision::setOccludedRegions(const std::vector<std::vector<cv::Point>>& regions)
+{
+    occludedRegions = regions;
 }
 
 double Vision::computeEuclidDist(const cv::Point3i& pointA, const cv::Point3i& pointB) const
@@ -751,32 +1305,160 @@ std::vector<cv::Mat> Vision::getAnnotatedFiducialImages() const
 
 std::vector<cv::Point3i> Vision::getCubeCentroids(const int z) const
 {
-    // Compile list of cube centroids from the cube contour list for a given plane in the world frame
+    // Compile list of cube centroids from the cube poses for a given plane in the world frame
     std::vector<cv::Point3i> centroids;
-    for (int i = 0; i < cubeContours.size(); ++i)
-    {
-        // Project centroid to the world frame and add to centroid list
-        cv::Point3i worldCentroid = projectImagePoint(cubeContours[i].centroid, -z);
-        worldCentroid.z = -worldCentroid.z;
-        centroids.push_back(worldCentroid);
-    }
+    for (const CubePose& pose : getCubePoses(z))
+        centroids.push_back(cv::Point3i(round(pose.position.x), round(pose.position.y), z));
 
     return centroids;
 }
 
-std::vector<float> Vision::getCubeRotations(const int z) const
+std::vector<CubePose> Vision::getCubePoses(const int z) const
 {
-    // Compile list of cube centroids from the cube contour list for a given plane in the world frame
-    std::vector<float> rotations;
+    // Poses can only be estimated in the world frame if the system is calibrated
+    if (!calibrated)
+        return std::vector<CubePose>();
+
+    // Use the cached poses if available
+    if (cubePoses.contains(z))
+        return cubePoses.value(z);
+
+    // Estimate the pose of each independent cube
+    std::vector<CubePose> poses;
     for (int i = 0; i < cubeContours.size(); ++i)
+        poses.push_back(estimateCubePose(cubeContours[i], z));
+
+    cubePoses.insert(z, poses);
+
+    return poses;
+}
+
+std::vector<CubePose> Vision::getLayeredCubePoses() const
+{
+    // Use the cached poses if available
+    if (layeredCubePosesValid)
+        return layeredCubePoses;
+
+    std::vector<std::vector<CubePose>> layerPoses;
+    for (int layer = 1; layer <= MAX_LAYERS; ++layer)
+        layerPoses.push_back(getCubePoses(layer * CUBE_LENGTH));
+
+    // Select the lowest layer whose residual is within the margin of the smallest residual for each cube
+    // The residuals of adjacent layers differ by less than the corner noise when the top face is seen from above, so
+    // a higher layer is only selected when it fits clearly better since most independent cubes lie on the base layer
+    std::vector<CubePose> poses = layerPoses[0];
+    for (int i = 0; i < poses.size(); ++i)
     {
-        // Get contour
-        CubeContour c = cubeContours[i];
+        double minResidual = poses[i].residual;
+        for (int layer = 1; layer < MAX_LAYERS; ++layer)
+            minResidual = std::min(minResidual, layerPoses[layer][i].residual);
 
-        // Compute cube rotation and add to the roatations list
-        float angle = computeCubeZRotation(c.corners, c.centroid, -z);
-        rotations.push_back(angle);
+        for (int layer = 0; layer < MAX_LAYERS; ++layer)
+        {
+            if (layerPoses[layer][i].residual <= minResidual + LAYER_RESIDUAL_MARGIN)
+            {
+                poses[i] = layerPoses[layer][i];
+                break;
+            }
+        }
     }
 
+    layeredCubePoses = poses;
+    layeredCubePosesValid = calibrated;
+
+    return poses;
+}
+
+std::vector<float> Vision::getCubeRotations(const int z) const
+{
+    // Compile list of cube rotations from the cube poses for a given plane in the world frame
+    std::vector<float> rotations;
+    for (const CubePose& pose : getCubePoses(z))
+        rotations.push_back(pose.rotation);
+
     return rotations;
+}
+
+cv::Mat Vision::getCameraMatrix() const
+{
+    return cameraMatrix;
+}
+
+cv::Mat Vision::getDistCoeffs() const
+{
+    return distCoeffs;
+}
+
+void Vision::setIntrinsics(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs)
+{
+    cameraMatrix.copyTo(this->cameraMatrix);
+    distCoeffs.copyTo(this->distCoeffs);
+
+    // Cached homographies depend on the intrinsic parameters
+    layerHomographies.clear();
+
+    // Undistortion maps are recomputed for the new intrinsic parameters when the next scene is processed
+    undistortMap.release();
+
+    // Fiducials are isolated with the undistortion maps so the fiducial and calibration stages must run again
+    fiducialKey = 0;
+    calibrationKey = 0;
+
+    // Extrinsic parameters computed with the previous intrinsic parameters are no longer valid
+    calibrated = false;
+    calibrationGeneration++;
+}
+
+cv::Point3d Vision::getCameraPosition() const
+{
+    if (!calibrated)
+        return cv::Point3d(0, 0, 0);
+
+    // The camera centre is the point in the world frame that maps to the camera frame origin
+    cv::Mat position = -rotationMatrix.t() * translationVector;
+    return cv::Point3d(position.at<double>(0), position.at<double>(1), position.at<double>(2));
+}
+
+QMap<int, cv::Point3i> Vision::getFiducialWorldPoints() const
+{
+    return fiducialWorldPoints;
+}
+
+std::vector<int> Vision::getFiducialIds() const
+{
+    std::vector<int> ids;
+    for (int i = 0; i < fiducialContours.size(); ++i)
+        ids.push_back(fiducialContours[i].id);
+
+    return ids;
+}
+
+bool Vision::isCalibrated() const
+{
+    return calibrated;
+}
+
+VisionTimings Vision::getStageTimings() const
+{
+    return timings;
+}
+
+SceneQuality Vision::getSceneQuality() const
+{
+    SceneQuality quality;
+    quality.fiducialCount = calibrationFiducials;
+    quality.reprojectionError = calibrated ? reprojectionError : std::numeric_limits<double>::infinity();
+    for (const FiducialContour& fiducial : fiducialContours)
+        quality.fiducialConfidences.push_back(fiducial.confidence);
+
+    // Cube measures require the cube contours to be classified in the world frame
+    if (!calibrated)
+        return quality;
+
+    for (const CubePose& pose : getLayeredCubePoses())
+        quality.cubeResiduals.push_back(pose.residual);
+    for (const CubeContour& cube : cubeContours)
+        quality.cubeShapeScores.push_back(cube.shapeScore);
+
+    return quality;
 }
\ No newline at end of file
@@ -0,0 +1,403 @@
+#include "VisionBenchmark.h"
+#include "SessionPlayer.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+/*!
+* Image buffer allocator that counts the buffers allocated by OpenCV. The allocator is only installed for the duration
+* of a benchmark run, so the rest of the application allocates as usual. Allocation is delegated to the standard OpenCV
+* allocator, which also takes ownership of deallocating the buffers.
+*/
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+	cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, cv::AccessFlag flags,
+		cv::UMatUsageFlags usageFlags) const override
+	{
+		++count;
+		return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+	}
+
+	bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override
+	{
+		return cv::Mat::getStdAllocator()->allocate(data, accessFlags, usageFlags);
+	}
+
+	void deallocate(cv::UMatData* data) const override
+	{
+		cv::Mat::getStdAllocator()->deallocate(data);
+	}
+
+	mutable std::atomic<qint64> count { 0 }; /*! Number of image buffers allocated */
+};
+
+static CountingMatAllocator matAllocator;
+
+// Names of the processing stages reported by the benchmark
+const QStringList stageNames = { "blur", "threshold", "contours", "fiducials", "calibration", "classification", "total" };
+
+VisionBenchmark::VisionBenchmark(QObject* parent) : QObject(parent)
+{
+
+}
+
+void VisionBenchmark::setIterations(int iterations)
+{
+	this->iterations = std::max(1, iterations);
+}
+
+void VisionBenchmark::setMatchDistance(double distance)
+{
+	matchDistance = distance;
+}
+
+void VisionBenchmark::reset()
+{
+	inputFiles.clear();
+	frameCount = 0;
+	failedFrames = 0;
+	processingTime = 0;
+	stageLatencies.clear();
+	matAllocations.clear();
+
+	calibrationFrames = 0;
+	calibratedFrames = 0;
+	reprojectionErrors.clear();
+	truthFrames = 0;
+	truePositives = 0;
+	falsePositives = 0;
+	falseNegatives = 0;
+	positionErrors.clear();
+	rotationErrors.clear();
+	truthFiducials = 0;
+	foundFiducials = 0;
+	falseFiducials = 0;
+}
+
+bool VisionBenchmark::run(const QString& inputPath)
+{
+	reset();
+
+	// Compile list of input files
+	QFileInfo inputInfo(inputPath);
+	if (inputInfo.isDir())
+	{
+		QDir inputDir(inputPath);
+		QStringList filters = { "*.session", "*.png", "*.jpg", "*.jpeg", "*.bmp" };
+		for (const QString& fileName : inputDir.entryList(filters, QDir::Files, QDir::Name))
+			inputFiles.append(inputDir.filePath(fileName));
+	}
+	else if (inputInfo.exists())
+		inputFiles.append(inputPath);
+
+	if (inputFiles.isEmpty())
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Vision Benchmark", "No session or image files found at " + inputPath));
+		return false;
+	}
+
+	// Count image buffer allocations for the duration of the run
+	cv::MatAllocator* defaultAllocator = cv::Mat::getDefaultAllocator();
+	cv::Mat::setDefaultAllocator(&matAllocator);
+
+	for (const QString& fileName : inputFiles)
+	{
+		if (fileName.endsWith(".session", Qt::CaseInsensitive))
+		{
+			processSession(fileName);
+			continue;
+		}
+
+		// Process image file as a calibration frame
+		SessionFrame frame;
+		frame.image = cv::imread(fileName.toStdString(), cv::IMREAD_COLOR);
+		frame.calibrate = true;
+		if (frame.image.empty())
+		{
+			emit log(Message(MessageType::WARNING_LOG, "Vision Benchmark", "Failed to read image " + fileName));
+			++failedFrames;
+			continue;
+		}
+
+		Vision vision;
+		connect(&vision, &Vision::log, this, &VisionBenchmark::log);
+		processFrame(vision, frame);
+	}
+
+	cv::Mat::setDefaultAllocator(defaultAllocator);
+
+	emit log(Message(MessageType::INFO_LOG, "Vision Benchmark", "Processed " + QString::number(frameCount) + " frames from "
+		+ QString::number(inputFiles.size()) + " files"));
+	return frameCount > 0;
+}
+
+void VisionBenchmark::processSession(const QString& fileName)
+{
+	SessionPlayer player;
+	connect(&player, &SessionPlayer::log, this, &VisionBenchmark::log);
+	if (!player.openSession(fileName))
+	{
+		++failedFrames;
+		return;
+	}
+
+	// Each session is processed by a new computer vision system so that calibration does not carry over between sessions
+	Vision vision;
+	connect(&vision, &Vision::log, this, &VisionBenchmark::log);
+
+	SessionFrame frame;
+	for (int i = 0; i < player.getFrameCount(); ++i)
+	{
+		if (!player.readFrame(i, frame) || frame.image.empty())
+		{
+			emit log(Message(MessageType::WARNING_LOG, "Vision Benchmark", "Failed to read frame " + QString::number(i) + " of " + fileName));
+			++failedFrames;
+			continue;
+		}
+
+		processFrame(vision, frame);
+	}
+}
+
+void VisionBenchmark::processFrame(Vision& vision, SessionFrame& frame)
+{
+	std::vector<cv::Point3i>* sourceCentroids = frame.hasSourceCentroids ? &frame.sourceCentroids : Q_NULLPTR;
+	std::vector<cv::Point3i>* structCentroids = frame.hasStructCentroids ? &frame.structCentroids : Q_NULLPTR;
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		// Process scene while counting image buffer allocations
+		qint64 matStart = matAllocator.count;
+		QElapsedTimer timer;
+		timer.start();
+
+		vision.processScene(frame.image, frame.calibrate, sourceCentroids, structCentroids);
+
+		processingTime += timer.nsecsElapsed() / 1e6;
+		matAllocations.push_back((double) (matAllocator.count - matStart));
+
+		// Record stage latencies
+		VisionTimings timings = vision.getStageTimings();
+		stageLatencies["blur"].push_back(timings.blur);
+		stageLatencies["threshold"].push_back(timings.threshold);
+		stageLatencies["contours"].push_back(timings.contours);
+		stageLatencies["fiducials"].push_back(timings.fiducials);
+		stageLatencies["calibration"].push_back(timings.calibration);
+		stageLatencies["classification"].push_back(timings.classification);
+		stageLatencies["total"].push_back(timings.total);
+	}
+
+	// Accuracy is only evaluated once per frame since repeated processing produces identical results
+	++frameCount;
+	if (frame.calibrate)
+	{
+		++calibrationFrames;
+		if (vision.isCalibrated())
+		{
+			++calibratedFrames;
+			reprojectionErrors.push_back(vision.getSceneQuality().reprojectionError);
+		}
+	}
+
+	if (frame.hasGroundTruth)
+		evaluateAccuracy(vision, frame);
+}
+
+void VisionBenchmark::evaluateAccuracy(const Vision& vision, const SessionFrame& frame)
+{
+	++truthFrames;
+
+	// Compare identified fiducials to the ground truth fiducials
+	std::vector<int> fiducialIds = vision.getFiducialIds();
+	for (int id : frame.truthFiducialIds)
+	{
+		++truthFiducials;
+		if (std::find(fiducialIds.begin(), fiducialIds.end(), id) != fiducialIds.end())
+			++foundFiducials;
+	}
+
+	for (int id : fiducialIds)
+	{
+		if (std::find(frame.truthFiducialIds.begin(), frame.truthFiducialIds.end(), id) == frame.truthFiducialIds.end())
+			++falseFiducials;
+	}
+
+	// Cube detections can only be evaluated in the world frame if the system is calibrated
+	int truthCount = (int) frame.truthCubeCentroids.size();
+	if (!vision.isCalibrated())
+	{
+		falseNegatives += truthCount;
+		return;
+	}
+
+	// Project the detected cubes onto the top face plane of each ground truth cube and find all candidate matches
+	struct CubeMatch
+	{
+		int truthIndex;
+		int detectedIndex;
+		double distance;
+	};
+
+	std::vector<CubeMatch> candidates;
+	QMap<int, std::vector<cv::Point3i>> detectedCentroids;
+	QMap<int, std::vector<float>> detectedRotations;
+	int detectedCount = (int) vision.getCubeCentroids(0).size();
+	for (int i = 0; i < truthCount; ++i)
+	{
+		const cv::Point3i& truthCentroid = frame.truthCubeCentroids[i];
+		if (!detectedCentroids.contains(truthCentroid.z))
+		{
+			detectedCentroids.insert(truthCentroid.z, vision.getCubeCentroids(truthCentroid.z));
+			detectedRotations.insert(truthCentroid.z, vision.getCubeRotations(truthCentroid.z));
+		}
+
+		const std::vector<cv::Point3i>& centroids = detectedCentroids[truthCentroid.z];
+		for (int j = 0; j < centroids.size(); ++j)
+		{
+			double distance = std::hypot(centroids[j].x - truthCentroid.x, centroids[j].y - truthCentroid.y);
+			if (distance <= matchDistance)
+			{
+				CubeMatch match;
+				match.truthIndex = i;
+				match.detectedIndex = j;
+				match.distance = distance;
+				candidates.push_back(match);
+			}
+		}
+	}
+
+	// Greedily accept the closest matches so that each cube is matched at most once
+	std::sort(candidates.begin(), candidates.end(), [](const CubeMatch& a, const CubeMatch& b) { return a.distance < b.distance; });
+	std::vector<bool> truthMatched(truthCount, false);
+	std::vector<bool> detectedMatched(detectedCount, false);
+	int matches = 0;
+	for (const CubeMatch& match : candidates)
+	{
+		if (truthMatched[match.truthIndex] || detectedMatched[match.detectedIndex])
+			continue;
+
+		truthMatched[match.truthIndex] = true;
+		detectedMatched[match.detectedIndex] = true;
+		++matches;
+
+		// Cube rotations are only defined up to a quarter turn
+		int z = frame.truthCubeCentroids[match.truthIndex].z;
+		double rotationError = detectedRotations[z][match.detectedIndex] - frame.truthCubeRotations[match.truthIndex];
+		rotationError = std::remainder(rotationError, CV_PI / 2);
+
+		positionErrors.push_back(match.distance);
+		rotationErrors.push_back(std::abs(rotationError) * 180 / CV_PI);
+	}
+
+	truePositives += matches;
+	falsePositives += detectedCount - matches;
+	falseNegatives += truthCount - matches;
+}
+
+QJsonObject VisionBenchmark::summarize(std::vector<double> samples)
+{
+	QJsonObject summary;
+	summary["count"] = (int) samples.size();
+	if (samples.empty())
+		return summary;
+
+	// Percentiles use the nearest rank method
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&samples](double p) {
+		int rank = (int) std::ceil(p / 100 * samples.size());
+		return samples[std::max(0, rank - 1)];
+	};
+
+	double sum = 0;
+	for (double sample : samples)
+		sum += sample;
+
+	summary["mean"] = sum / samples.size();
+	summary["p50"] = percentile(50);
+	summary["p95"] = percentile(95);
+	summary["p99"] = percentile(99);
+	summary["max"] = samples.back();
+
+	return summary;
+}
+
+QJsonObject VisionBenchmark::getResults() const
+{
+	QJsonObject results;
+
+	// Describe the benchmark run
+	results["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+	results["opencvVersion"] = CV_VERSION;
+	results["qtVersion"] = qVersion();
+	results["files"] = QJsonArray::fromStringList(inputFiles);
+	results["frames"] = frameCount;
+	results["failedFrames"] = failedFrames;
+	results["iterations"] = iterations;
+
+	// Throughput is based on the time spent processing scenes and excludes the time spent decoding frames
+	int sceneCount = frameCount * iterations;
+	results["processingTimeMs"] = processingTime;
+	results["throughputFps"] = processingTime > 0 ? sceneCount * 1000 / processingTime : 0;
+
+	QJsonObject stages;
+	for (const QString& stage : stageNames)
+		stages[stage] = summarize(stageLatencies.value(stage));
+	results["stageLatencyMs"] = stages;
+
+	QJsonObject allocations;
+	allocations["image"] = summarize(matAllocations);
+	results["allocationsPerFrame"] = allocations;
+
+	// Detection accuracy
+	QJsonObject accuracy;
+	accuracy["calibrationFrames"] = calibrationFrames;
+	accuracy["calibrationRate"] = calibrationFrames > 0 ? (double) calibratedFrames / calibrationFrames : 0;
+	accuracy["reprojectionErrorPx"] = summarize(reprojectionErrors);
+	accuracy["groundTruthFrames"] = truthFrames;
+	accuracy["matchDistance"] = matchDistance;
+
+	QJsonObject cubes;
+	cubes["truePositives"] = truePositives;
+	cubes["falsePositives"] = falsePositives;
+	cubes["falseNegatives"] = falseNegatives;
+	cubes["precision"] = truePositives + falsePositives > 0 ? (double) truePositives / (truePositives + falsePositives) : 0;
+	cubes["recall"] = truePositives + falseNegatives > 0 ? (double) truePositives / (truePositives + falseNegatives) : 0;
+	cubes["positionError"] = summarize(positionErrors);
+	cubes["rotationErrorDeg"] = summarize(rotationErrors);
+	accuracy["cubes"] = cubes;
+
+	QJsonObject fiducials;
+	fiducials["expected"] = truthFiducials;
+	fiducials["identified"] = foundFiducials;
+	fiducials["falseIdentifications"] = falseFiducials;
+	fiducials["recall"] = truthFiducials > 0 ? (double) foundFiducials / truthFiducials : 0;
+	accuracy["fiducials"] = fiducials;
+
+	results["accuracy"] = accuracy;
+
+	return results;
+}
+
+bool VisionBenchmark::writeResults(const QString& fileName) const
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		emit log(Message(MessageType::ERROR_LOG, "Vision Benchmark", "Failed to create results file: " + file.errorString()));
+		return false;
+	}
+
+	file.write(QJsonDocument(getResults()).toJson(QJsonDocument::Indented));
+	file.close();
+
+	emit log(Message(MessageType::INFO_LOG, "Vision Benchmark", "Results written to " + fileName));
+	return true;
+}
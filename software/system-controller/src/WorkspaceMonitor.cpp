@@ -0,0 +1,141 @@
+#include "WorkspaceMonitor.h"
+#include <QMutexLocker>
+
+WorkspaceMonitor::WorkspaceMonitor(QObject* parent) : QObject(parent)
+{
+
+}
+
+void WorkspaceMonitor::setReference(const cv::Mat& image, const std::vector<cv::Rect>& regions)
+{
+	// Compute reference patches outside the lock so that the capture thread is not blocked
+	std::vector<MonitoredRegion> monitoredRegions;
+	cv::Rect imageRegion(cv::Point(0, 0), image.size());
+	for (const cv::Rect& region : regions)
+	{
+		MonitoredRegion monitoredRegion;
+		monitoredRegion.region = region & imageRegion;
+		monitoredRegion.changedChecks = 0;
+		monitoredRegion.reported = false;
+		if (monitoredRegion.region.width >= DOWNSAMPLE && monitoredRegion.region.height >= DOWNSAMPLE)
+			monitoredRegion.reference = getPatch(image, monitoredRegion.region);
+		monitoredRegions.push_back(monitoredRegion);
+	}
+
+	{
+		QMutexLocker locker(&mutex);
+		this->regions = monitoredRegions;
+		lastCheck = -1;
+	}
+
+	emit log(Message(MessageType::INFO_LOG, "Workspace Monitor", "Reference set for " + QString::number((int) monitoredRegions.size())
+		+ " monitored regions"));
+}
+
+void WorkspaceMonitor::clearReference()
+{
+	bool monitoring;
+	{
+		QMutexLocker locker(&mutex);
+		monitoring = !regions.empty();
+		regions.clear();
+	}
+
+	// Only report the reset of a reference that was being monitored
+	if (monitoring)
+		emit log(Message(MessageType::INFO_LOG, "Workspace Monitor", "Reference cleared, monitoring stopped"));
+}
+
+void WorkspaceMonitor::setOccludedRegions(const std::vector<cv::Rect>& regions)
+{
+	QMutexLocker locker(&mutex);
+	occludedRegions = regions;
+
+	// Changes observed while a region was occluded are not evidence of a disturbance
+	for (MonitoredRegion& monitoredRegion : this->regions)
+	{
+		for (const cv::Rect& occludedRegion : occludedRegions)
+		{
+			if ((monitoredRegion.region & occludedRegion).area() > 0)
+				monitoredRegion.changedChecks = 0;
+		}
+	}
+}
+
+void WorkspaceMonitor::setCheckInterval(int interval)
+{
+	QMutexLocker locker(&mutex);
+	checkInterval = interval;
+}
+
+void WorkspaceMonitor::setChangeThreshold(double threshold)
+{
+	QMutexLocker locker(&mutex);
+	changeThreshold = threshold;
+}
+
+void WorkspaceMonitor::processFrame(const cv::Mat& frame, qint64 timestamp)
+{
+	QMutexLocker locker(&mutex);
+
+	// Limit the check rate
+	if (regions.empty() || frame.empty() || (lastCheck >= 0 && timestamp - lastCheck < checkInterval))
+		return;
+	lastCheck = timestamp;
+
+	cv::Rect imageRegion(cv::Point(0, 0), frame.size());
+	for (int i = 0; i < regions.size(); ++i)
+	{
+		MonitoredRegion& monitoredRegion = regions[i];
+		if (monitoredRegion.reported || monitoredRegion.reference.empty() || (monitoredRegion.region & imageRegion) != monitoredRegion.region)
+			continue;
+
+		// Skip regions that overlap an occluded region
+		bool occluded = false;
+		for (const cv::Rect& occludedRegion : occludedRegions)
+			occluded = occluded || (monitoredRegion.region & occludedRegion).area() > 0;
+
+		if (occluded)
+		{
+			monitoredRegion.changedChecks = 0;
+			continue;
+		}
+
+		// Compare the region to its reference
+		cv::Mat patch = getPatch(frame, monitoredRegion.region);
+		cv::Mat difference;
+		cv::absdiff(patch, monitoredRegion.reference, difference);
+		double change = cv::mean(difference)[0];
+
+		if (change < changeThreshold)
+		{
+			monitoredRegion.changedChecks = 0;
+			continue;
+		}
+
+		// Report the disturbance once the change has been confirmed
+		monitoredRegion.changedChecks++;
+		if (monitoredRegion.changedChecks >= CONFIRM_CHECKS)
+		{
+			monitoredRegion.reported = true;
+			emit log(Message(MessageType::WARNING_LOG, "Workspace Monitor", "Region " + QString::number(i) + " changed by "
+				+ QString::number(change, 'f', 1) + " intensity levels from its reference"));
+			emit disturbanceDetected(i);
+		}
+	}
+}
+
+cv::Mat WorkspaceMonitor::getPatch(const cv::Mat& image, const cv::Rect& region) const
+{
+	// Downsample region and convert to grayscale
+	cv::Mat patch;
+	cv::resize(image(region), patch, cv::Size(region.width / DOWNSAMPLE, region.height / DOWNSAMPLE), 0, 0, cv::INTER_AREA);
+	if (patch.channels() == 3)
+		cv::cvtColor(patch, patch, cv::COLOR_BGR2GRAY);
+
+	// Remove the mean intensity so that global changes in illumination are ignored
+	cv::Mat normalizedPatch;
+	patch.convertTo(normalizedPatch, CV_32F, 1, -cv::mean(patch)[0]);
+
+	return normalizedPatch;
+}
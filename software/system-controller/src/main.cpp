@@ -1,11 +1,85 @@
 #include "SystemController.h"
+#include "SceneRenderer.h"
+#include "VisionBenchmark.h"
 #include <QtWidgets/QApplication>
+#include <QCoreApplication>
+#include <iostream>
+
+/*!
+* Print a logged message to the console for the command line tools.
+*/
+void printMessage(Message message)
+{
+    std::cout << message.source.toStdString() << ": " << message.content.toStdString() << std::endl;
+}
+
+/*!
+* Render a synthetic vision session from the command line arguments:
+* --render <model.cubeworld> <output.session> [frames] [independent cubes] [seed]
+*/
+int renderScenes(const QStringList& arguments, int renderArgument)
+{
+    if (renderArgument + 2 >= arguments.size())
+    {
+        std::cout << "Usage: --render <model.cubeworld> <output.session> [frames] [independent cubes] [seed]" << std::endl;
+        return 1;
+    }
+
+    int frameCount = renderArgument + 3 < arguments.size() ? arguments[renderArgument + 3].toInt() : 100;
+    int independentCubes = renderArgument + 4 < arguments.size() ? arguments[renderArgument + 4].toInt() : 5;
+    unsigned int seed = renderArgument + 5 < arguments.size() ? arguments[renderArgument + 5].toUInt() : 0;
+
+    SceneRenderer renderer;
+    QObject::connect(&renderer, &SceneRenderer::log, printMessage);
+    bool rendered = renderer.renderSession(arguments[renderArgument + 1], arguments[renderArgument + 2], frameCount, independentCubes, seed);
+
+    return rendered ? 0 : 1;
+}
+
+/*!
+* Benchmark the computer vision system from the command line arguments:
+* --benchmark <input session, image or directory> <output.json> [iterations]
+*/
+int benchmarkVision(const QStringList& arguments, int benchmarkArgument)
+{
+    if (benchmarkArgument + 2 >= arguments.size())
+    {
+        std::cout << "Usage: --benchmark <input session, image or directory> <output.json> [iterations]" << std::endl;
+        return 1;
+    }
+
+    VisionBenchmark benchmark;
+    QObject::connect(&benchmark, &VisionBenchmark::log, printMessage);
+    if (benchmarkArgument + 3 < arguments.size())
+        benchmark.setIterations(arguments[benchmarkArgument + 3].toInt());
+
+    if (!benchmark.run(arguments[benchmarkArgument + 1]))
+        return 1;
+
+    return benchmark.writeResults(arguments[benchmarkArgument + 2]) ? 0 : 1;
+}
 
 int main(int argc, char *argv[])
 {
+    // Run the benchmark with a core application so that it does not require a display
+    for (int i = 1; i < argc; ++i)
+    {
+        if (QString(argv[i]) == "--benchmark")
+        {
+            QCoreApplication app(argc, argv);
+            return benchmarkVision(app.arguments(), i);
+        }
+    }
+
     // Initialize application
     QApplication app(argc, argv);
 
+    // Run command line tools without initializing the user interface
+    QStringList arguments = app.arguments();
+    int renderArgument = arguments.indexOf("--render");
+    if (renderArgument >= 0)
+        return renderScenes(arguments, renderArgument);
+
     // Initialize OpenGL context
     QSurfaceFormat format;
     format.setDepthBufferSize(24);